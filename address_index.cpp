@@ -0,0 +1,426 @@
+#include "address_index.h"
+#include "crypto_kernels.h"
+#include "wallet_generator.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[4] = {'W', 'G', 'I', 'X'};
+const uint8_t kVersion = 1;
+const size_t kHeaderSize = 64;
+const size_t kRecordSize = 32;
+
+// Chunk layout, as IndexSweep writes it
+const char* const kChunkMagic = "#walletgen-chunk 1";
+const char* const kChunkColumns = "#columns index network path address private_key wif public_key";
+const char* const kChunkEnd = "#end records=";
+
+uint32_t readLe32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 |
+           static_cast<uint32_t>(p[3]) << 24;
+}
+
+uint64_t readLe64(const uint8_t* p) {
+    return readLe32(p) | static_cast<uint64_t>(readLe32(p + 4)) << 32;
+}
+
+void appendLe(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+bool decodeHex(const std::string& hex, uint8_t* out, size_t len) {
+    return hex.size() == 2 * len && kernels().hexDecode(hex.data(), len, out);
+}
+
+// The address hash of an uncompressed public key, as encodeWallet derives it
+void hashPublicKey(const NetworkConfig& config, const uint8_t pubkey[65], uint8_t hash[20]) {
+    const KernelTable& k = kernels();
+    uint8_t digest[32];
+    if (config.use_keccak) {
+        k.sha3_256(pubkey + 1, 64, digest);
+        std::memcpy(hash, digest + 12, 20);
+        return;
+    }
+    uint8_t compressed[33];
+    compressed[0] = (pubkey[64] & 1) ? 0x03 : 0x02;
+    std::memcpy(compressed + 1, pubkey + 1, 32);
+    k.sha256(compressed, sizeof(compressed), digest);
+    k.ripemd160(digest, sizeof(digest), hash);
+}
+
+// The address text for a hash, byte for byte as encodeWallet writes it
+std::string encodeAddress(const NetworkConfig& config, const uint8_t hash[20]) {
+    const KernelTable& k = kernels();
+    if (config.use_keccak) {
+        std::string address(42, '\0');
+        address[0] = '0';
+        address[1] = 'x';
+        k.hexEncode(hash, 20, &address[2]);
+        return address;
+    }
+    uint8_t payload[25];
+    uint8_t digest[32];
+    payload[0] = config.address_version;
+    std::memcpy(payload + 1, hash, 20);
+    k.sha256(payload, 21, digest);
+    k.sha256(digest, sizeof(digest), digest);
+    std::memcpy(payload + 21, digest, 4);
+    return k.base58Encode(payload, sizeof(payload));
+}
+
+// Inverse of the generator's Base58 encoding, which treats the payload as a
+// little-endian number (see base58EncodeGeneric)
+bool decodeBase58Payload(const std::string& text, uint8_t payload[25]) {
+    static const char alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    std::memset(payload, 0, 25);
+    size_t zeros = 0;
+    while (zeros < text.size() && text[zeros] == '1') zeros++;
+    for (size_t i = zeros; i < text.size(); i++) {
+        const char* digit = std::strchr(alphabet, text[i]);
+        if (!digit || text[i] == '\0') return false;
+        unsigned carry = static_cast<unsigned>(digit - alphabet);
+        for (int b = 0; b < 25; b++) {
+            carry += payload[b] * 58u;
+            payload[b] = static_cast<uint8_t>(carry);
+            carry >>= 8;
+        }
+        if (carry) return false;
+    }
+    return true;
+}
+
+// A lookup key: the hash plus the networks its text form allows
+struct Query {
+    uint8_t hash[20];
+    bool keccak = false;
+    bool base58 = false;
+    uint8_t version = 0;
+
+    bool accepts(const NetworkConfig& config) const {
+        if (!keccak && !base58) return true;
+        if (keccak) return config.use_keccak;
+        return !config.use_keccak && config.address_version == version;
+    }
+};
+
+Query parseQuery(const std::string& address) {
+    Query query;
+    if (address.size() == 42 && address[0] == '0' && (address[1] == 'x' || address[1] == 'X') &&
+        decodeHex(address.substr(2), query.hash, 20)) {
+        query.keccak = true;
+        return query;
+    }
+    if (decodeHex(address, query.hash, 20)) return query;
+
+    // Base58: accept only text that re-encodes to itself, so the checksum
+    // and the version are both checked
+    uint8_t payload[25];
+    if (decodeBase58Payload(address, payload)) {
+        for (const auto& entry : WalletGenerator::networks) {
+            const NetworkConfig& config = entry.second;
+            if (config.use_keccak || config.address_version != payload[0]) continue;
+            if (encodeAddress(config, payload + 1) == address) {
+                query.base58 = true;
+                query.version = payload[0];
+                std::memcpy(query.hash, payload + 1, 20);
+                return query;
+            }
+        }
+    }
+    throw std::runtime_error("Not an address of a supported network: '" + address + "'");
+}
+
+// Records while building; strings are ids into Builder::strings
+struct Entry {
+    uint8_t hash[20];
+    uint32_t network;
+    uint32_t wallet;
+    uint32_t path;
+};
+
+struct Builder {
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<Entry> entries;
+
+    uint32_t intern(const std::string& text) {
+        auto it = ids.find(text);
+        if (it != ids.end()) return it->second;
+        if (strings.size() >= UINT32_MAX) throw std::runtime_error("Too many distinct strings for an address index");
+        uint32_t id = static_cast<uint32_t>(strings.size());
+        strings.push_back(text);
+        ids.emplace(text, id);
+        return id;
+    }
+
+    void add(const uint8_t* hash, const std::string& network, const std::string& wallet, const std::string& path) {
+        Entry entry;
+        std::memcpy(entry.hash, hash, 20);
+        entry.network = intern(network);
+        entry.wallet = intern(wallet);
+        entry.path = intern(path);
+        entries.push_back(entry);
+    }
+
+    // Sweep chunk: every record, checked against its public key
+    void addChunk(const std::string& file) {
+        std::ifstream in(file);
+        if (!in) throw std::runtime_error("Cannot open chunk: " + file);
+        std::string line, wallet;
+        auto expect = [&](const std::string& prefix) {
+            if (!std::getline(in, line) || line.compare(0, prefix.size(), prefix) != 0) {
+                throw std::runtime_error(file + ": not a walletgen chunk or address index");
+            }
+        };
+        expect(kChunkMagic);
+        expect("#job ");
+        size_t seed = line.find(" seed=");
+        if (seed == std::string::npos) throw std::runtime_error(file + ": chunk has no seed fingerprint");
+        wallet = line.substr(seed + 6, line.find(' ', seed + 6) - seed - 6);
+        expect("#shard ");
+        expect(kChunkColumns);
+
+        uint64_t records = 0;
+        const std::string end(kChunkEnd);
+        while (std::getline(in, line)) {
+            if (line.compare(0, end.size(), end) == 0) {
+                if (line.substr(end.size()) != std::to_string(records)) {
+                    throw std::runtime_error(file + ": end marker does not match the " + std::to_string(records) + " records read");
+                }
+                return;
+            }
+            // index network path address private_key wif public_key
+            std::vector<std::string> fields;
+            size_t start = 0;
+            for (size_t tab; (tab = line.find('\t', start)) != std::string::npos; start = tab + 1) {
+                fields.push_back(line.substr(start, tab - start));
+            }
+            fields.push_back(line.substr(start));
+            auto config = WalletGenerator::networks.find(fields.size() == 7 ? fields[1] : "");
+            uint8_t pubkey[65];
+            if (config == WalletGenerator::networks.end() || !decodeHex(fields[6], pubkey, sizeof(pubkey)) || pubkey[0] != 0x04) {
+                throw std::runtime_error(file + ": malformed record: " + line.substr(0, line.find('\t', line.find('\t') + 1)));
+            }
+            uint8_t hash[20];
+            hashPublicKey(config->second, pubkey, hash);
+            if (encodeAddress(config->second, hash) != fields[3]) {
+                throw std::runtime_error(file + ": address does not match its public key at index " + fields[0]);
+            }
+            add(hash, fields[1], wallet, fields[2]);
+            records++;
+        }
+        throw std::runtime_error(file + ": truncated chunk (no end marker after " + std::to_string(records) + " records)");
+    }
+
+    void addIndex(const std::string& file) {
+        AddressIndex index(file);
+        index.forEach([&](const uint8_t* hash, const char* network, const char* wallet, const char* path) {
+            add(hash, network, wallet, path);
+        });
+    }
+
+    // Sorted by hash, then by the strings, without duplicates
+    void sort() {
+        auto less = [&](const Entry& a, const Entry& b) {
+            int c = std::memcmp(a.hash, b.hash, 20);
+            if (c != 0) return c < 0;
+            if (a.network != b.network) return strings[a.network] < strings[b.network];
+            if (a.wallet != b.wallet) return strings[a.wallet] < strings[b.wallet];
+            return strings[a.path] < strings[b.path];
+        };
+        std::sort(entries.begin(), entries.end(), less);
+        entries.erase(std::unique(entries.begin(), entries.end(), [&](const Entry& a, const Entry& b) {
+            return !less(a, b) && !less(b, a);
+        }), entries.end());
+    }
+};
+
+// Average bucket of 4 to 8 records, between 2^8 and 2^24 buckets
+int radixBitsFor(uint64_t records) {
+    int bits = 8;
+    while (bits < 24 && (records >> (bits + 3)) != 0) bits++;
+    return bits;
+}
+
+uint32_t bucketOf(const uint8_t* hash, int bits) {
+    uint32_t top = static_cast<uint32_t>(hash[0]) << 24 | static_cast<uint32_t>(hash[1]) << 16 |
+                   static_cast<uint32_t>(hash[2]) << 8 | hash[3];
+    return top >> (32 - bits);
+}
+
+} // namespace
+
+AddressIndex::AddressIndex(const std::string& path)
+    : data(nullptr), length(0), recordCount(0), radixBits(0), records(nullptr), pool(nullptr), poolSize(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open address index: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderSize) {
+        close(fd);
+        throw std::runtime_error("Address index is truncated: " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map address index: " + path);
+    }
+    data = static_cast<const uint8_t*>(mapping);
+    // Lookups touch one directory slot and one bucket: no read-ahead
+    madvise(mapping, length, MADV_RANDOM);
+
+    try {
+        if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+            throw std::runtime_error("Not an address index: " + path);
+        }
+        if (data[4] != kVersion) {
+            throw std::runtime_error("Unsupported address index version " + std::to_string(data[4]));
+        }
+        radixBits = data[5];
+        if (radixBits < 8 || radixBits > 24) {
+            throw std::runtime_error("Invalid address index radix bits " + std::to_string(radixBits));
+        }
+        recordCount = readLe64(data + 8);
+        poolSize = readLe64(data + 16);
+        const uint64_t directoryBytes = ((1ULL << radixBits) + 1) * 8;
+        const uint64_t available = length - kHeaderSize - directoryBytes;
+        if (length < kHeaderSize + directoryBytes || recordCount > available / kRecordSize ||
+            available - recordCount * kRecordSize != poolSize) {
+            throw std::runtime_error("Address index is truncated: " + path);
+        }
+        records = data + kHeaderSize + directoryBytes;
+        pool = reinterpret_cast<const char*>(records + recordCount * kRecordSize);
+        if (poolSize == 0 ? recordCount != 0 : pool[poolSize - 1] != '\0') {
+            throw std::runtime_error("Address index string pool is damaged: " + path);
+        }
+        if (readLe64(data + kHeaderSize + directoryBytes - 8) != recordCount) {
+            throw std::runtime_error("Address index directory is damaged: " + path);
+        }
+    } catch (...) {
+        munmap(const_cast<uint8_t*>(data), length);
+        throw;
+    }
+}
+
+AddressIndex::~AddressIndex() {
+    munmap(const_cast<uint8_t*>(data), length);
+}
+
+bool AddressIndex::isIndex(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+const char* AddressIndex::poolString(const uint8_t* field) const {
+    uint32_t offset = readLe32(field);
+    if (offset >= poolSize) throw std::runtime_error("Address index string pool is damaged");
+    return pool + offset;
+}
+
+void AddressIndex::forEach(const std::function<void(const uint8_t*, const char*, const char*, const char*)>& fn) const {
+    for (uint64_t i = 0; i < recordCount; i++) {
+        const uint8_t* record = records + i * kRecordSize;
+        fn(record, poolString(record + 20), poolString(record + 24), poolString(record + 28));
+    }
+}
+
+std::vector<AddressMatch> AddressIndex::lookup(const std::string& address) const {
+    Query query = parseQuery(address);
+    const uint8_t* directory = data + kHeaderSize;
+    uint32_t bucket = bucketOf(query.hash, radixBits);
+    uint64_t first = readLe64(directory + 8 * bucket);
+    uint64_t last = readLe64(directory + 8 * (bucket + 1));
+    if (first > last || last > recordCount) throw std::runtime_error("Address index directory is damaged");
+
+    std::vector<AddressMatch> matches;
+    for (uint64_t i = first; i < last; i++) {
+        const uint8_t* record = records + i * kRecordSize;
+        int order = std::memcmp(record, query.hash, kHashSize);
+        if (order < 0) continue;
+        if (order > 0) break;
+        AddressMatch match{poolString(record + 20), poolString(record + 24), poolString(record + 28)};
+        auto config = WalletGenerator::networks.find(match.network);
+        if (config != WalletGenerator::networks.end() && query.accepts(config->second)) matches.push_back(match);
+    }
+    return matches;
+}
+
+uint64_t AddressIndex::build(const std::vector<std::string>& inputs, const std::string& path) {
+    if (inputs.empty()) throw std::runtime_error("No chunks or indexes to build the address index from");
+    Builder builder;
+    for (const std::string& input : inputs) {
+        if (isIndex(input)) {
+            builder.addIndex(input);
+        } else {
+            builder.addChunk(input);
+        }
+    }
+    builder.sort();
+    const std::vector<Entry>& entries = builder.entries;
+
+    // Pool strings in order of first use
+    std::string poolText;
+    std::vector<uint64_t> offsets(builder.strings.size(), UINT64_MAX);
+    auto place = [&](uint32_t id) {
+        if (offsets[id] == UINT64_MAX) {
+            offsets[id] = poolText.size();
+            poolText += builder.strings[id];
+            poolText.push_back('\0');
+            if (poolText.size() > UINT32_MAX) throw std::runtime_error("Address index string pool exceeds 4 GiB");
+        }
+        return offsets[id];
+    };
+
+    const int bits = radixBitsFor(entries.size());
+    std::string header(kHeaderSize, '\0');
+    std::memcpy(&header[0], kMagic, sizeof(kMagic));
+    header[4] = static_cast<char>(kVersion);
+    header[5] = static_cast<char>(bits);
+    std::string directory, recordText;
+    recordText.reserve(entries.size() * kRecordSize);
+    uint64_t next = 0;
+    for (uint64_t bucket = 0; bucket <= (1ULL << bits); bucket++) {
+        while (next < entries.size() && bucketOf(entries[next].hash, bits) < bucket) next++;
+        appendLe(directory, next, 8);
+    }
+    for (const Entry& entry : entries) {
+        recordText.append(reinterpret_cast<const char*>(entry.hash), kHashSize);
+        appendLe(recordText, place(entry.network), 4);
+        appendLe(recordText, place(entry.wallet), 4);
+        appendLe(recordText, place(entry.path), 4);
+    }
+    std::string counts;
+    appendLe(counts, entries.size(), 8);
+    appendLe(counts, poolText.size(), 8);
+    header.replace(8, 16, counts);
+
+    // Written beside the target and renamed over it, so readers (including
+    // this build, when the target is one of its inputs) never see a partial
+    // index
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out << header << directory << recordText << poolText;
+        out.flush();
+        if (!out) throw std::runtime_error("Cannot write address index: " + tmp);
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("Cannot replace " + path + ": " + strerror(errno));
+    }
+    return entries.size();
+}
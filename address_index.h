@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Reverse address index (--index-build, --lookup).
+ *
+ * Maps the 20-byte hash behind an address (hash160 for Base58 networks, the
+ * Keccak-256 tail for Ethereum-style ones) to the wallet and path it was
+ * derived from. Indexes are built from sweep chunks, with the chunk's seed
+ * fingerprint as the wallet id, and from earlier indexes, so new batches
+ * are merged into an existing index by rebuilding it with the new chunks.
+ *
+ * The file is a radix-partitioned sorted array, read through mmap:
+ *
+ *   0   "WGIX"
+ *   4   format version (1)
+ *   5   radix bits b
+ *   8   record count, uint64 little-endian
+ *   16  string pool size, uint64 little-endian
+ *   64  directory: 2^b + 1 uint64, the first record of each bucket
+ *       records, 32 bytes each: hash, then the pool offsets of the
+ *       network, wallet id and path (uint32 little-endian)
+ *       string pool: NUL-terminated strings
+ *
+ * Records are sorted by hash and bucketed by its top b bits, with b chosen
+ * so a bucket holds a few records on average. A lookup reads one directory
+ * slot and scans one bucket, usually a single cache line, so it costs a
+ * couple of page faults on a cold file and well under a microsecond on a
+ * warm one, however large the index.
+ *
+ * Private keys are never stored.
+ */
+
+struct AddressMatch {
+    std::string network;
+    std::string wallet;  // seed fingerprint
+    std::string path;
+};
+
+class AddressIndex {
+public:
+    static const size_t kHashSize = 20;
+
+    explicit AddressIndex(const std::string& path);
+    ~AddressIndex();
+
+    AddressIndex(const AddressIndex&) = delete;
+    AddressIndex& operator=(const AddressIndex&) = delete;
+
+    // True if the file starts with the index magic
+    static bool isIndex(const std::string& path);
+
+    uint64_t size() const { return recordCount; }
+
+    // Wallets owning an address, or a hash given as 40 hex digits (which
+    // matches every network). Throws std::runtime_error if the text is not
+    // an address of a supported network.
+    std::vector<AddressMatch> lookup(const std::string& address) const;
+
+    // Calls fn(hash, network, wallet, path) for every record, in order
+    void forEach(const std::function<void(const uint8_t*, const char*, const char*, const char*)>& fn) const;
+
+    // Writes an index of every record in the inputs (sweep chunks or
+    // indexes) to path, replacing it atomically; path may be one of the
+    // inputs. Duplicate records are kept once. Returns the record count.
+    static uint64_t build(const std::vector<std::string>& inputs, const std::string& path);
+
+private:
+    const uint8_t* data;
+    size_t length;
+    uint64_t recordCount;
+    int radixBits;
+    const uint8_t* records;
+    const char* pool;
+    uint64_t poolSize;
+
+    const char* poolString(const uint8_t* field) const;
+};
@@ -0,0 +1,124 @@
+#include "bip39.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <openssl/sha.h>
+
+namespace {
+
+bool supportedWordCount(size_t count) {
+    return count >= 12 && count <= kBip39MaxWords && count % 3 == 0;
+}
+
+// Bit i (MSB first) of a big-endian bit string
+inline unsigned int bitAt(const uint8_t* bytes, size_t i) {
+    return (bytes[i / 8] >> (7 - i % 8)) & 1;
+}
+
+inline void setBit(uint8_t* bytes, size_t i) {
+    bytes[i / 8] |= static_cast<uint8_t>(0x80 >> (i % 8));
+}
+
+} // namespace
+
+int bip39WordIndex(const std::string& word) {
+    const char* const* begin = kBip39English;
+    const char* const* end = kBip39English + kBip39WordCount;
+    const char* const* it = std::lower_bound(begin, end, word,
+        [](const char* entry, const std::string& w) { return w.compare(entry) > 0; });
+    if (it == end || word != *it) return -1;
+    return static_cast<int>(it - begin);
+}
+
+std::vector<uint16_t> mnemonicToIndices(const std::string& mnemonic) {
+    std::vector<uint16_t> indices;
+    size_t start = 0;
+    for (;;) {
+        size_t space = mnemonic.find(' ', start);
+        std::string word = mnemonic.substr(start, space == std::string::npos ? std::string::npos : space - start);
+        int index = bip39WordIndex(word);
+        if (index < 0) {
+            throw std::runtime_error("Unknown mnemonic word: \"" + word + "\"");
+        }
+        indices.push_back(static_cast<uint16_t>(index));
+        if (space == std::string::npos) break;
+        start = space + 1;
+    }
+    if (!supportedWordCount(indices.size())) {
+        throw std::runtime_error("Mnemonic must have 12, 15, 18, 21 or 24 words (got " +
+                                 std::to_string(indices.size()) + ")");
+    }
+    return indices;
+}
+
+void indicesToMnemonic(const uint16_t* indices, size_t count, std::string& out) {
+    for (size_t i = 0; i < count; i++) {
+        if (i) out += ' ';
+        out += kBip39English[indices[i] & 0x7FF];
+    }
+}
+
+bool indicesChecksumValid(const uint16_t* indices, size_t count) {
+    if (!supportedWordCount(count)) return false;
+
+    uint8_t bits[33] = {0};
+    packIndices(indices, count, bits);
+    size_t entropyBytes = count * 11 / 33 * 4;
+    size_t checksumBits = count / 3;
+
+    uint8_t hash[SHA256_DIGEST_LENGTH];
+    SHA256(bits, entropyBytes, hash);
+    for (size_t i = 0; i < checksumBits; i++) {
+        if (bitAt(bits, entropyBytes * 8 + i) != bitAt(hash, i)) return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> indicesToEntropy(const uint16_t* indices, size_t count) {
+    if (!indicesChecksumValid(indices, count)) {
+        throw std::runtime_error("Invalid mnemonic checksum");
+    }
+    uint8_t bits[33] = {0};
+    packIndices(indices, count, bits);
+    return std::vector<uint8_t>(bits, bits + count * 11 / 33 * 4);
+}
+
+std::vector<uint16_t> entropyToIndices(const uint8_t* entropy, size_t len) {
+    if (len < 16 || len > 32 || len % 4 != 0) {
+        throw std::runtime_error("Entropy must be 16, 20, 24, 28 or 32 bytes");
+    }
+    uint8_t bits[33] = {0};
+    std::memcpy(bits, entropy, len);
+    uint8_t hash[SHA256_DIGEST_LENGTH];
+    SHA256(entropy, len, hash);
+    // The checksum is at most 8 bits, so it always fits in the byte after the entropy
+    bits[len] = hash[0];
+
+    size_t count = len * 8 * 3 / 32;
+    std::vector<uint16_t> indices(count);
+    unpackIndices(bits, count, indices.data());
+    return indices;
+}
+
+size_t packedIndexBytes(size_t wordCount) {
+    return (wordCount * 11 + 7) / 8;
+}
+
+void packIndices(const uint16_t* indices, size_t count, uint8_t* out) {
+    std::memset(out, 0, packedIndexBytes(count));
+    for (size_t i = 0; i < count; i++) {
+        for (unsigned int b = 0; b < 11; b++) {
+            if ((indices[i] >> (10 - b)) & 1) setBit(out, i * 11 + b);
+        }
+    }
+}
+
+void unpackIndices(const uint8_t* packed, size_t count, uint16_t* out) {
+    for (size_t i = 0; i < count; i++) {
+        uint16_t index = 0;
+        for (unsigned int b = 0; b < 11; b++) {
+            index = static_cast<uint16_t>((index << 1) | bitAt(packed, i * 11 + b));
+        }
+        out[i] = index;
+    }
+}
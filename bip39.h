@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * BIP39 mnemonic <-> wordlist index <-> entropy conversions.
+ *
+ * A mnemonic of N words is N 11-bit indices: ENT entropy bits followed by
+ * ENT/32 checksum bits taken from SHA-256(entropy). N is 12, 15, 18, 21 or
+ * 24, i.e. 16 to 32 bytes of entropy. Only the English list is built in.
+ */
+
+const size_t kBip39WordCount = 2048;
+const size_t kBip39MaxWords = 24;
+
+extern const char* const kBip39English[kBip39WordCount];
+
+// Wordlist index of word, or -1 if it is not in the list
+int bip39WordIndex(const std::string& word);
+
+// Splits on single spaces and looks up every word; throws on unknown words
+// or an unsupported word count. Does not check the checksum.
+std::vector<uint16_t> mnemonicToIndices(const std::string& mnemonic);
+
+// Joins words with single spaces, appending to out without intermediate strings
+void indicesToMnemonic(const uint16_t* indices, size_t count, std::string& out);
+
+bool indicesChecksumValid(const uint16_t* indices, size_t count);
+
+// Entropy bits of a mnemonic; throws if the checksum does not match
+std::vector<uint8_t> indicesToEntropy(const uint16_t* indices, size_t count);
+std::vector<uint16_t> entropyToIndices(const uint8_t* entropy, size_t len);
+
+// Packs 11-bit indices big-endian into ceil(count * 11 / 8) bytes and back
+size_t packedIndexBytes(size_t wordCount);
+void packIndices(const uint16_t* indices, size_t count, uint8_t* out);
+void unpackIndices(const uint8_t* packed, size_t count, uint16_t* out);
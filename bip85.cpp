@@ -0,0 +1,129 @@
+#include "bip85.h"
+#include "bip39.h"
+#include "crypto_kernels.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <openssl/crypto.h>
+
+namespace {
+
+const uint32_t kHardened = 0x80000000u;
+
+// secp256k1 group order, big-endian
+const uint8_t kCurveOrder[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+    0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B, 0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41
+};
+
+bool belowOrder(const uint8_t value[32]) {
+    return std::memcmp(value, kCurveOrder, 32) < 0;
+}
+
+// key = (key + tweak) mod n, both big-endian and below n
+void addModOrder(uint8_t key[32], const uint8_t tweak[32]) {
+    unsigned int carry = 0;
+    for (int i = 31; i >= 0; i--) {
+        carry += static_cast<unsigned int>(key[i]) + tweak[i];
+        key[i] = static_cast<uint8_t>(carry);
+        carry >>= 8;
+    }
+    if (carry || !belowOrder(key)) {
+        unsigned int borrow = 0;
+        for (int i = 31; i >= 0; i--) {
+            unsigned int diff = static_cast<unsigned int>(key[i]) - kCurveOrder[i] - borrow;
+            key[i] = static_cast<uint8_t>(diff);
+            borrow = (diff >> 8) & 1;
+        }
+    }
+}
+
+// BIP32 hardened child: I = HMAC-SHA512(chainCode, 0x00 || key || ser32(index)),
+// key' = I[0:32] + key mod n, chainCode' = I[32:64]. Both are updated in place.
+void hardenedChild(uint8_t key[32], uint8_t chainCode[32], uint32_t index) {
+    index |= kHardened;
+    uint8_t data[37];
+    data[0] = 0;
+    std::memcpy(data + 1, key, 32);
+    for (int i = 0; i < 4; i++) data[33 + i] = static_cast<uint8_t>(index >> (24 - 8 * i));
+
+    HmacSha512Key hmacKey;
+    hmacSha512Prepare(hmacKey, chainCode, 32);
+    uint8_t digest[64];
+    hmacSha512(hmacKey, data, sizeof(data), digest);
+
+    // BIP32 skips such indices; with probability below 2^-127 they never
+    // occur in practice, so they are reported instead
+    bool valid = belowOrder(digest);
+    if (valid) {
+        addModOrder(key, digest);
+        static const uint8_t zero[32] = {0};
+        valid = std::memcmp(key, zero, 32) != 0;
+    }
+    std::memcpy(chainCode, digest + 32, 32);
+    OPENSSL_cleanse(data, sizeof(data));
+    OPENSSL_cleanse(digest, sizeof(digest));
+    OPENSSL_cleanse(&hmacKey, sizeof(hmacKey));
+    if (!valid) throw std::runtime_error("Invalid BIP32 child key at index " + std::to_string(index & ~kHardened));
+}
+
+size_t checkedWords(size_t words) {
+    if (words < 12 || words > kBip39MaxWords || words % 3 != 0) {
+        throw std::runtime_error("Mnemonics have 12, 15, 18, 21 or 24 words");
+    }
+    return words;
+}
+
+} // namespace
+
+Bip85Mnemonics::Bip85Mnemonics(ByteView seed, size_t words) : wordCount(checkedWords(words)) {
+    static const uint8_t masterKey[] = {'B', 'i', 't', 'c', 'o', 'i', 'n', ' ', 's', 'e', 'e', 'd'};
+    HmacSha512Key hmacKey;
+    hmacSha512Prepare(hmacKey, masterKey, sizeof(masterKey));
+    SecureBytes master(64);
+    hmacSha512(hmacKey, seed.data(), seed.size(), master.data());
+    if (!belowOrder(master.data()) ||
+        std::all_of(master.begin(), master.begin() + 32, [](uint8_t b) { return b == 0; })) {
+        throw std::runtime_error("Seed gives an invalid BIP32 master key");
+    }
+    deriveParent(master.data(), master.data() + 32);
+}
+
+Bip85Mnemonics::Bip85Mnemonics(const uint8_t key[32], const uint8_t chainCode[32], size_t words)
+    : wordCount(checkedWords(words)) {
+    deriveParent(key, chainCode);
+}
+
+void Bip85Mnemonics::deriveParent(const uint8_t* key, const uint8_t* chainCode) {
+    parentKey.assign(key, key + 32);
+    parentChainCode.assign(chainCode, chainCode + 32);
+    for (uint32_t index : {83696968u, 39u, 0u, static_cast<uint32_t>(wordCount)}) {
+        hardenedChild(parentKey.data(), parentChainCode.data(), index);
+    }
+}
+
+SecureBytes Bip85Mnemonics::entropy(uint32_t index) const {
+    if (index & kHardened) throw std::runtime_error("BIP85 child index must be below 2^31");
+    SecureBytes key(parentKey);
+    SecureBytes chainCode(parentChainCode);
+    hardenedChild(key.data(), chainCode.data(), index);
+
+    static const uint8_t entropyKey[] = {'b', 'i', 'p', '-', 'e', 'n', 't', 'r', 'o', 'p', 'y', '-', 'f', 'r', 'o', 'm', '-', 'k'};
+    HmacSha512Key hmacKey;
+    hmacSha512Prepare(hmacKey, entropyKey, sizeof(entropyKey));
+    SecureBytes digest(64);
+    hmacSha512(hmacKey, key.data(), key.size(), digest.data());
+    digest.resize(wordCount / 3 * 4);
+    return digest;
+}
+
+std::string Bip85Mnemonics::mnemonic(uint32_t index) const {
+    SecureBytes childEntropy = entropy(index);
+    std::vector<uint16_t> indices = entropyToIndices(childEntropy.data(), childEntropy.size());
+    std::string phrase;
+    phrase.reserve(wordCount * 9);
+    indicesToMnemonic(indices.data(), indices.size(), phrase);
+    OPENSSL_cleanse(indices.data(), indices.size() * sizeof(uint16_t));
+    return phrase;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "secure_memory.h"
+
+/**
+ * BIP85 child mnemonics (--bip85).
+ *
+ * Child index i of a master key is the BIP39 mnemonic whose entropy is the
+ * first 16-32 bytes (by word count) of
+ *
+ *   HMAC-SHA512("bip-entropy-from-k", k),  k = key at m/83696968'/39'/0'/words'/i'
+ *
+ * derived with hardened BIP32 steps from the master key of the seed
+ * (HMAC-SHA512("Bitcoin seed", seed)). Language 0 (English) is the only one
+ * built in. Hardened steps need no EC arithmetic, only HMAC-SHA512 and an
+ * addition modulo the curve order.
+ *
+ * The key at m/83696968'/39'/0'/words' is derived once, so each child costs
+ * one hardened step and one HMAC.
+ */
+
+class Bip85Mnemonics {
+public:
+    // Children of the master key of a BIP39 seed; throws std::runtime_error
+    // for word counts other than 12, 15, 18, 21 and 24
+    Bip85Mnemonics(ByteView seed, size_t words);
+
+    // Children of a master extended private key, given its key and chain code
+    Bip85Mnemonics(const uint8_t key[32], const uint8_t chainCode[32], size_t words);
+
+    size_t words() const { return wordCount; }
+
+    // Child entropy and mnemonic; index must be below 2^31
+    SecureBytes entropy(uint32_t index) const;
+    std::string mnemonic(uint32_t index) const;
+
+private:
+    size_t wordCount;
+    SecureBytes parentKey;        // at m/83696968'/39'/0'/words'
+    SecureBytes parentChainCode;
+
+    void deriveParent(const uint8_t* key, const uint8_t* chainCode);
+};
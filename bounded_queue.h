@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+/**
+ * Bounded lock-free multi-producer/multi-consumer queue.
+ *
+ * Each slot carries a sequence number that tells producers and consumers
+ * whether it is free or filled for the current lap (Vyukov's design), so
+ * push and pop are a CAS on the head/tail index plus a store to the slot.
+ * The blocking wrappers back off by yielding and then sleeping briefly;
+ * they never take a lock.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : mask(roundUpPowerOfTwo(capacity < 2 ? 2 : capacity) - 1),
+          slots(new Slot[mask + 1]),
+          enqueuePos(0),
+          dequeuePos(0),
+          closed(false) {
+        for (size_t i = 0; i <= mask; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    bool tryPush(T& value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(slot.value);
+                    slot.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Blocks (with backoff) until there is room
+    void push(T value) {
+        for (unsigned int attempt = 0; !tryPush(value); attempt++) {
+            backoff(attempt);
+        }
+    }
+
+    // Blocks until an item is available; returns false once the queue is
+    // closed and drained
+    bool pop(T& value) {
+        for (unsigned int attempt = 0;; attempt++) {
+            if (tryPop(value)) return true;
+            if (closed.load(std::memory_order_acquire)) {
+                // Re-check: an item may have landed just before close()
+                return tryPop(value);
+            }
+            backoff(attempt);
+        }
+    }
+
+    // No more pushes will follow; consumers drain and then see end-of-stream
+    void close() {
+        closed.store(true, std::memory_order_release);
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundUpPowerOfTwo(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    static void backoff(unsigned int attempt) {
+        if (attempt < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+    alignas(64) std::atomic<bool> closed;
+};
@@ -0,0 +1,436 @@
+#include "bulk_pipeline.h"
+#include "bip39.h"
+#include "crypto_kernels.h"
+#include "wallet_stats.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <openssl/crypto.h>
+#ifdef __linux__
+#include <sys/random.h>
+#else
+#include <stdlib.h>
+#endif
+
+namespace {
+
+// Frees key material as soon as a stage is done with it; the owning thread's
+// secure arena zeroes it in bulk once its chunk empties
+void dropSecret(SecureBytes& bytes) {
+    SecureBytes().swap(bytes);
+}
+
+std::vector<std::string> splitTabs(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (;;) {
+        size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) break;
+        start = tab + 1;
+    }
+    return fields;
+}
+
+// Fills buffer from the kernel CSPRNG, blocking only until it is seeded
+void fillEntropy(uint8_t* buffer, size_t len) {
+#ifdef __linux__
+    while (len > 0) {
+        ssize_t got = getrandom(buffer, len, 0);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("getrandom failed: ") + strerror(errno));
+        }
+        buffer += got;
+        len -= static_cast<size_t>(got);
+    }
+#else
+    arc4random_buf(buffer, len);
+#endif
+}
+
+} // namespace
+
+BulkPipeline::BulkPipeline(const PipelineOptions& options) : options(options) {
+    if (this->options.networks.empty()) {
+        throw std::runtime_error("No networks selected");
+    }
+    for (const std::string& net : this->options.networks) {
+        if (WalletGenerator::networks.find(net) == WalletGenerator::networks.end()) {
+            throw std::runtime_error("Unsupported network: " + net);
+        }
+    }
+
+    unsigned int& kdf = this->options.kdfThreads;
+    if (kdf == 0) kdf = std::max(1u, std::thread::hardware_concurrency());
+    if (this->options.deriveThreads == 0) this->options.deriveThreads = std::max(1u, kdf / 4);
+    if (this->options.encodeThreads == 0) this->options.encodeThreads = std::max(1u, kdf / 4);
+}
+
+void BulkPipeline::parseStageThreads(const std::string& spec, PipelineOptions& options) {
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            throw std::runtime_error("Invalid stage thread spec: " + item);
+        }
+        std::string stage = item.substr(0, eq);
+        unsigned long n;
+        try {
+            n = std::stoul(item.substr(eq + 1));
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid thread count for stage " + stage);
+        }
+        if (n == 0 || n > 1024) {
+            throw std::runtime_error("Thread count for stage " + stage + " must be between 1 and 1024");
+        }
+        if (stage == "kdf") {
+            options.kdfThreads = static_cast<unsigned int>(n);
+        } else if (stage == "derive") {
+            options.deriveThreads = static_cast<unsigned int>(n);
+        } else if (stage == "encode") {
+            options.encodeThreads = static_cast<unsigned int>(n);
+        } else {
+            throw std::runtime_error("Unknown pipeline stage: " + stage);
+        }
+    }
+}
+
+std::string BulkPipeline::validateMnemonic(const std::string& mnemonic) {
+    try {
+        std::vector<uint16_t> indices = mnemonicToIndices(mnemonic);
+        if (!indicesChecksumValid(indices.data(), indices.size())) {
+            return "invalid mnemonic checksum";
+        }
+    } catch (const std::exception& e) {
+        return e.what();
+    }
+    return "";
+}
+
+void BulkPipeline::parseStage(std::istream& in, BoundedQueue<Record*>& out) {
+    std::string line;
+    uint64_t lineNumber = 0;
+    uint64_t sequence = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        Record* record = new Record();
+        record->sequence = sequence++;
+        record->lineNumber = lineNumber;
+
+        std::vector<std::string> fields = splitTabs(line);
+        if (options.input == InputType::Seed) {
+            if (fields.size() > 2) {
+                record->error = "too many fields";
+            } else {
+                record->path = fields.size() > 1 ? fields[1] : options.customPath;
+                try {
+                    record->seed = WalletGenerator::seedFromHex(fields[0]);
+                } catch (const std::exception& e) {
+                    record->error = e.what();
+                }
+            }
+        } else if (fields.size() > 3) {
+            record->error = "too many fields";
+        } else if (options.input == InputType::Entropy) {
+            record->passphrase = fields.size() > 1 ? fields[1] : options.passphrase;
+            record->path = fields.size() > 2 ? fields[2] : options.customPath;
+            try {
+                record->mnemonic = WalletGenerator::mnemonicFromEntropyHex(fields[0]);
+            } catch (const std::exception& e) {
+                record->error = e.what();
+            }
+        } else {
+            record->mnemonic = fields[0];
+            record->passphrase = fields.size() > 1 ? fields[1] : options.passphrase;
+            record->path = fields.size() > 2 ? fields[2] : options.customPath;
+            record->error = validateMnemonic(record->mnemonic);
+        }
+        out.push(record);
+    }
+}
+
+void BulkPipeline::packedStage(const MnemonicFile& in, BoundedQueue<Record*>& out) {
+    for (uint64_t i = 0; i < in.size(); i++) {
+        Record* record = new Record();
+        record->sequence = i;
+        record->lineNumber = i + 1;
+        // Text is rebuilt from the indices because PBKDF2 hashes the phrase
+        record->mnemonic.reserve(in.wordCount() * 9);
+        if (!in.mnemonicAt(i, record->mnemonic)) {
+            record->error = "invalid mnemonic checksum";
+        }
+        record->passphrase = options.passphrase;
+        record->path = options.customPath;
+        out.push(record);
+    }
+}
+
+void BulkPipeline::generateStage(uint64_t count, size_t words, BoundedQueue<Record*>& out) {
+    // One getrandom call per chunk instead of one per mnemonic
+    const size_t entropyBytes = words / 3 * 4;
+    SecureBytes entropy(32 * 1024 / entropyBytes * entropyBytes);
+    size_t offset = entropy.size();
+    for (uint64_t i = 0; i < count; i++) {
+        Record* record = new Record();
+        record->sequence = i;
+        record->lineNumber = i + 1;
+        if (offset == entropy.size()) {
+            try {
+                fillEntropy(entropy.data(), entropy.size());
+            } catch (const std::exception& e) {
+                // Reported as this record's error; nothing after it is generated
+                record->error = e.what();
+                out.push(record);
+                return;
+            }
+            offset = 0;
+        }
+        std::vector<uint16_t> indices = entropyToIndices(entropy.data() + offset, entropyBytes);
+        OPENSSL_cleanse(entropy.data() + offset, entropyBytes);
+        offset += entropyBytes;
+        record->mnemonic.reserve(words * 9);
+        indicesToMnemonic(indices.data(), indices.size(), record->mnemonic);
+        OPENSSL_cleanse(indices.data(), indices.size() * sizeof(uint16_t));
+        record->phrase = record->mnemonic;
+        record->passphrase = options.passphrase;
+        record->path = options.customPath;
+        out.push(record);
+    }
+}
+
+void BulkPipeline::bip85Stage(const Bip85Mnemonics& children, uint32_t start, uint32_t end,
+                              BoundedQueue<Record*>& out) {
+    for (uint32_t index = start; index < end; index++) {
+        Record* record = new Record();
+        record->sequence = index - start;
+        record->lineNumber = index;
+        try {
+            record->mnemonic = children.mnemonic(index);
+            record->phrase = record->mnemonic;
+        } catch (const std::exception& e) {
+            record->error = e.what();
+        }
+        record->passphrase = options.passphrase;
+        record->path = options.customPath;
+        out.push(record);
+    }
+}
+
+void BulkPipeline::kdfStage(BoundedQueue<Record*>& in, BoundedQueue<Record*>& out) {
+    WalletGenerator generator;
+    Record* first;
+    while (in.pop(first)) {
+        // Fill a lane group with whatever is already queued; never wait for more
+        std::vector<Record*> batch{first};
+        Record* next;
+        while (batch.size() < kSha512Lanes && in.tryPop(next)) {
+            batch.push_back(next);
+        }
+
+        std::vector<Record*> pending;
+        std::vector<std::string> mnemonics;
+        std::vector<std::string> passphrases;
+        for (Record* record : batch) {
+            if (!record->error.empty() || !record->seed.empty()) continue;
+            if (options.seedCache && options.seedCache->lookup(record->mnemonic, record->passphrase, record->seed)) continue;
+            pending.push_back(record);
+            mnemonics.push_back(record->mnemonic);
+            passphrases.push_back(record->passphrase);
+        }
+
+        if (!pending.empty()) {
+            try {
+                std::vector<SecureBytes> seeds = generator.mnemonicToSecureSeedBatch(mnemonics, passphrases);
+                for (size_t i = 0; i < pending.size(); i++) {
+                    if (options.seedCache) options.seedCache->insert(pending[i]->mnemonic, pending[i]->passphrase, seeds[i]);
+                    pending[i]->seed = std::move(seeds[i]);
+                }
+            } catch (const std::exception& e) {
+                for (Record* record : pending) record->error = e.what();
+            }
+        }
+
+        for (size_t i = 0; i < mnemonics.size(); i++) {
+            OPENSSL_cleanse(&mnemonics[i][0], mnemonics[i].size());
+            OPENSSL_cleanse(&passphrases[i][0], passphrases[i].size());
+        }
+        for (Record* record : batch) {
+            OPENSSL_cleanse(&record->mnemonic[0], record->mnemonic.size());
+            OPENSSL_cleanse(&record->passphrase[0], record->passphrase.size());
+            out.push(record);
+        }
+        secureArenaReset();
+    }
+}
+
+void BulkPipeline::deriveStage(BoundedQueue<Record*>& in, BoundedQueue<Record*>& out) {
+    WalletGenerator generator;
+    Record* record;
+    while (in.pop(record)) {
+        if (record->error.empty()) {
+            try {
+                for (const std::string& net : options.networks) {
+                    // An explicit path gives one wallet per network
+                    std::vector<std::string> paths;
+                    if (!record->path.empty()) {
+                        paths.push_back(record->path);
+                    } else {
+                        for (uint32_t i = 0; i < options.count; i++) {
+                            paths.push_back(WalletGenerator::indexedPath(net, i));
+                        }
+                    }
+                    std::vector<WalletGenerator::KeyPair> keyPairs = generator.deriveKeyPairs(record->seed, net, paths);
+                    for (WalletGenerator::KeyPair& keys : keyPairs) {
+                        record->keys.push_back(std::move(keys));
+                    }
+                }
+            } catch (const std::exception& e) {
+                record->error = e.what();
+            }
+        }
+        dropSecret(record->seed);
+        out.push(record);
+        secureArenaReset();
+    }
+}
+
+void BulkPipeline::encodeStage(BoundedQueue<Record*>& in, BoundedQueue<Record*>& out) {
+    WalletGenerator generator;
+    const std::string rule(50, '=');
+    Record* record;
+    while (in.pop(record)) {
+        if (record->error.empty()) {
+            try {
+                std::string text;
+                if (options.format == OutputFormat::Text) {
+                    text += "\nRECORD: " + std::string(recordName) + " " + std::to_string(record->lineNumber) + "\n";
+                    if (!record->phrase.empty()) text += "MNEMONIC: " + record->phrase + "\n";
+                }
+
+                std::string currentNetwork;
+                int walletNumber = 0;
+                std::vector<WalletGenerator::WalletInfo> wallets = generator.encodeWallets(record->keys);
+                for (size_t i = 0; i < wallets.size(); i++) {
+                    const WalletGenerator::KeyPair& keys = record->keys[i];
+                    const WalletGenerator::WalletInfo& wallet = wallets[i];
+                    if (options.format == OutputFormat::Tsv) {
+                        text += std::to_string(record->lineNumber) + "\t" + keys.network + "\t" +
+                                wallet.derivationPath + "\t" + wallet.address + "\t";
+                        text += wallet.privateKey;
+                        text += "\t";
+                        text += wallet.wif;
+                        text += "\t" + wallet.publicKey + (record->phrase.empty() ? "" : "\t" + record->phrase) + "\n";
+                        continue;
+                    }
+                    // Same layout as a single-mnemonic run
+                    if (keys.network != currentNetwork) {
+                        currentNetwork = keys.network;
+                        walletNumber = 0;
+                        text += "\n" + rule + "\nNETWORK: " + currentNetwork + "\n" + rule + "\n";
+                    }
+                    text += "Wallet #" + std::to_string(++walletNumber) + "\n";
+                    text += WalletGenerator::formatWallet(wallet, options.verbose);
+                }
+                record->output = std::move(text);
+                record->wallets = record->keys.size();
+            } catch (const std::exception& e) {
+                record->error = e.what();
+            }
+        }
+        for (WalletGenerator::KeyPair& keys : record->keys) dropSecret(keys.privateKey);
+        record->keys.clear();
+        OPENSSL_cleanse(&record->phrase[0], record->phrase.size());
+        out.push(record);
+        secureArenaReset();
+    }
+}
+
+PipelineStats BulkPipeline::writeStage(BoundedQueue<Record*>& in, std::ostream& out) {
+    PipelineStats stats;
+    std::map<uint64_t, Record*> reorder;
+    uint64_t nextSequence = 0;
+    Record* record;
+    while (in.pop(record)) {
+        reorder.emplace(record->sequence, record);
+        for (auto it = reorder.begin(); it != reorder.end() && it->first == nextSequence; it = reorder.erase(it)) {
+            Record* ready = it->second;
+            stats.records++;
+            if (ready->error.empty()) {
+                WG_STAT_SCOPE(StatStage::Output, ready->output.size());
+                out << ready->output;
+                stats.wallets += ready->wallets;
+            } else {
+                std::cerr << "Error: " << recordName << " " << ready->lineNumber << ": " << ready->error << std::endl;
+                stats.failures++;
+            }
+            OPENSSL_cleanse(&ready->output[0], ready->output.size());
+            delete ready;
+            nextSequence++;
+        }
+    }
+    out.flush();
+    return stats;
+}
+
+PipelineStats BulkPipeline::run(std::istream& in, std::ostream& out) {
+    return runStages([&](BoundedQueue<Record*>& parsed) { parseStage(in, parsed); }, out);
+}
+
+PipelineStats BulkPipeline::run(const MnemonicFile& in, std::ostream& out) {
+    return runStages([&](BoundedQueue<Record*>& parsed) { packedStage(in, parsed); }, out);
+}
+
+PipelineStats BulkPipeline::generate(uint64_t count, size_t words, std::ostream& out) {
+    if (words < 12 || words > 24 || words % 3 != 0) {
+        throw std::runtime_error("Mnemonics have 12, 15, 18, 21 or 24 words");
+    }
+    return runStages([&](BoundedQueue<Record*>& parsed) { generateStage(count, words, parsed); }, out);
+}
+
+PipelineStats BulkPipeline::bip85(const Bip85Mnemonics& children, uint32_t start, uint32_t end, std::ostream& out) {
+    if (start > end || end > 0x80000000u) throw std::runtime_error("BIP85 child indices must be below 2^31");
+    recordName = "child";
+    PipelineStats stats = runStages([&](BoundedQueue<Record*>& parsed) { bip85Stage(children, start, end, parsed); }, out);
+    recordName = "line";
+    return stats;
+}
+
+PipelineStats BulkPipeline::runStages(const std::function<void(BoundedQueue<Record*>&)>& source,
+                                      std::ostream& out) {
+    BoundedQueue<Record*> parsed(options.queueDepth);
+    BoundedQueue<Record*> seeded(options.queueDepth);
+    BoundedQueue<Record*> derived(options.queueDepth);
+    BoundedQueue<Record*> encoded(options.queueDepth);
+
+    std::vector<std::thread> threads;
+    // The last thread of a stage to finish closes the queue it feeds
+    auto spawnStage = [&threads](unsigned int count, BoundedQueue<Record*>& next,
+                                 std::function<void()> body) {
+        auto remaining = std::make_shared<std::atomic<unsigned int>>(count);
+        for (unsigned int i = 0; i < count; i++) {
+            threads.emplace_back([remaining, &next, body]() {
+                body();
+                if (remaining->fetch_sub(1) == 1) next.close();
+            });
+        }
+    };
+
+    spawnStage(1, parsed, [&]() { source(parsed); });
+    spawnStage(options.kdfThreads, seeded, [&]() { kdfStage(parsed, seeded); });
+    spawnStage(options.deriveThreads, derived, [&]() { deriveStage(seeded, derived); });
+    spawnStage(options.encodeThreads, encoded, [&]() { encodeStage(derived, encoded); });
+
+    PipelineStats stats = writeStage(encoded, out);
+    for (std::thread& t : threads) t.join();
+    return stats;
+}
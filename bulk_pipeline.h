@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "bip85.h"
+#include "bounded_queue.h"
+#include "mnemonic_file.h"
+#include "seed_cache.h"
+#include "wallet_generator.h"
+
+/**
+ * Bulk mnemonic processing (--input).
+ *
+ * Input is one record per line: "mnemonic[<TAB>passphrase[<TAB>path]]".
+ * With --input-type entropy the first field is instead the hex entropy of
+ * the mnemonic, and with --input-type seed a line is "seed[<TAB>path]", a
+ * 128-digit hex seed that goes straight to the derive stage.
+ * Blank lines and lines starting with '#' are skipped. Packed binary files
+ * (see mnemonic_file.h) are read from a memory mapping instead and need no
+ * tokenizing or word lookups. generate() makes fresh mnemonics instead of
+ * reading any, from kernel entropy fetched in 32 KiB chunks, and prints each
+ * one with its wallets. bip85() does the same for a range of BIP85 child
+ * mnemonics of one master seed, numbering records by child index. Records flow through
+ * five stages connected by bounded lock-free queues:
+ *
+ *   parse/validate -> PBKDF2 -> derive (EC) -> encode (hash/text) -> write
+ *
+ * The parse and write stages are single threaded; the others run a
+ * configurable number of threads each. KDF threads take up to a lane group
+ * of records at a time for the multi-lane PBKDF2 kernel, after taking any
+ * seeds already in the seed cache. The writer restores input order, so
+ * output is identical regardless of thread counts.
+ */
+
+enum class OutputFormat {
+    Text,  // printWallet layout
+    Tsv    // line, network, path, address, private key, WIF, public key
+           // (then the mnemonic for generated records)
+};
+
+enum class InputType {
+    Mnemonic,
+    Entropy,  // hex entropy, converted to its mnemonic while parsing
+    Seed      // hex seed; skips PBKDF2
+};
+
+struct PipelineOptions {
+    std::vector<std::string> networks;
+    uint32_t count = 1;              // wallets per network when no path is given
+    std::string passphrase;          // default when a line has no passphrase field
+    std::string customPath;          // default when a line has no path field
+    bool verbose = false;
+    OutputFormat format = OutputFormat::Text;
+    InputType input = InputType::Mnemonic;  // of text input; packed files hold mnemonics
+    unsigned int kdfThreads = 0;     // 0 = hardware concurrency
+    unsigned int deriveThreads = 0;  // 0 = one per four KDF threads
+    unsigned int encodeThreads = 0;  // 0 = one per four KDF threads
+    size_t queueDepth = 256;         // capacity of each inter-stage queue
+    SeedCache* seedCache = nullptr;  // seeds found here skip PBKDF2; new ones are added
+};
+
+struct PipelineStats {
+    uint64_t records = 0;
+    uint64_t wallets = 0;
+    uint64_t failures = 0;
+};
+
+class BulkPipeline {
+public:
+    explicit BulkPipeline(const PipelineOptions& options);
+
+    PipelineStats run(std::istream& in, std::ostream& out);
+    PipelineStats run(const MnemonicFile& in, std::ostream& out);
+
+    // count new random mnemonics of words words (12, 15, 18, 21 or 24)
+    PipelineStats generate(uint64_t count, size_t words, std::ostream& out);
+
+    // BIP85 children start to end - 1 of children
+    PipelineStats bip85(const Bip85Mnemonics& children, uint32_t start, uint32_t end, std::ostream& out);
+
+    // Parses "kdf=N,derive=N,encode=N" (any subset) into options
+    static void parseStageThreads(const std::string& spec, PipelineOptions& options);
+
+private:
+    struct Record {
+        uint64_t sequence;
+        uint64_t lineNumber;
+        std::string mnemonic;
+        std::string passphrase;
+        std::string path;
+        std::string phrase;  // printed with the wallets, for generated mnemonics
+        std::string error;
+        SecureBytes seed;  // set while parsing for seed input
+        std::vector<WalletGenerator::KeyPair> keys;
+        std::string output;
+        uint64_t wallets = 0;
+    };
+
+    PipelineOptions options;
+    const char* recordName = "line";  // what Record::lineNumber counts, in output and errors
+
+    static std::string validateMnemonic(const std::string& mnemonic);
+
+    PipelineStats runStages(const std::function<void(BoundedQueue<Record*>&)>& source, std::ostream& out);
+
+    void parseStage(std::istream& in, BoundedQueue<Record*>& out);
+    void packedStage(const MnemonicFile& in, BoundedQueue<Record*>& out);
+    void generateStage(uint64_t count, size_t words, BoundedQueue<Record*>& out);
+    void bip85Stage(const Bip85Mnemonics& children, uint32_t start, uint32_t end, BoundedQueue<Record*>& out);
+    void kdfStage(BoundedQueue<Record*>& in, BoundedQueue<Record*>& out);
+    void deriveStage(BoundedQueue<Record*>& in, BoundedQueue<Record*>& out);
+    void encodeStage(BoundedQueue<Record*>& in, BoundedQueue<Record*>& out);
+    PipelineStats writeStage(BoundedQueue<Record*>& in, std::ostream& out);
+};
@@ -0,0 +1,71 @@
+#include "cpu_features.h"
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+struct FeatureName {
+    CpuFeature feature;
+    const char* name;
+};
+
+const FeatureName kFeatureNames[] = {
+    {kCpuAvx2, "avx2"},
+    {kCpuAvx512, "avx512"},
+    {kCpuShaNi, "sha"},
+    {kCpuSsse3, "ssse3"}
+};
+
+uint32_t probe() {
+    uint32_t features = 0;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    // __builtin_cpu_supports also checks that the OS saves the AVX registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) features |= kCpuAvx2;
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")) features |= kCpuAvx512;
+    if (__builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1")) features |= kCpuShaNi;
+    if (__builtin_cpu_supports("ssse3")) features |= kCpuSsse3;
+#endif
+    return features;
+}
+
+} // namespace
+
+uint32_t detectCpuFeatures() {
+    static const uint32_t features = probe();
+    return features;
+}
+
+std::string cpuFeatureNames(uint32_t features) {
+    std::string names;
+    for (const FeatureName& entry : kFeatureNames) {
+        if (!(features & entry.feature)) continue;
+        if (!names.empty()) names += ",";
+        names += entry.name;
+    }
+    return names.empty() ? "none" : names;
+}
+
+uint32_t parseCpuFeatures(const std::string& list) {
+    if (list == "all") return detectCpuFeatures();
+    if (list == "none") return 0;
+
+    uint32_t features = 0;
+    std::stringstream stream(list);
+    std::string name;
+    while (std::getline(stream, name, ',')) {
+        uint32_t feature = 0;
+        for (const FeatureName& entry : kFeatureNames) {
+            if (name == entry.name) feature = entry.feature;
+        }
+        if (!feature) {
+            throw std::runtime_error("Unknown CPU feature: '" + name + "' (expected " +
+                                     cpuFeatureNames(kCpuAllFeatures) + ", all or none)");
+        }
+        if (!(detectCpuFeatures() & feature)) {
+            throw std::runtime_error("CPU feature not supported on this machine: " + name);
+        }
+        features |= feature;
+    }
+    return features;
+}
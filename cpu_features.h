@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * CPU feature detection for kernel dispatch.
+ *
+ * The binary is built for the baseline ISA and carries extra code paths for
+ * newer instruction sets; crypto_kernels binds each kernel to the best path
+ * the detected features allow. Features are a bitmask of CpuFeature values.
+ */
+
+enum CpuFeature : uint32_t {
+    kCpuAvx2 = 1u << 0,
+    kCpuAvx512 = 1u << 1,  // AVX-512 F and VL
+    kCpuShaNi = 1u << 2,   // SHA-256 instructions (with SSE4.1)
+    kCpuSsse3 = 1u << 3
+};
+
+const uint32_t kCpuAllFeatures = kCpuAvx2 | kCpuAvx512 | kCpuShaNi | kCpuSsse3;
+
+// Probes CPUID (and OS support for the wider registers) once per process
+uint32_t detectCpuFeatures();
+
+// Comma-separated names ("avx2,avx512,sha,ssse3"), or "none"
+std::string cpuFeatureNames(uint32_t features);
+
+// Parses a --cpu-features list: "none", "all" or comma-separated names.
+// Throws std::runtime_error on unknown names or features this CPU lacks.
+uint32_t parseCpuFeatures(const std::string& list);
@@ -0,0 +1,921 @@
+#include "crypto_kernels.h"
+#include "cpu_features.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <openssl/crypto.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WG_X86 1
+#endif
+
+namespace {
+
+const uint64_t kSha512Iv[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+const uint64_t kSha512K[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+// One SIMD register holding the same word position of kSha512Lanes messages.
+// GCC/Clang vector extensions let the same round code below compile to either
+// scalar or vector instructions.
+typedef uint64_t LaneWord __attribute__((vector_size(8 * kSha512Lanes)));
+
+// A macro rather than a function: passing vector types by value across a
+// call changes the psABI depending on -mavx, which GCC warns about.
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+// SHA-512 compression over already-decoded message words, generic over the
+// word type so scalar and multi-lane variants share one implementation.
+// Always inlined so each ISA variant below gets its own instruction selection.
+template <typename W>
+__attribute__((always_inline)) inline void compressWords(W state[8], const W block[16]) {
+    W w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = block[i];
+    }
+    for (int i = 16; i < 80; i++) {
+        W s0 = ROTR64(w[i - 15], 1) ^ ROTR64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+        W s1 = ROTR64(w[i - 2], 19) ^ ROTR64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    W a = state[0], b = state[1], c = state[2], d = state[3];
+    W e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 80; i++) {
+        W s1 = ROTR64(e, 14) ^ ROTR64(e, 18) ^ ROTR64(e, 41);
+        W ch = (e & f) ^ (~e & g);
+        W t1 = h + s1 + ch + kSha512K[i] + w[i];
+        W s0 = ROTR64(a, 28) ^ ROTR64(a, 34) ^ ROTR64(a, 39);
+        W maj = (a & b) ^ (a & c) ^ (b & c);
+        W t2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+inline uint64_t loadBe64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+inline void storeBe64(uint8_t* p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+// Hashes data as the continuation of a message whose first prefixLen bytes
+// (a multiple of 128) are already absorbed into state.
+void sha512Finish(uint64_t state[8], uint64_t prefixLen, const uint8_t* data, size_t len, uint8_t out[64]) {
+    uint64_t totalLen = prefixLen + len;
+    while (len >= 128) {
+        sha512Compress(state, data);
+        data += 128;
+        len -= 128;
+    }
+
+    uint8_t block[256] = {0};
+    std::memcpy(block, data, len);
+    block[len] = 0x80;
+    size_t blockLen = (len + 17 <= 128) ? 128 : 256;
+    // Message length in bits; the upper 64 bits of the 128-bit field stay zero
+    storeBe64(block + blockLen - 8, totalLen * 8);
+
+    sha512Compress(state, block);
+    if (blockLen == 256) {
+        sha512Compress(state, block + 128);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        storeBe64(out + 8 * i, state[i]);
+    }
+    OPENSSL_cleanse(block, sizeof(block));
+}
+
+} // namespace
+
+void sha512Init(uint64_t state[8]) {
+    std::memcpy(state, kSha512Iv, sizeof(kSha512Iv));
+}
+
+void sha512Compress(uint64_t state[8], const uint8_t block[128]) {
+    uint64_t w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = loadBe64(block + 8 * i);
+    }
+    compressWords<uint64_t>(state, w);
+}
+
+void sha512CompressLanes(uint64_t state[8][kSha512Lanes], const uint64_t words[16][kSha512Lanes]) {
+    kernels().sha512Lanes(state, words);
+}
+
+void hmacSha512Prepare(HmacSha512Key& key, const uint8_t* keyData, size_t keyLen) {
+    uint8_t k[128] = {0};
+    if (keyLen > 128) {
+        uint64_t state[8];
+        sha512Init(state);
+        sha512Finish(state, 0, keyData, keyLen, k);
+    } else {
+        std::memcpy(k, keyData, keyLen);
+    }
+
+    uint8_t pad[128];
+    for (int i = 0; i < 128; i++) pad[i] = k[i] ^ 0x36;
+    sha512Init(key.inner);
+    sha512Compress(key.inner, pad);
+
+    for (int i = 0; i < 128; i++) pad[i] = k[i] ^ 0x5c;
+    sha512Init(key.outer);
+    sha512Compress(key.outer, pad);
+
+    OPENSSL_cleanse(k, sizeof(k));
+    OPENSSL_cleanse(pad, sizeof(pad));
+}
+
+void hmacSha512(const HmacSha512Key& key, const uint8_t* data, size_t len, uint8_t out[64]) {
+    uint64_t state[8];
+    uint8_t innerHash[64];
+
+    std::memcpy(state, key.inner, sizeof(state));
+    sha512Finish(state, 128, data, len, innerHash);
+
+    std::memcpy(state, key.outer, sizeof(state));
+    sha512Finish(state, 128, innerHash, sizeof(innerHash), out);
+    OPENSSL_cleanse(innerHash, sizeof(innerHash));
+    OPENSSL_cleanse(state, sizeof(state));
+}
+
+void hmacSha512Siblings(const HmacSha512Key& key, const uint8_t* const data[], const size_t lens[],
+                        size_t count, uint8_t* const out[]) {
+    const size_t L = kSha512Lanes;
+    size_t lane[L];
+    size_t used = 0;
+
+    // Inner and outer hash of up to L short messages side by side
+    auto flush = [&]() {
+        if (used == 1) {
+            hmacSha512(key, data[lane[0]], lens[lane[0]], out[lane[0]]);
+            used = 0;
+            return;
+        }
+        uint64_t state[8][L];
+        uint64_t words[16][L];
+        for (size_t l = 0; l < L; l++) {
+            // Idle lanes repeat lane 0
+            size_t m = lane[l < used ? l : 0];
+            uint8_t block[128] = {0};
+            std::memcpy(block, data[m], lens[m]);
+            block[lens[m]] = 0x80;
+            storeBe64(block + 120, (128 + lens[m]) * 8);
+            for (int i = 0; i < 16; i++) words[i][l] = loadBe64(block + 8 * i);
+            for (int i = 0; i < 8; i++) state[i][l] = key.inner[i];
+            OPENSSL_cleanse(block, sizeof(block));
+        }
+        sha512CompressLanes(state, words);
+
+        // Outer message: the 64-byte inner digest plus fixed padding
+        for (size_t l = 0; l < L; l++) {
+            for (int i = 0; i < 8; i++) {
+                words[i][l] = state[i][l];
+                state[i][l] = key.outer[i];
+            }
+            words[8][l] = 0x8000000000000000ULL;
+            for (int i = 9; i < 15; i++) words[i][l] = 0;
+            words[15][l] = (128 + 64) * 8;
+        }
+        sha512CompressLanes(state, words);
+
+        for (size_t l = 0; l < used; l++) {
+            for (int i = 0; i < 8; i++) storeBe64(out[lane[l]] + 8 * i, state[i][l]);
+        }
+        OPENSSL_cleanse(state, sizeof(state));
+        OPENSSL_cleanse(words, sizeof(words));
+        used = 0;
+    };
+
+    for (size_t m = 0; m < count; m++) {
+        if (lens[m] > kHmacSha512SingleBlock) {
+            hmacSha512(key, data[m], lens[m], out[m]);
+            continue;
+        }
+        lane[used++] = m;
+        if (used == L) flush();
+    }
+    if (used > 0) flush();
+}
+
+namespace {
+
+inline void compressGroup(uint64_t state[8][1], const uint64_t block[16][1]) {
+    compressWords<uint64_t>(&state[0][0], &block[0][0]);
+}
+
+inline void compressGroup(uint64_t state[8][kSha512Lanes], const uint64_t block[16][kSha512Lanes]) {
+    sha512CompressLanes(state, block);
+}
+
+// PBKDF2-HMAC-SHA512 (64-byte output) for L inputs side by side
+template <size_t L>
+void pbkdf2Group(const std::string* const passwords[L], const std::string* const salts[L],
+                 uint32_t iterations, uint8_t* const out[L]) {
+    uint64_t inner[8][L], outer[8][L];
+    uint64_t u[8][L], t[8][L];
+
+    // Per-lane setup: key midstates and U1 = HMAC(P, S || INT(1))
+    for (size_t lane = 0; lane < L; lane++) {
+        HmacSha512Key key;
+        hmacSha512Prepare(key, reinterpret_cast<const uint8_t*>(passwords[lane]->data()), passwords[lane]->size());
+
+        std::string salt = *salts[lane];
+        salt.append("\x00\x00\x00\x01", 4);
+        uint8_t u1[64];
+        hmacSha512(key, reinterpret_cast<const uint8_t*>(salt.data()), salt.size(), u1);
+
+        for (int i = 0; i < 8; i++) {
+            inner[i][lane] = key.inner[i];
+            outer[i][lane] = key.outer[i];
+            u[i][lane] = t[i][lane] = loadBe64(u1 + 8 * i);
+        }
+        OPENSSL_cleanse(u1, sizeof(u1));
+        OPENSSL_cleanse(&key, sizeof(key));
+        OPENSSL_cleanse(&salt[0], salt.size());
+    }
+
+    // U_i = HMAC(P, U_{i-1}). Both the inner and the outer message are a
+    // single 64-byte digest, so every block has the same fixed padding.
+    uint64_t block[16][L];
+    for (size_t lane = 0; lane < L; lane++) {
+        block[8][lane] = 0x8000000000000000ULL;
+        for (int i = 9; i < 15; i++) block[i][lane] = 0;
+        block[15][lane] = (128 + 64) * 8;
+    }
+
+    uint64_t state[8][L];
+    for (uint32_t iter = 1; iter < iterations; iter++) {
+        std::memcpy(block, u, sizeof(u));
+        std::memcpy(state, inner, sizeof(state));
+        compressGroup(state, block);
+
+        std::memcpy(block, state, sizeof(state));
+        std::memcpy(state, outer, sizeof(state));
+        compressGroup(state, block);
+
+        std::memcpy(u, state, sizeof(u));
+        for (int i = 0; i < 8; i++) {
+            for (size_t lane = 0; lane < L; lane++) {
+                t[i][lane] ^= u[i][lane];
+            }
+        }
+    }
+
+    for (size_t lane = 0; lane < L; lane++) {
+        if (!out[lane]) continue;
+        for (int i = 0; i < 8; i++) {
+            storeBe64(out[lane] + 8 * i, t[i][lane]);
+        }
+    }
+
+    OPENSSL_cleanse(inner, sizeof(inner));
+    OPENSSL_cleanse(outer, sizeof(outer));
+    OPENSSL_cleanse(u, sizeof(u));
+    OPENSSL_cleanse(t, sizeof(t));
+    OPENSSL_cleanse(block, sizeof(block));
+    OPENSSL_cleanse(state, sizeof(state));
+}
+
+} // namespace
+
+std::vector<SecureBytes> pbkdf2Sha512Batch(const std::vector<std::string>& passwords,
+                                           const std::vector<std::string>& salts,
+                                           uint32_t iterations) {
+    if (passwords.size() != salts.size()) {
+        throw std::runtime_error("pbkdf2Sha512Batch: passwords and salts differ in length");
+    }
+    if (iterations == 0) {
+        throw std::runtime_error("pbkdf2Sha512Batch: iterations must be positive");
+    }
+
+    const size_t L = kSha512Lanes;
+    std::vector<SecureBytes> results(passwords.size(), SecureBytes(64));
+
+    size_t base = 0;
+    // A lone leftover input runs on the scalar path; a partial group of two
+    // or more still goes through the lanes, with idle lanes repeating lane 0
+    while (base < passwords.size() && passwords.size() - base >= 2) {
+        const std::string* p[L];
+        const std::string* s[L];
+        uint8_t* out[L];
+        for (size_t lane = 0; lane < L; lane++) {
+            bool used = base + lane < passwords.size();
+            p[lane] = &passwords[used ? base + lane : base];
+            s[lane] = &salts[used ? base + lane : base];
+            out[lane] = used ? results[base + lane].data() : nullptr;
+        }
+        pbkdf2Group<L>(p, s, iterations, out);
+        base += L;
+    }
+    if (base < passwords.size()) {
+        const std::string* p[1] = {&passwords[base]};
+        const std::string* s[1] = {&salts[base]};
+        uint8_t* out[1] = {results[base].data()};
+        pbkdf2Group<1>(p, s, iterations, out);
+    }
+
+    return results;
+}
+
+// ---------------------------------------------------------------------------
+// Dispatched kernels. Each has a baseline variant plus, where it pays off,
+// variants compiled for newer instruction sets with target attributes; the
+// translation unit itself is still built for the baseline ISA.
+
+namespace {
+
+// The same multi-lane round code, compiled three times
+#define SHA512_LANES_BODY                        \
+    LaneWord s[8];                               \
+    LaneWord w[16];                              \
+    std::memcpy(s, state, sizeof(s));            \
+    std::memcpy(w, words, sizeof(w));            \
+    compressWords<LaneWord>(s, w);               \
+    std::memcpy(state, s, sizeof(s));
+
+void sha512LanesGeneric(uint64_t state[8][kSha512Lanes], const uint64_t words[16][kSha512Lanes]) {
+    SHA512_LANES_BODY
+}
+
+#ifdef WG_X86
+__attribute__((target("avx2")))
+void sha512LanesAvx2(uint64_t state[8][kSha512Lanes], const uint64_t words[16][kSha512Lanes]) {
+    SHA512_LANES_BODY
+}
+
+// AVX-512VL adds 256-bit rotates (vprolq), which the round functions are full of
+__attribute__((target("avx512f,avx512vl")))
+void sha512LanesAvx512(uint64_t state[8][kSha512Lanes], const uint64_t words[16][kSha512Lanes]) {
+    SHA512_LANES_BODY
+}
+#endif
+
+#undef SHA512_LANES_BODY
+
+const uint32_t kSha256Iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const uint32_t kSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotr32(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+inline uint32_t rotl32(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+inline uint64_t rotl64(uint64_t x, int n) { return (x << n) | (x >> (64 - n)); }
+
+inline uint32_t loadBe32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+inline uint32_t loadLe32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline void storeBe32(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v >> 24); p[1] = uint8_t(v >> 16); p[2] = uint8_t(v >> 8); p[3] = uint8_t(v);
+}
+
+inline void storeLe32(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); p[2] = uint8_t(v >> 16); p[3] = uint8_t(v >> 24);
+}
+
+void sha256BlocksGeneric(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    for (; blocks > 0; blocks--, data += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) w[i] = loadBe32(data + 4 * i);
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) +
+                          kSha256K[i] + w[i];
+            uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#ifdef WG_X86
+// SHA-NI keeps the state as ABEF/CDGH register pairs and runs two rounds per
+// sha256rnds2; the message schedule is sha256msg1/msg2 over four-word groups.
+__attribute__((target("sha,sse4.1")))
+void sha256BlocksShaNi(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i dcba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    __m128i hgfe = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+    __m128i cdab = _mm_shuffle_epi32(dcba, 0xB1);
+    __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1B);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+    for (; blocks > 0; blocks--, data += 64) {
+        __m128i msg[16];
+        for (int g = 0; g < 4; g++) {
+            msg[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * g)), byteSwap);
+        }
+        for (int g = 4; g < 16; g++) {
+            __m128i x = _mm_sha256msg1_epu32(msg[g - 4], msg[g - 3]);
+            x = _mm_add_epi32(x, _mm_alignr_epi8(msg[g - 1], msg[g - 2], 4));
+            msg[g] = _mm_sha256msg2_epu32(x, msg[g - 1]);
+        }
+
+        __m128i abefSaved = abef;
+        __m128i cdghSaved = cdgh;
+        for (int g = 0; g < 16; g++) {
+            __m128i wk = _mm_add_epi32(msg[g], _mm_loadu_si128(reinterpret_cast<const __m128i*>(kSha256K + 4 * g)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(wk, 0x0E));
+        }
+        abef = _mm_add_epi32(abef, abefSaved);
+        cdgh = _mm_add_epi32(cdgh, cdghSaved);
+    }
+
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    dcba = _mm_blend_epi16(feba, dchg, 0xF0);
+    hgfe = _mm_alignr_epi8(dchg, feba, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), dcba);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), hgfe);
+}
+#endif
+
+// Padding and length are the same for every compression variant
+template <void (*Blocks)(uint32_t*, const uint8_t*, size_t)>
+void sha256With(const uint8_t* data, size_t len, uint8_t out[32]) {
+    uint32_t state[8];
+    std::memcpy(state, kSha256Iv, sizeof(state));
+    size_t full = len / 64;
+    if (full > 0) Blocks(state, data, full);
+
+    uint8_t tail[128] = {0};
+    size_t rest = len - full * 64;
+    std::memcpy(tail, data + full * 64, rest);
+    tail[rest] = 0x80;
+    size_t tailLen = rest + 9 <= 64 ? 64 : 128;
+    storeBe64(tail + tailLen - 8, static_cast<uint64_t>(len) * 8);
+    Blocks(state, tail, tailLen / 64);
+
+    for (int i = 0; i < 8; i++) storeBe32(out + 4 * i, state[i]);
+    OPENSSL_cleanse(tail, sizeof(tail));
+}
+
+// RIPEMD-160: two parallel lines of 80 rounds over little-endian words
+const uint8_t kRmdWordLeft[80] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+    3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+    1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+    4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13
+};
+const uint8_t kRmdWordRight[80] = {
+    5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+    6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+    15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+    8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+    12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11
+};
+const uint8_t kRmdShiftLeft[80] = {
+    11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+    7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+    11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+    11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+    9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6
+};
+const uint8_t kRmdShiftRight[80] = {
+    8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+    9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+    9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+    15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+    8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11
+};
+const uint32_t kRmdConstLeft[5] = {0x00000000, 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xa953fd4e};
+const uint32_t kRmdConstRight[5] = {0x50a28be6, 0x5c4dd124, 0x6d703ef3, 0x7a6d76e9, 0x00000000};
+
+inline uint32_t rmdF(int round, uint32_t x, uint32_t y, uint32_t z) {
+    switch (round) {
+        case 0: return x ^ y ^ z;
+        case 1: return (x & y) | (~x & z);
+        case 2: return (x | ~y) ^ z;
+        case 3: return (x & z) | (y & ~z);
+        default: return x ^ (y | ~z);
+    }
+}
+
+void ripemd160Compress(uint32_t h[5], const uint8_t block[64]) {
+    uint32_t x[16];
+    for (int i = 0; i < 16; i++) x[i] = loadLe32(block + 4 * i);
+
+    uint32_t al = h[0], bl = h[1], cl = h[2], dl = h[3], el = h[4];
+    uint32_t ar = al, br = bl, cr = cl, dr = dl, er = el;
+    for (int j = 0; j < 80; j++) {
+        int round = j / 16;
+        uint32_t t = rotl32(al + rmdF(round, bl, cl, dl) + x[kRmdWordLeft[j]] + kRmdConstLeft[round],
+                            kRmdShiftLeft[j]) + el;
+        al = el; el = dl; dl = rotl32(cl, 10); cl = bl; bl = t;
+
+        t = rotl32(ar + rmdF(4 - round, br, cr, dr) + x[kRmdWordRight[j]] + kRmdConstRight[round],
+                   kRmdShiftRight[j]) + er;
+        ar = er; er = dr; dr = rotl32(cr, 10); cr = br; br = t;
+    }
+
+    uint32_t t = h[1] + cl + dr;
+    h[1] = h[2] + dl + er;
+    h[2] = h[3] + el + ar;
+    h[3] = h[4] + al + br;
+    h[4] = h[0] + bl + cr;
+    h[0] = t;
+}
+
+void ripemd160Generic(const uint8_t* data, size_t len, uint8_t out[20]) {
+    uint32_t h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    size_t full = len / 64;
+    for (size_t i = 0; i < full; i++) ripemd160Compress(h, data + 64 * i);
+
+    uint8_t tail[128] = {0};
+    size_t rest = len - full * 64;
+    std::memcpy(tail, data + full * 64, rest);
+    tail[rest] = 0x80;
+    size_t tailLen = rest + 9 <= 64 ? 64 : 128;
+    uint64_t bits = static_cast<uint64_t>(len) * 8;
+    storeLe32(tail + tailLen - 8, static_cast<uint32_t>(bits));
+    storeLe32(tail + tailLen - 4, static_cast<uint32_t>(bits >> 32));
+    ripemd160Compress(h, tail);
+    if (tailLen == 128) ripemd160Compress(h, tail + 64);
+
+    for (int i = 0; i < 5; i++) storeLe32(out + 4 * i, h[i]);
+    OPENSSL_cleanse(tail, sizeof(tail));
+}
+
+const uint64_t kKeccakRoundConstants[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+// Rotation offset of each lane (index x + 5y) in the rho step
+const int kKeccakRho[25] = {
+    0, 1, 62, 28, 27,
+    36, 44, 6, 55, 20,
+    3, 10, 43, 25, 39,
+    41, 45, 15, 21, 8,
+    18, 2, 61, 56, 14
+};
+
+// Straight-line rounds: every index below is a compile-time constant once
+// the loops are unrolled
+void keccakF1600(uint64_t st[25]) {
+    for (int round = 0; round < 24; round++) {
+        uint64_t c[5], d[5], b[25];
+#pragma GCC unroll 5
+        for (int x = 0; x < 5; x++) c[x] = st[x] ^ st[x + 5] ^ st[x + 10] ^ st[x + 15] ^ st[x + 20];
+#pragma GCC unroll 5
+        for (int x = 0; x < 5; x++) d[x] = c[(x + 4) % 5] ^ rotl64(c[(x + 1) % 5], 1);
+
+        // theta, then rho and pi: lane (x, y) moves to (y, 2x + 3y)
+#pragma GCC unroll 25
+        for (int i = 0; i < 25; i++) {
+            int x = i % 5, y = i / 5;
+            uint64_t lane = st[i] ^ d[x];
+            b[y + 5 * ((2 * x + 3 * y) % 5)] = kKeccakRho[i] ? rotl64(lane, kKeccakRho[i]) : lane;
+        }
+
+#pragma GCC unroll 25
+        for (int i = 0; i < 25; i++) {
+            int x = i % 5, row = i - x;
+            st[i] = b[i] ^ (~b[row + (x + 1) % 5] & b[row + (x + 2) % 5]);
+        }
+        st[0] ^= kKeccakRoundConstants[round];
+    }
+}
+
+// SHA3-256: rate 136 bytes, domain padding 0x06
+void sha3_256Generic(const uint8_t* data, size_t len, uint8_t out[32]) {
+    const size_t rate = 136;
+    uint64_t st[25] = {0};
+    auto absorb = [&](const uint8_t* block) {
+        for (size_t i = 0; i < rate / 8; i++) {
+            uint64_t lane = 0;
+            for (int b = 7; b >= 0; b--) lane = (lane << 8) | block[8 * i + b];
+            st[i] ^= lane;
+        }
+        keccakF1600(st);
+    };
+
+    for (; len >= rate; data += rate, len -= rate) absorb(data);
+    uint8_t block[136] = {0};
+    std::memcpy(block, data, len);
+    block[len] ^= 0x06;
+    block[rate - 1] ^= 0x80;
+    absorb(block);
+
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 8; b++) out[8 * i + b] = static_cast<uint8_t>(st[i] >> (8 * b));
+    }
+    OPENSSL_cleanse(block, sizeof(block));
+    OPENSSL_cleanse(st, sizeof(st));
+}
+
+void hexEncodeGeneric(const uint8_t* data, size_t len, char* out) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+}
+
+bool hexDecodeGeneric(const char* hex, size_t len, uint8_t* out) {
+    auto nibble = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < len; i++) {
+        int hi = nibble(hex[2 * i]), lo = nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
+
+#ifdef WG_X86
+// Nibbles become digits through a 16-entry shuffle table, and the digit
+// vectors of the high and low nibbles are interleaved into output order.
+// The tail shorter than a vector goes through the generic code.
+
+__attribute__((target("ssse3")))
+void hexEncodeSsse3(const uint8_t* data, size_t len, char* out) {
+    const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                         '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+        __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    hexEncodeGeneric(data + i, len - i, out + 2 * i);
+}
+
+__attribute__((target("avx2")))
+void hexEncodeAvx2(const uint8_t* data, size_t len, char* out) {
+    const __m256i digits = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                            '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+                                            '0', '1', '2', '3', '4', '5', '6', '7',
+                                            '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), mask));
+        __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, mask));
+        // Unpacking works within 128-bit lanes: bytes 0-7 and 16-23 in one
+        // vector, 8-15 and 24-31 in the other
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    hexEncodeSsse3(data + i, len - i, out + 2 * i);
+}
+
+// Value of each digit; bytes that are not hex digits are set in invalid. c - '0' in 0..9 and (c | 0x20) - 'a' in 0..5 are tested as
+// signed bytes, which holds for every c because the subtraction wraps.
+__attribute__((target("ssse3")))
+inline __m128i hexValuesSsse3(__m128i chars, __m128i& invalid) {
+    const __m128i minusOne = _mm_set1_epi8(-1);
+    __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(digit, minusOne), _mm_cmpgt_epi8(_mm_set1_epi8(10), digit));
+    __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(letter, minusOne), _mm_cmpgt_epi8(_mm_set1_epi8(6), letter));
+    invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(isDigit, isLetter), minusOne));
+    return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                        _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+__attribute__((target("avx2")))
+inline __m256i hexValuesAvx2(__m256i chars, __m256i& invalid) {
+    const __m256i minusOne = _mm256_set1_epi8(-1);
+    __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i letter = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(digit, minusOne), _mm256_cmpgt_epi8(_mm256_set1_epi8(10), digit));
+    __m256i isLetter = _mm256_and_si256(_mm256_cmpgt_epi8(letter, minusOne), _mm256_cmpgt_epi8(_mm256_set1_epi8(6), letter));
+    invalid = _mm256_or_si256(invalid, _mm256_andnot_si256(_mm256_or_si256(isDigit, isLetter), minusOne));
+    return _mm256_or_si256(_mm256_and_si256(isDigit, digit),
+                           _mm256_and_si256(isLetter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+}
+
+// Pairs of digit values are joined by a multiply-add (high * 16 + low) into
+// 16-bit words, then packed back to bytes
+__attribute__((target("ssse3")))
+bool hexDecodeSsse3(const char* hex, size_t len, uint8_t* out) {
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    __m128i invalid = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i first = hexValuesSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + 2 * i)), invalid);
+        __m128i second = hexValuesSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + 2 * i + 16)), invalid);
+        __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+    }
+    return _mm_movemask_epi8(invalid) == 0 && hexDecodeGeneric(hex + 2 * i, len - i, out + i);
+}
+
+__attribute__((target("avx2")))
+bool hexDecodeAvx2(const char* hex, size_t len, uint8_t* out) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    __m256i invalid = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i first = hexValuesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hex + 2 * i)), invalid);
+        __m256i second = hexValuesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hex + 2 * i + 32)), invalid);
+        // Packing interleaves the 128-bit lanes of its inputs; restore the order
+        __m256i bytes = _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights), _mm256_maddubs_epi16(second, weights));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permute4x64_epi64(bytes, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    return _mm256_movemask_epi8(invalid) == 0 && hexDecodeSsse3(hex + 2 * i, len - i, out + i);
+}
+#endif
+
+// Byte order as the generator has always encoded: data[len - 1] is the most
+// significant byte, and a number whose top byte is zero encodes to nothing.
+// Each zero byte at the front adds a leading '1'.
+std::string base58EncodeGeneric(const uint8_t* data, size_t len) {
+    static const char alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    SecureBytes temp(data, data + len);
+    std::string digits;
+    digits.reserve(len * 138 / 100 + 1);
+
+    size_t size = temp.size();
+    while (size > 0 && temp[size - 1] != 0) {
+        int remainder = 0;
+        for (size_t i = size; i-- > 0;) {
+            int current = remainder * 256 + temp[i];
+            temp[i] = static_cast<uint8_t>(current / 58);
+            remainder = current % 58;
+        }
+        digits.push_back(alphabet[remainder]);
+        while (size > 0 && temp[size - 1] == 0) size--;
+    }
+
+    size_t zeros = 0;
+    while (zeros < len && data[zeros] == 0) zeros++;
+    return std::string(zeros, '1') + std::string(digits.rbegin(), digits.rend());
+}
+
+KernelTable bindKernels(uint32_t features) {
+    KernelTable table;
+    table.features = features;
+    table.sha256 = sha256With<sha256BlocksGeneric>;
+    table.sha256Name = "generic";
+    table.sha512Lanes = sha512LanesGeneric;
+    table.sha512LanesName = "generic";
+    table.ripemd160 = ripemd160Generic;
+    table.ripemd160Name = "generic";
+    table.sha3_256 = sha3_256Generic;
+    table.sha3_256Name = "generic";
+    table.hexEncode = hexEncodeGeneric;
+    table.hexEncodeName = "generic";
+    table.hexDecode = hexDecodeGeneric;
+    table.hexDecodeName = "generic";
+    table.base58Encode = base58EncodeGeneric;
+    table.base58EncodeName = "generic";
+
+#ifdef WG_X86
+    if (features & kCpuShaNi) {
+        table.sha256 = sha256With<sha256BlocksShaNi>;
+        table.sha256Name = "sha";
+    }
+    if (features & kCpuAvx512) {
+        table.sha512Lanes = sha512LanesAvx512;
+        table.sha512LanesName = "avx512";
+    } else if (features & kCpuAvx2) {
+        table.sha512Lanes = sha512LanesAvx2;
+        table.sha512LanesName = "avx2";
+    }
+    if (features & kCpuAvx2) {
+        table.hexEncode = hexEncodeAvx2;
+        table.hexEncodeName = "avx2";
+        table.hexDecode = hexDecodeAvx2;
+        table.hexDecodeName = "avx2";
+    } else if (features & kCpuSsse3) {
+        table.hexEncode = hexEncodeSsse3;
+        table.hexEncodeName = "ssse3";
+        table.hexDecode = hexDecodeSsse3;
+        table.hexDecodeName = "ssse3";
+    }
+#endif
+    return table;
+}
+
+KernelTable& activeKernels() {
+    static KernelTable table = bindKernels(detectCpuFeatures());
+    return table;
+}
+
+} // namespace
+
+void hexEncodeColumn(const uint8_t* const fields[], size_t count, size_t len, char* out) {
+    void (*encode)(const uint8_t*, size_t, char*) = kernels().hexEncode;
+    uint8_t block[4096];
+    if (len == 0 || len > sizeof(block)) {
+        for (size_t i = 0; i < count; i++) encode(fields[i], len, out + 2 * len * i);
+        return;
+    }
+
+    // Hex is positional, so a gathered block encodes to the fields' output back to back
+    const size_t perBlock = sizeof(block) / len;
+    for (size_t first = 0; first < count; first += perBlock) {
+        size_t n = count - first < perBlock ? count - first : perBlock;
+        for (size_t i = 0; i < n; i++) std::memcpy(block + len * i, fields[first + i], len);
+        encode(block, len * n, out + 2 * len * first);
+    }
+    OPENSSL_cleanse(block, sizeof(block));  // private key columns pass through here
+}
+
+const KernelTable& kernels() {
+    return activeKernels();
+}
+
+void selectKernels(uint32_t features) {
+    activeKernels() = bindKernels(features & detectCpuFeatures());
+}
+
+std::string kernelReport() {
+    const KernelTable& table = kernels();
+    return std::string("sha256=") + table.sha256Name +
+           " sha512=" + table.sha512LanesName +
+           " ripemd160=" + table.ripemd160Name +
+           " sha3_256=" + table.sha3_256Name +
+           " hex=" + table.hexEncodeName +
+           " unhex=" + table.hexDecodeName +
+           " base58=" + table.base58EncodeName;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "secure_memory.h"
+
+/**
+ * Hash and encoding kernels used on the hot paths of the generator.
+ *
+ * The SHA-512 code here exists so that many independent HMAC/PBKDF2
+ * computations can run side by side: the multi-lane compression function
+ * processes kSha512Lanes messages per pass, one message per SIMD lane.
+ *
+ * Kernels with ISA-specific variants are reached through kernels(), a table
+ * of function pointers bound once from the CPU features (cpu_features.h).
+ */
+
+// Number of independent SHA-512 messages processed per multi-lane pass
+const size_t kSha512Lanes = 4;
+
+void sha512Init(uint64_t state[8]);
+void sha512Compress(uint64_t state[8], const uint8_t block[128]);
+
+// Compresses one 16-word block per lane. Words are already big-endian decoded.
+void sha512CompressLanes(uint64_t state[8][kSha512Lanes], const uint64_t words[16][kSha512Lanes]);
+
+// HMAC-SHA512 key with the ipad/opad blocks already absorbed
+struct HmacSha512Key {
+    uint64_t inner[8];
+    uint64_t outer[8];
+};
+
+void hmacSha512Prepare(HmacSha512Key& key, const uint8_t* keyData, size_t keyLen);
+void hmacSha512(const HmacSha512Key& key, const uint8_t* data, size_t len, uint8_t out[64]);
+
+// Longest message whose HMAC inner hash is one block past the ipad midstate
+const size_t kHmacSha512SingleBlock = 111;
+
+// HMAC-SHA512 of count messages under one prepared key (sibling derivations
+// share the parent's key). Messages of up to kHmacSha512SingleBlock bytes run
+// kSha512Lanes per pass, two compressions each; longer ones run one by one.
+void hmacSha512Siblings(const HmacSha512Key& key, const uint8_t* const data[], const size_t lens[],
+                        size_t count, uint8_t* const out[]);
+
+// PBKDF2-HMAC-SHA512 with a 64-byte output for each (password, salt) pair.
+// Inputs are processed kSha512Lanes at a time.
+std::vector<SecureBytes> pbkdf2Sha512Batch(const std::vector<std::string>& passwords,
+                                                    const std::vector<std::string>& salts,
+                                                    uint32_t iterations);
+
+// Function pointers bound to the best variant for the selected CPU features
+struct KernelTable {
+    uint32_t features;  // CpuFeature bits the table was bound for
+
+    void (*sha256)(const uint8_t* data, size_t len, uint8_t out[32]);
+    void (*sha512Lanes)(uint64_t state[8][kSha512Lanes], const uint64_t words[16][kSha512Lanes]);
+    void (*ripemd160)(const uint8_t* data, size_t len, uint8_t out[20]);
+    // Keccak-f[1600] sponge with SHA3 padding, as WalletGenerator::keccak256 has always produced
+    void (*sha3_256)(const uint8_t* data, size_t len, uint8_t out[32]);
+    void (*hexEncode)(const uint8_t* data, size_t len, char* out);  // writes 2 * len chars
+    // Reads 2 * len digits of either case; false if any is not a hex digit
+    bool (*hexDecode)(const char* hex, size_t len, uint8_t* out);
+    std::string (*base58Encode)(const uint8_t* data, size_t len);
+
+    // Variant bound to each slot ("generic", "avx2", ...)
+    const char* sha256Name;
+    const char* sha512LanesName;
+    const char* ripemd160Name;
+    const char* sha3_256Name;
+    const char* hexEncodeName;
+    const char* hexDecodeName;
+    const char* base58EncodeName;
+};
+
+// Hex of count fields of len bytes each (a column of keys), written back to
+// back, 2 * len chars per field. The fields are gathered into a 4 KiB stack
+// block, wiped afterwards, so the bound kernel makes one call per block
+// rather than one per short field; a column that fits runs in a single call.
+void hexEncodeColumn(const uint8_t* const fields[], size_t count, size_t len, char* out);
+
+// Bound from detectCpuFeatures() on first use
+const KernelTable& kernels();
+
+// Rebinds every slot for a subset of the detected features (--cpu-features).
+// Not synchronized: call before any worker threads start.
+void selectKernels(uint32_t features);
+
+// "sha256=sha sha512=avx512 ..." for --version
+std::string kernelReport();
@@ -0,0 +1,899 @@
+#include "ec_backend.h"
+#include "windows/minimal_secp256k1.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <openssl/crypto.h>
+#ifndef USE_MINIMAL_SECP256K1
+#include <secp256k1.h>
+#endif
+
+#if defined(__SIZEOF_INT128__)
+#define WALLETGEN_NATIVE_EC 1
+#else
+#define WALLETGEN_NATIVE_EC 0
+#endif
+
+#if WALLETGEN_NATIVE_EC && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char* const kLibsecpName = "libsecp256k1";
+const char* const kOpensslName = "openssl";
+const char* const kNativeName = "native";
+
+// Big-endian scalar below the curve order n, without early exits
+bool scalarBelowOrder(const uint8_t* scalar) {
+    static const uint8_t kOrder[32] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+        0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B, 0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41
+    };
+    int less = 0, greater = 0;
+    for (int i = 0; i < 32; i++) {
+        int lt = scalar[i] < kOrder[i];
+        int gt = scalar[i] > kOrder[i];
+        less |= lt & !greater;
+        greater |= gt & !less;
+    }
+    return less != 0;
+}
+
+bool scalarIsZero(const uint8_t* scalar) {
+    uint8_t bits = 0;
+    for (int i = 0; i < 32; i++) bits |= scalar[i];
+    return bits == 0;
+}
+
+#ifndef USE_MINIMAL_SECP256K1
+// Process-wide secp256k1 context, created on first use and never modified
+// afterwards, so all backend instances and threads can share it
+struct SharedSecpContext {
+    secp256k1_context* ctx;
+
+    SharedSecpContext() : ctx(secp256k1_context_create(SECP256K1_CONTEXT_SIGN)) {
+        if (!ctx) {
+            throw std::runtime_error("Failed to create secp256k1 context");
+        }
+    }
+
+    ~SharedSecpContext() {
+        secp256k1_context_destroy(ctx);
+    }
+};
+
+const secp256k1_context* sharedSecpContext() {
+    static SharedSecpContext shared;
+    return shared.ctx;
+}
+
+class LibsecpEcBackend : public EcBackend {
+public:
+    LibsecpEcBackend() : ctx(sharedSecpContext()) {}
+
+    const char* name() const override { return kLibsecpName; }
+
+    bool pubkeyCreate(const uint8_t privateKey[32], EcPubkey& pubkey) override {
+        secp256k1_pubkey key;
+        if (!secp256k1_ec_pubkey_create(ctx, &key, privateKey)) return false;
+        store(key, pubkey);
+        return true;
+    }
+
+    bool pubkeyTweakAdd(EcPubkey& pubkey, const uint8_t tweak[32]) override {
+        uint8_t encoded[65];
+        encoded[0] = 0x04;
+        std::memcpy(encoded + 1, pubkey.xy, 64);
+        secp256k1_pubkey key;
+        if (!scalarBelowOrder(tweak) || !secp256k1_ec_pubkey_parse(ctx, &key, encoded, sizeof(encoded))) return false;
+        if (scalarIsZero(tweak)) return true;
+        if (!secp256k1_ec_pubkey_tweak_add(ctx, &key, tweak)) return false;
+        store(key, pubkey);
+        return true;
+    }
+
+private:
+    const secp256k1_context* ctx;
+
+    void store(const secp256k1_pubkey& key, EcPubkey& pubkey) {
+        uint8_t encoded[65];
+        size_t len = sizeof(encoded);
+        secp256k1_ec_pubkey_serialize(ctx, encoded, &len, &key, SECP256K1_EC_UNCOMPRESSED);
+        std::memcpy(pubkey.xy, encoded + 1, 64);
+    }
+};
+#endif
+
+// OpenSSL EC_POINT arithmetic; k * G through the minimal_secp256k1 comb
+class OpensslEcBackend : public EcBackend {
+public:
+    OpensslEcBackend() {
+        sum = EC_POINT_new(ctx.group);
+        addend = EC_POINT_new(ctx.group);
+        if (!sum || !addend) {
+            EC_POINT_free(sum);
+            throw std::runtime_error("Failed to initialize OpenSSL EC backend");
+        }
+    }
+
+    ~OpensslEcBackend() override {
+        EC_POINT_clear_free(addend);
+        EC_POINT_clear_free(sum);
+    }
+
+    const char* name() const override { return kOpensslName; }
+
+    bool pubkeyCreate(const uint8_t privateKey[32], EcPubkey& pubkey) override {
+        uint8_t encoded[65];
+        if (!minimal_secp256k1_create_public_key(&ctx, privateKey, encoded)) return false;
+        std::memcpy(pubkey.xy, encoded + 1, 64);
+        return true;
+    }
+
+    bool pubkeyTweakAdd(EcPubkey& pubkey, const uint8_t tweak[32]) override {
+        // set_affine_coordinates rejects points off the curve
+        if (!scalarBelowOrder(tweak) || !setPoint(sum, pubkey.xy)) return false;
+        if (scalarIsZero(tweak)) return true;
+
+        uint8_t encoded[65];
+        bool ok = minimal_secp256k1_create_public_key(&ctx, tweak, encoded) && setPoint(addend, encoded + 1) &&
+                  EC_POINT_add(ctx.group, sum, sum, addend, ctx.bn_ctx) && !EC_POINT_is_at_infinity(ctx.group, sum) &&
+                  EC_POINT_get_affine_coordinates(ctx.group, sum, ctx.x, ctx.y, ctx.bn_ctx) &&
+                  BN_bn2binpad(ctx.x, pubkey.xy, 32) == 32 && BN_bn2binpad(ctx.y, pubkey.xy + 32, 32) == 32;
+        OPENSSL_cleanse(encoded, sizeof(encoded));
+        return ok;
+    }
+
+private:
+    MinimalSecp256k1Context ctx;
+    EC_POINT* sum = nullptr;
+    EC_POINT* addend = nullptr;
+
+    bool setPoint(EC_POINT* point, const uint8_t* xy) {
+        return BN_bin2bn(xy, 32, ctx.x) && BN_bin2bn(xy + 32, 32, ctx.y) &&
+               EC_POINT_set_affine_coordinates(ctx.group, point, ctx.x, ctx.y, ctx.bn_ctx);
+    }
+};
+
+#if WALLETGEN_NATIVE_EC
+namespace native {
+
+__extension__ typedef unsigned __int128 u128;  // __extension__: no -pedantic warning
+
+// Field element mod p = 2^256 - 2^32 - 977: little-endian 64-bit limbs,
+// always fully reduced
+struct Fe {
+    uint64_t n[4];
+};
+
+const uint64_t kC = 0x1000003D1ULL;  // 2^256 - p
+
+// carry * 2^256 + a, known to be below 2p, reduced mod p
+inline void feReduceOnce(Fe& a, uint64_t carry) {
+    // a - p = a + C - 2^256, so a + C overflowing means a >= p
+    Fe t;
+    u128 s = (u128)a.n[0] + kC;
+    t.n[0] = (uint64_t)s;
+    for (int i = 1; i < 4; i++) {
+        s = (u128)a.n[i] + (uint64_t)(s >> 64);
+        t.n[i] = (uint64_t)s;
+    }
+    uint64_t mask = 0 - (carry | (uint64_t)(s >> 64));
+    for (int i = 0; i < 4; i++) a.n[i] = (t.n[i] & mask) | (a.n[i] & ~mask);
+}
+
+inline void feAdd(Fe& r, const Fe& a, const Fe& b) {
+    u128 s = 0;
+    for (int i = 0; i < 4; i++) {
+        s = (u128)a.n[i] + b.n[i] + (uint64_t)(s >> 64);
+        r.n[i] = (uint64_t)s;
+    }
+    feReduceOnce(r, (uint64_t)(s >> 64));
+}
+
+inline void feSub(Fe& r, const Fe& a, const Fe& b) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        u128 d = (u128)a.n[i] - b.n[i] - borrow;
+        r.n[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    // On borrow r = a - b + 2^256; adding p is subtracting C mod 2^256
+    uint64_t c = kC & (0 - borrow);
+    borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        u128 d = (u128)r.n[i] - (i == 0 ? c : 0) - borrow;
+        r.n[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+}
+
+inline void feMul(Fe& r, const Fe& a, const Fe& b) {
+    uint64_t t[8] = {0};
+    for (int i = 0; i < 4; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 4; j++) {
+            u128 p = (u128)a.n[i] * b.n[j] + t[i + j] + carry;
+            t[i + j] = (uint64_t)p;
+            carry = (uint64_t)(p >> 64);
+        }
+        t[i + 4] = carry;
+    }
+
+    // 2^256 = C mod p: fold the high half in twice
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; i++) {
+        u128 p = (u128)t[4 + i] * kC + t[i] + carry;
+        r.n[i] = (uint64_t)p;
+        carry = (uint64_t)(p >> 64);
+    }
+    u128 p = (u128)carry * kC + r.n[0];
+    r.n[0] = (uint64_t)p;
+    for (int i = 1; i < 4; i++) {
+        p = (u128)r.n[i] + (uint64_t)(p >> 64);
+        r.n[i] = (uint64_t)p;
+    }
+    feReduceOnce(r, (uint64_t)(p >> 64));
+}
+
+inline void feSqr(Fe& r, const Fe& a) {
+    feMul(r, a, a);
+}
+
+inline void feSqrN(Fe& r, const Fe& a, int n) {
+    r = a;
+    for (int i = 0; i < n; i++) feSqr(r, r);
+}
+
+inline bool feIsZero(const Fe& a) {
+    return (a.n[0] | a.n[1] | a.n[2] | a.n[3]) == 0;
+}
+
+inline bool feEqual(const Fe& a, const Fe& b) {
+    return ((a.n[0] ^ b.n[0]) | (a.n[1] ^ b.n[1]) | (a.n[2] ^ b.n[2]) | (a.n[3] ^ b.n[3])) == 0;
+}
+
+// a^(p-2). The 1-bits of p - 2 form blocks of 223, 22, 2 and 1 (twice);
+// 2^k - 1 powers for those block lengths come from an addition chain.
+void feInv(Fe& r, const Fe& a) {
+    Fe x2, x3, x6, x9, x11, x22, x44, x88, x176, x220, x223, t;
+    feSqr(x2, a);
+    feMul(x2, x2, a);
+    feSqr(x3, x2);
+    feMul(x3, x3, a);
+    feSqrN(x6, x3, 3);
+    feMul(x6, x6, x3);
+    feSqrN(x9, x6, 3);
+    feMul(x9, x9, x3);
+    feSqrN(x11, x9, 2);
+    feMul(x11, x11, x2);
+    feSqrN(x22, x11, 11);
+    feMul(x22, x22, x11);
+    feSqrN(x44, x22, 22);
+    feMul(x44, x44, x22);
+    feSqrN(x88, x44, 44);
+    feMul(x88, x88, x44);
+    feSqrN(x176, x88, 88);
+    feMul(x176, x176, x88);
+    feSqrN(x220, x176, 44);
+    feMul(x220, x220, x44);
+    feSqrN(x223, x220, 3);
+    feMul(x223, x223, x3);
+
+    feSqrN(t, x223, 23);
+    feMul(t, t, x22);
+    feSqrN(t, t, 5);
+    feMul(t, t, a);
+    feSqrN(t, t, 3);
+    feMul(t, t, x2);
+    feSqrN(t, t, 2);
+    feMul(r, t, a);
+}
+
+// Big-endian bytes; false if the value is not below p
+bool feFromBytes(Fe& r, const uint8_t* bytes) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t limb = 0;
+        for (int b = 0; b < 8; b++) limb = (limb << 8) | bytes[(3 - i) * 8 + b];
+        r.n[i] = limb;
+    }
+    Fe reduced = r;
+    feReduceOnce(reduced, 0);
+    return feEqual(reduced, r);
+}
+
+void feToBytes(uint8_t* bytes, const Fe& a) {
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 8; b++) bytes[(3 - i) * 8 + b] = static_cast<uint8_t>(a.n[i] >> (56 - 8 * b));
+    }
+}
+
+const Fe kFeOne = {{1, 0, 0, 0}};
+const Fe kFeSeven = {{7, 0, 0, 0}};
+
+// Affine point
+struct Ge {
+    Fe x, y;
+};
+
+// Jacobian point: (X / Z^2, Y / Z^3)
+struct Gej {
+    Fe x, y, z;
+    bool infinity;
+};
+
+const Ge kGenerator = {
+    {{0x59F2815B16F81798ULL, 0x029BFCDB2DCE28D9ULL, 0x55A06295CE870B07ULL, 0x79BE667EF9DCBBACULL}},
+    {{0x9C47D08FFB10D4B8ULL, 0xFD17B448A6855419ULL, 0x5DA4FBFC0E1108A8ULL, 0x483ADA7726A3C465ULL}}
+};
+
+inline Gej gejFromGe(const Ge& a) {
+    return Gej{a.x, a.y, kFeOne, false};
+}
+
+bool geOnCurve(const Ge& a) {
+    Fe y2, x3;
+    feSqr(y2, a.y);
+    feSqr(x3, a.x);
+    feMul(x3, x3, a.x);
+    feAdd(x3, x3, kFeSeven);
+    return feEqual(y2, x3);
+}
+
+// dbl-2009-l (a = 0)
+void gejDouble(Gej& r, const Gej& a) {
+    if (a.infinity) {
+        r = a;
+        return;
+    }
+    Fe A, B, C, D, E, F, t;
+    feSqr(A, a.x);
+    feSqr(B, a.y);
+    feSqr(C, B);
+    feAdd(t, a.x, B);
+    feSqr(t, t);
+    feSub(t, t, A);
+    feSub(t, t, C);
+    feAdd(D, t, t);
+    feAdd(E, A, A);
+    feAdd(E, E, A);
+    feSqr(F, E);
+
+    Gej out;
+    out.infinity = false;
+    feMul(out.z, a.y, a.z);
+    feAdd(out.z, out.z, out.z);
+    feSub(out.x, F, D);
+    feSub(out.x, out.x, D);
+    feSub(t, D, out.x);
+    feMul(out.y, E, t);
+    feAdd(C, C, C);
+    feAdd(C, C, C);
+    feAdd(C, C, C);
+    feSub(out.y, out.y, C);
+    r = out;
+}
+
+// Jacobian plus affine (madd-2004-hmv); equal and opposite points fall
+// back to doubling and infinity
+void gejAddGe(Gej& r, const Gej& a, const Ge& b) {
+    if (a.infinity) {
+        r = gejFromGe(b);
+        return;
+    }
+    Fe z2, z3, u2, s2, h, rr;
+    feSqr(z2, a.z);
+    feMul(z3, z2, a.z);
+    feMul(u2, b.x, z2);
+    feMul(s2, b.y, z3);
+    feSub(h, u2, a.x);
+    feSub(rr, s2, a.y);
+    if (feIsZero(h)) {
+        if (feIsZero(rr)) {
+            gejDouble(r, a);
+        } else {
+            r.infinity = true;
+        }
+        return;
+    }
+
+    Fe h2, h3, v, t;
+    feSqr(h2, h);
+    feMul(h3, h2, h);
+    feMul(v, a.x, h2);
+
+    Gej out;
+    out.infinity = false;
+    feMul(out.z, a.z, h);
+    feSqr(out.x, rr);
+    feSub(out.x, out.x, h3);
+    feSub(out.x, out.x, v);
+    feSub(out.x, out.x, v);
+    feSub(t, v, out.x);
+    feMul(out.y, rr, t);
+    feMul(t, a.y, h3);
+    feSub(out.y, out.y, t);
+    r = out;
+}
+
+// Montgomery's trick: one inversion for the whole batch. Points at
+// infinity are left out and reported through ok.
+void gejNormalizeBatch(const Gej* points, size_t count, Ge* out, bool* ok) {
+    std::vector<Fe> prefix(count);
+    Fe acc = kFeOne;
+    for (size_t i = 0; i < count; i++) {
+        if (!points[i].infinity) feMul(acc, acc, points[i].z);
+        prefix[i] = acc;
+    }
+    Fe inv;
+    feInv(inv, acc);
+    for (size_t i = count; i-- > 0;) {
+        ok[i] = !points[i].infinity;
+        if (!ok[i]) continue;
+        // inv is 1 / (z_0 ... z_i); times the prefix before i gives 1 / z_i
+        Fe zi = inv, zi2, zi3;
+        if (i > 0) feMul(zi, inv, prefix[i - 1]);
+        feMul(inv, inv, points[i].z);
+        feSqr(zi2, zi);
+        feMul(zi3, zi2, zi);
+        feMul(out[i].x, points[i].x, zi2);
+        feMul(out[i].y, points[i].y, zi3);
+    }
+}
+
+// Variable-time double-and-add for public scalars (table setup only)
+Gej scalarMulPublic(const uint8_t* scalar, const Ge& point) {
+    Gej acc;
+    acc.infinity = true;
+    for (int bit = 255; bit >= 0; bit--) {
+        gejDouble(acc, acc);
+        if ((scalar[31 - bit / 8] >> (bit % 8)) & 1) gejAddGe(acc, acc, point);
+    }
+    return acc;
+}
+
+Ge geFromGej(const Gej& a) {
+    Ge out;
+    bool ok;
+    gejNormalizeBatch(&a, 1, &out, &ok);
+    if (!ok) throw std::runtime_error("secp256k1 table point at infinity");
+    return out;
+}
+
+// Bits [position, position + count) of a big-endian scalar, counted from
+// the least significant bit; bits past the top read as zero
+inline uint64_t scalarBits(const uint8_t* scalar, int position, int count) {
+    int first = position / 8;
+    uint64_t bits = 0;
+    for (int b = 0; b < 3 && first + b < 32; b++) bits |= static_cast<uint64_t>(scalar[31 - first - b]) << (8 * b);
+    return (bits >> (position % 8)) & ((1ULL << count) - 1);
+}
+
+/**
+ * Fixed-base comb, laid out as in minimal_secp256k1.h but with any window
+ * width from 4 to 8 bits: window i, digit j holds j * 2^(bits * i) * G plus
+ * an offset share that cancels over the windows, so no entry is the point
+ * at infinity. Wider windows mean fewer point additions per key and a
+ * larger table to scan.
+ */
+struct CombLayout {
+    int bits;
+    int windows;
+    int digits;
+
+    explicit CombLayout(int windowBits)
+        : bits(windowBits), windows((256 + windowBits - 1) / windowBits), digits(1 << windowBits) {}
+
+    size_t entries() const { return static_cast<size_t>(windows) * digits; }
+};
+
+void buildComb(const CombLayout& layout, Ge* entries) {
+    // U = u * G for a nothing-up-my-sleeve u; window i carries 2^i * U and
+    // the last one -(2^(windows - 1) - 1) * U, so the offsets add up to zero
+    static const char kOffsetLabel[] = "walletgen native secp256k1 comb offset";
+    uint8_t u[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const uint8_t*>(kOffsetLabel), sizeof(kOffsetLabel) - 1, u);
+    Ge offset = geFromGej(scalarMulPublic(u, kGenerator));
+    uint8_t lastShare[32] = {0};
+    for (int bit = 0; bit < layout.windows - 1; bit++) lastShare[31 - bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+    Ge last = geFromGej(scalarMulPublic(lastShare, offset));
+    feSub(last.y, Fe{{0, 0, 0, 0}}, last.y);
+
+    std::vector<Gej> points(layout.entries());
+    Ge base = kGenerator;
+    Gej offsetJ = gejFromGe(offset);
+    for (int i = 0; i < layout.windows; i++) {
+        Ge share = i == layout.windows - 1 ? last : geFromGej(offsetJ);
+        Gej point = gejFromGe(share);
+        for (int j = 0; j < layout.digits; j++) {
+            points[static_cast<size_t>(i) * layout.digits + j] = point;
+            gejAddGe(point, point, base);
+        }
+        Gej next = gejFromGe(base);
+        for (int d = 0; d < layout.bits; d++) gejDouble(next, next);
+        base = geFromGej(next);
+        gejDouble(offsetJ, offsetJ);
+    }
+
+    std::unique_ptr<bool[]> ok(new bool[points.size()]);
+    gejNormalizeBatch(points.data(), points.size(), entries, ok.get());
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!ok[i]) throw std::runtime_error("secp256k1 table point at infinity");
+    }
+}
+
+// A comb table, built in memory or mapped from a table file
+struct CombTable {
+    CombLayout layout;
+    const Ge* entries;
+};
+
+// The built-in table: 4-bit windows, 64 KiB, built on first use
+const CombTable& builtinComb() {
+    struct Builtin {
+        std::vector<Ge> storage;
+        CombTable table;
+
+        Builtin() : storage(CombLayout(4).entries()), table{CombLayout(4), storage.data()} {
+            buildComb(table.layout, storage.data());
+        }
+    };
+    static const Builtin builtin;
+    return builtin.table;
+}
+
+// The table the native backend uses: a mapped table file if one was
+// loaded, the built-in one otherwise
+std::atomic<const CombTable*>& mappedComb() {
+    static std::atomic<const CombTable*> table(nullptr);
+    return table;
+}
+
+const CombTable& activeComb() {
+    const CombTable* mapped = mappedComb().load(std::memory_order_acquire);
+    return mapped ? *mapped : builtinComb();
+}
+
+// scalar * G in Jacobian coordinates; the scalar must be below the order
+void combMul(Gej& r, const uint8_t* scalar, const CombTable& table) {
+    const int digits = table.layout.digits;
+    Ge selected;
+    for (int i = 0; i < table.layout.windows; i++) {
+        uint64_t digit = scalarBits(scalar, i * table.layout.bits, table.layout.bits);
+        // Read the whole row so the access pattern does not depend on the digit
+        const Ge* row = table.entries + static_cast<size_t>(i) * digits;
+        for (int l = 0; l < 4; l++) selected.x.n[l] = selected.y.n[l] = 0;
+        for (int j = 0; j < digits; j++) {
+            uint64_t mask = 0 - static_cast<uint64_t>(static_cast<uint64_t>(j) == digit);
+            for (int l = 0; l < 4; l++) {
+                selected.x.n[l] |= row[j].x.n[l] & mask;
+                selected.y.n[l] |= row[j].y.n[l] & mask;
+            }
+        }
+        if (i == 0) {
+            r = gejFromGe(selected);
+        } else {
+            gejAddGe(r, r, selected);
+        }
+    }
+    OPENSSL_cleanse(&selected, sizeof(selected));
+}
+
+/**
+ * Table files (--ec-table): a 64-byte header followed by the comb entries,
+ * each the x and y limbs of one point as little-endian 64-bit words, which
+ * is the in-memory layout on little-endian hosts, so the entries are used
+ * straight from the mapping.
+ *
+ *   0   "WGEC"
+ *   4   format version (1)
+ *   5   window bits
+ *   8   number of entries, 64-bit little-endian
+ *   16  SHA-256 of the entries
+ */
+const char kTableMagic[4] = {'W', 'G', 'E', 'C'};
+const uint8_t kTableVersion = 1;
+const size_t kTableHeaderSize = 64;
+
+bool littleEndianHost() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+// Compares scalar * G through the table with plain double-and-add for a
+// fixed scalar whose digits touch every window
+bool combSelfTest(const CombTable& table) {
+    static const char kCheckLabel[] = "walletgen native secp256k1 table check";
+    uint8_t scalar[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const uint8_t*>(kCheckLabel), sizeof(kCheckLabel) - 1, scalar);
+    Gej viaTable;
+    combMul(viaTable, scalar, table);
+    Ge expected = geFromGej(scalarMulPublic(scalar, kGenerator));
+    Ge actual;
+    bool ok;
+    gejNormalizeBatch(&viaTable, 1, &actual, &ok);
+    return ok && feEqual(actual.x, expected.x) && feEqual(actual.y, expected.y);
+}
+
+#ifndef _WIN32
+void writeTableFile(const std::string& path, int windowBits) {
+    if (!littleEndianHost()) throw std::runtime_error("EC table files need a little-endian host");
+    CombLayout layout(windowBits);
+    std::vector<Ge> entries(layout.entries());
+    buildComb(layout, entries.data());
+    const size_t payload = entries.size() * sizeof(Ge);
+
+    uint8_t header[kTableHeaderSize] = {0};
+    std::memcpy(header, kTableMagic, sizeof(kTableMagic));
+    header[4] = kTableVersion;
+    header[5] = static_cast<uint8_t>(windowBits);
+    for (int i = 0; i < 8; i++) header[8 + i] = static_cast<uint8_t>(static_cast<uint64_t>(entries.size()) >> (8 * i));
+    SHA256(reinterpret_cast<const uint8_t*>(entries.data()), payload, header + 16);
+
+    // Several workers may create the same file at once: each writes its own
+    // temporary file and renames it into place, so readers only ever see a
+    // complete table
+    const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("Cannot write " + tmp + ": " + strerror(errno));
+    const uint8_t* parts[2] = {header, reinterpret_cast<const uint8_t*>(entries.data())};
+    const size_t sizes[2] = {sizeof(header), payload};
+    bool ok = true;
+    for (int part = 0; part < 2 && ok; part++) {
+        size_t done = 0;
+        while (ok && done < sizes[part]) {
+            ssize_t n = ::write(fd, parts[part] + done, sizes[part] - done);
+            if (n < 0 && errno == EINTR) continue;
+            ok = n > 0;
+            if (ok) done += static_cast<size_t>(n);
+        }
+    }
+    ok = ok && ::fsync(fd) == 0;
+    int error = errno;
+    if (::close(fd) != 0 && ok) {
+        ok = false;
+        error = errno;
+    }
+    if (ok && ::rename(tmp.c_str(), path.c_str()) != 0) {
+        ok = false;
+        error = errno;
+    }
+    if (!ok) {
+        ::unlink(tmp.c_str());
+        throw std::runtime_error("Cannot write EC table " + path + ": " + strerror(error));
+    }
+}
+
+// Maps a table file read-only. The mapping is never released: backends on
+// other threads may be using it until the process exits.
+const CombTable* mapTableFile(const std::string& path) {
+    if (!littleEndianHost()) throw std::runtime_error("EC table files need a little-endian host");
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open EC table " + path + ": " + strerror(errno));
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kTableHeaderSize) {
+        ::close(fd);
+        throw std::runtime_error("EC table is truncated: " + path);
+    }
+    const size_t length = static_cast<size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) throw std::runtime_error("Cannot map EC table " + path + ": " + strerror(errno));
+    const uint8_t* data = static_cast<const uint8_t*>(mapping);
+
+    try {
+        if (std::memcmp(data, kTableMagic, sizeof(kTableMagic)) != 0) {
+            throw std::runtime_error("Not an EC table file: " + path);
+        }
+        if (data[4] != kTableVersion) {
+            throw std::runtime_error("Unsupported EC table version " + std::to_string(data[4]));
+        }
+        const int bits = data[5];
+        if (bits < 4 || bits > 8) throw std::runtime_error("Invalid EC table window size " + std::to_string(bits));
+        CombLayout layout(bits);
+        uint64_t count = 0;
+        for (int i = 0; i < 8; i++) count |= static_cast<uint64_t>(data[8 + i]) << (8 * i);
+        if (count != layout.entries() || length != kTableHeaderSize + layout.entries() * sizeof(Ge)) {
+            throw std::runtime_error("EC table is truncated: " + path);
+        }
+        uint8_t digest[SHA256_DIGEST_LENGTH];
+        SHA256(data + kTableHeaderSize, length - kTableHeaderSize, digest);
+        if (CRYPTO_memcmp(digest, data + 16, sizeof(digest)) != 0) {
+            throw std::runtime_error("EC table checksum mismatch: " + path);
+        }
+        std::unique_ptr<CombTable> table(
+            new CombTable{layout, reinterpret_cast<const Ge*>(data + kTableHeaderSize)});
+        if (!combSelfTest(*table)) throw std::runtime_error("EC table failed its self-test: " + path);
+        return table.release();
+    } catch (...) {
+        ::munmap(mapping, length);
+        throw;
+    }
+}
+
+#endif // _WIN32
+
+void storePubkey(const Ge& point, EcPubkey& pubkey) {
+    feToBytes(pubkey.xy, point.x);
+    feToBytes(pubkey.xy + 32, point.y);
+}
+
+} // namespace native
+
+class NativeEcBackend : public EcBackend {
+public:
+    NativeEcBackend() {
+        native::activeComb();
+    }
+
+    const char* name() const override { return kNativeName; }
+
+    bool pubkeyCreate(const uint8_t privateKey[32], EcPubkey& pubkey) override {
+        bool ok;
+        pubkeyCreateBatch(&privateKey, 1, &pubkey, &ok);
+        return ok;
+    }
+
+    void pubkeyCreateBatch(const uint8_t* const* privateKeys, size_t count, EcPubkey* pubkeys, bool* ok) override {
+        const native::CombTable& table = native::activeComb();
+        jacobian.resize(count);
+        affine.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            jacobian[i].infinity = true;
+            if (!scalarIsZero(privateKeys[i]) && scalarBelowOrder(privateKeys[i])) {
+                native::combMul(jacobian[i], privateKeys[i], table);
+            }
+        }
+        native::gejNormalizeBatch(jacobian.data(), count, affine.data(), ok);
+        for (size_t i = 0; i < count; i++) {
+            if (ok[i]) native::storePubkey(affine[i], pubkeys[i]);
+        }
+        OPENSSL_cleanse(jacobian.data(), count * sizeof(native::Gej));
+        OPENSSL_cleanse(affine.data(), count * sizeof(native::Ge));
+    }
+
+    bool pubkeyTweakAdd(EcPubkey& pubkey, const uint8_t tweak[32]) override {
+        native::Ge point;
+        if (!scalarBelowOrder(tweak) || !native::feFromBytes(point.x, pubkey.xy) ||
+            !native::feFromBytes(point.y, pubkey.xy + 32) || !native::geOnCurve(point)) {
+            return false;
+        }
+        if (scalarIsZero(tweak)) return true;
+
+        native::Gej sum;
+        native::combMul(sum, tweak, native::activeComb());
+        native::gejAddGe(sum, sum, point);
+        bool ok;
+        native::gejNormalizeBatch(&sum, 1, &point, &ok);
+        if (ok) native::storePubkey(point, pubkey);
+        OPENSSL_cleanse(&sum, sizeof(sum));
+        return ok;
+    }
+
+private:
+    // Batch scratch, kept between calls
+    std::vector<native::Gej> jacobian;
+    std::vector<native::Ge> affine;
+};
+#endif
+
+// Table file the native backend maps, if any
+std::string& ecTablePath() {
+    static std::string path;
+    return path;
+}
+
+std::string& selectedName() {
+    static std::string name = ecBackendNames().front();
+    return name;
+}
+
+} // namespace
+
+void EcBackend::pubkeyCreateBatch(const uint8_t* const* privateKeys, size_t count, EcPubkey* pubkeys, bool* ok) {
+    for (size_t i = 0; i < count; i++) ok[i] = pubkeyCreate(privateKeys[i], pubkeys[i]);
+}
+
+size_t EcBackend::serialize(const EcPubkey& pubkey, uint8_t* out, bool compressed) {
+    if (compressed) {
+        out[0] = (pubkey.xy[63] & 1) ? 0x03 : 0x02;
+        std::memcpy(out + 1, pubkey.xy, 32);
+        return 33;
+    }
+    out[0] = 0x04;
+    std::memcpy(out + 1, pubkey.xy, 64);
+    return 65;
+}
+
+std::vector<std::string> ecBackendNames() {
+    std::vector<std::string> names;
+#ifndef USE_MINIMAL_SECP256K1
+    names.push_back(kLibsecpName);
+#endif
+    names.push_back(kOpensslName);
+#if WALLETGEN_NATIVE_EC
+    names.push_back(kNativeName);
+#endif
+    return names;
+}
+
+std::unique_ptr<EcBackend> createEcBackend(const std::string& name) {
+#ifndef USE_MINIMAL_SECP256K1
+    if (name == kLibsecpName) return std::unique_ptr<EcBackend>(new LibsecpEcBackend());
+#endif
+    if (name == kOpensslName) return std::unique_ptr<EcBackend>(new OpensslEcBackend());
+#if WALLETGEN_NATIVE_EC
+    if (name == kNativeName) return std::unique_ptr<EcBackend>(new NativeEcBackend());
+#endif
+    if (name == kLibsecpName || name == kNativeName) {
+        throw std::runtime_error("EC backend not built into this binary: " + name);
+    }
+    throw std::runtime_error("Unknown EC backend: '" + name + "' (expected " + kLibsecpName + ", " + kOpensslName +
+                             " or " + kNativeName + ")");
+}
+
+void selectEcBackend(const std::string& name) {
+    createEcBackend(name);
+    selectedName() = name;
+}
+
+const std::string& selectedEcBackend() {
+    return selectedName();
+}
+
+EcBackend& ecBackend() {
+    thread_local std::unique_ptr<EcBackend> instance;
+    if (!instance || selectedName() != instance->name()) instance = createEcBackend(selectedName());
+    return *instance;
+}
+
+void writeEcTable(const std::string& path, int windowBits) {
+    if (windowBits < 4 || windowBits > 8) {
+        throw std::runtime_error("EC table window size must be 4 to 8 bits, got " + std::to_string(windowBits));
+    }
+#if WALLETGEN_NATIVE_EC && !defined(_WIN32)
+    native::writeTableFile(path, windowBits);
+#else
+    (void)path;
+    throw std::runtime_error("EC table files are not supported by this binary");
+#endif
+}
+
+void mapEcTable(const std::string& path) {
+#if WALLETGEN_NATIVE_EC && !defined(_WIN32)
+    native::mappedComb().store(native::mapTableFile(path), std::memory_order_release);
+    ecTablePath() = path;
+#else
+    (void)path;
+    throw std::runtime_error("EC table files are not supported by this binary");
+#endif
+}
+
+void useEcTable(const std::string& path) {
+#if WALLETGEN_NATIVE_EC && !defined(_WIN32)
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        if (errno != ENOENT) throw std::runtime_error("Cannot open EC table " + path + ": " + strerror(errno));
+        writeEcTable(path);
+    }
+#endif
+    mapEcTable(path);
+}
+
+std::string ecTableDescription() {
+#if WALLETGEN_NATIVE_EC
+    const native::CombTable& table = native::activeComb();
+    std::string windows = std::to_string(table.layout.bits) + "-bit windows";
+    if (ecTablePath().empty()) return "built-in (" + windows + ")";
+    return ecTablePath() + " (" + windows + ", mapped)";
+#else
+    return "none";
+#endif
+}
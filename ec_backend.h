@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * secp256k1 backends (--ec-backend).
+ *
+ * Everything the generator needs from the curve goes through EcBackend, so
+ * the implementations can be swapped at runtime and checked against each
+ * other:
+ *
+ *   libsecp256k1  the bitcoin-core library (default when built with it)
+ *   openssl       OpenSSL EC arithmetic with the fixed-base comb from
+ *                 windows/minimal_secp256k1.h (default otherwise)
+ *   native        built-in 4x64-bit field arithmetic, Jacobian coordinates
+ *                 and its own comb table; needs a compiler with 128-bit
+ *                 integers
+ *
+ * The native backend builds a comb table with 4-bit windows (64 KiB) on
+ * first use. --ec-table FILE instead maps a table with 6-bit windows
+ * (176 KiB, fewer point additions per key) from a file, creating the file
+ * first if needed. The mapping is read-only and shared, so every process
+ * using the same file shares one copy in the page cache and skips the
+ * build; the header's checksum and a known-answer check are verified when
+ * the file is mapped.
+ *
+ * Public keys travel between calls as affine coordinates, so any backend
+ * can continue from another's result. Backends keep scratch state and are
+ * not thread-safe; ecBackend() hands each thread its own instance.
+ */
+
+// Affine public key: x || y, 32 bytes each, big-endian
+struct EcPubkey {
+    uint8_t xy[64];
+};
+
+class EcBackend {
+public:
+    virtual ~EcBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    // privateKey * G; false if the key is zero or not below the curve order
+    virtual bool pubkeyCreate(const uint8_t privateKey[32], EcPubkey& pubkey) = 0;
+
+    // pubkey + tweak * G; false if the tweak is not below the curve order,
+    // pubkey is not on the curve or the sum is the point at infinity
+    virtual bool pubkeyTweakAdd(EcPubkey& pubkey, const uint8_t tweak[32]) = 0;
+
+    // pubkeyCreate for count keys. Backends that compute in projective
+    // coordinates normalize the whole batch to affine with one field
+    // inversion. ok[i] reports each key as pubkeyCreate would.
+    virtual void pubkeyCreateBatch(const uint8_t* const* privateKeys, size_t count, EcPubkey* pubkeys, bool* ok);
+
+    // SEC1 encoding: 65 bytes uncompressed (04 x y) or 33 compressed (02/03 x);
+    // returns the length written
+    static size_t serialize(const EcPubkey& pubkey, uint8_t* out, bool compressed);
+};
+
+// Backends compiled into this binary, the default first
+std::vector<std::string> ecBackendNames();
+
+// A new instance of the named backend; throws std::runtime_error for
+// unknown names or backends this binary was built without
+std::unique_ptr<EcBackend> createEcBackend(const std::string& name);
+
+// Selects the backend ecBackend() returns, process-wide. Call before
+// starting threads, as with selectKernels().
+void selectEcBackend(const std::string& name);
+const std::string& selectedEcBackend();
+
+// The calling thread's instance of the selected backend
+EcBackend& ecBackend();
+
+// Comb table files for the native backend (--ec-table). writeEcTable builds
+// a table with windowBits-bit windows (4 to 8) and writes it atomically;
+// mapEcTable maps one and makes the native backend use it, process-wide;
+// useEcTable writes the file if it does not exist and maps it. Call before
+// starting threads. Throws std::runtime_error for unreadable, corrupt or
+// unsupported files.
+void writeEcTable(const std::string& path, int windowBits = 6);
+void mapEcTable(const std::string& path);
+void useEcTable(const std::string& path);
+
+// The native backend's table, e.g. "built-in (4-bit windows)"
+std::string ecTableDescription();
@@ -0,0 +1,267 @@
+#include "encrypted_output.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+namespace {
+
+const char kMagic[4] = {'W', 'G', 'E', 'O'};
+const uint8_t kVersion = 1;
+const size_t kHeaderSize = 48;
+const size_t kSaltOffset = 16;
+const size_t kSaltSize = 32;
+const size_t kTagSize = 16;
+const uint32_t kLastFrame = 0x80000000u;
+const size_t kMaxFrameSize = 16 * 1024 * 1024;
+
+void putLe32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint32_t getLe32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+           static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+SecureBytes deriveFileKey(const SecureBytes& key, const uint8_t* salt) {
+    SecureBytes fileKey(32);
+    unsigned int len = 0;
+    if (key.size() != 32 || !HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), salt, kSaltSize,
+                                  fileKey.data(), &len) || len != 32) {
+        throw std::runtime_error("Output encryption needs a 32-byte key");
+    }
+    return fileKey;
+}
+
+// Nonce and additional data of one frame
+struct FrameContext {
+    uint8_t nonce[12];
+    uint8_t aad[kHeaderSize + 8 + 4];
+
+    FrameContext(const std::vector<uint8_t>& header, uint64_t index, uint32_t lengthField) {
+        std::memset(nonce, 0, 4);
+        for (int i = 0; i < 8; i++) nonce[4 + i] = static_cast<uint8_t>(index >> (56 - 8 * i));
+        std::memcpy(aad, header.data(), kHeaderSize);
+        for (int i = 0; i < 8; i++) aad[kHeaderSize + i] = static_cast<uint8_t>(index >> (8 * i));
+        putLe32(aad + kHeaderSize + 8, lengthField);
+    }
+};
+
+// One AES-256-GCM context per thread, rekeyed per file and re-IV'd per frame
+class Gcm {
+public:
+    Gcm() : ctx(EVP_CIPHER_CTX_new()) {
+        if (!ctx) throw std::runtime_error("Cannot create an AES-GCM context");
+    }
+    ~Gcm() { EVP_CIPHER_CTX_free(ctx); }
+
+    Gcm(const Gcm&) = delete;
+    Gcm& operator=(const Gcm&) = delete;
+
+    // out receives the ciphertext followed by the tag
+    bool seal(const SecureBytes& key, const FrameContext& frame, const uint8_t* plaintext, size_t len, uint8_t* out) {
+        int outLen = 0;
+        return EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key.data(), frame.nonce) == 1 &&
+               EVP_EncryptUpdate(ctx, nullptr, &outLen, frame.aad, sizeof(frame.aad)) == 1 &&
+               (len == 0 || EVP_EncryptUpdate(ctx, out, &outLen, plaintext, static_cast<int>(len)) == 1) &&
+               EVP_EncryptFinal_ex(ctx, out + len, &outLen) == 1 &&
+               EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(kTagSize), out + len) == 1;
+    }
+
+    bool open(const SecureBytes& key, const FrameContext& frame, const uint8_t* sealed, size_t len, uint8_t* out) {
+        int outLen = 0;
+        return EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key.data(), frame.nonce) == 1 &&
+               EVP_DecryptUpdate(ctx, nullptr, &outLen, frame.aad, sizeof(frame.aad)) == 1 &&
+               (len == 0 || EVP_DecryptUpdate(ctx, out, &outLen, sealed, static_cast<int>(len)) == 1) &&
+               EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(kTagSize),
+                                   const_cast<uint8_t*>(sealed + len)) == 1 &&
+               EVP_DecryptFinal_ex(ctx, out + len, &outLen) == 1;
+    }
+
+private:
+    EVP_CIPHER_CTX* ctx;
+};
+
+unsigned int defaultThreads() {
+    return std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+}
+
+} // namespace
+
+EncryptedOutput::EncryptedOutput(std::streambuf* destination, const SecureBytes& key, unsigned int threads,
+                                 size_t frameSize)
+    : destination(destination),
+      header(kHeaderSize, 0),
+      frameSize(frameSize),
+      unsealed(2 * (threads ? threads : defaultThreads()) + 2),
+      sealedFrames(2 * (threads ? threads : defaultThreads()) + 2) {
+    if (frameSize == 0 || frameSize > kMaxFrameSize) throw std::runtime_error("Invalid output frame size");
+    std::memcpy(header.data(), kMagic, sizeof(kMagic));
+    header[4] = kVersion;
+    putLe32(header.data() + 8, static_cast<uint32_t>(frameSize));
+    if (RAND_bytes(header.data() + kSaltOffset, static_cast<int>(kSaltSize)) != 1) {
+        throw std::runtime_error("Cannot generate an output salt");
+    }
+    fileKey = deriveFileKey(key, header.data() + kSaltOffset);
+
+    startFrame();
+    if (threads == 0) threads = defaultThreads();
+    for (unsigned int i = 0; i < threads; i++) workers.emplace_back([this]() { sealLoop(); });
+    writer = std::thread([this]() { writeLoop(); });
+}
+
+EncryptedOutput::~EncryptedOutput() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // Only close() reports errors
+    }
+}
+
+void EncryptedOutput::startFrame() {
+    current = new Frame();
+    current->index = nextIndex++;
+    current->last = false;
+    current->plaintext.resize(frameSize);
+    char* begin = reinterpret_cast<char*>(current->plaintext.data());
+    setp(begin, begin + frameSize);
+}
+
+void EncryptedOutput::submit(bool last) {
+    current->plaintext.resize(static_cast<size_t>(pptr() - pbase()));
+    current->last = last;
+    plaintextCount += current->plaintext.size();
+    unsealed.push(current);
+    current = nullptr;
+    setp(nullptr, nullptr);
+}
+
+EncryptedOutput::int_type EncryptedOutput::overflow(int_type ch) {
+    if (closed) return traits_type::eof();
+    submit(false);
+    startFrame();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize EncryptedOutput::xsputn(const char* data, std::streamsize count) {
+    if (closed) return 0;
+    std::streamsize done = 0;
+    while (done < count) {
+        if (pptr() == epptr()) {
+            submit(false);
+            startFrame();
+        }
+        std::streamsize chunk = std::min<std::streamsize>(count - done, epptr() - pptr());
+        std::memcpy(pptr(), data + done, static_cast<size_t>(chunk));
+        pbump(static_cast<int>(chunk));
+        done += chunk;
+    }
+    return done;
+}
+
+void EncryptedOutput::close() {
+    if (closed) return;
+    closed = true;
+    submit(true);
+    unsealed.close();
+    for (std::thread& worker : workers) worker.join();
+    sealedFrames.close();
+    writer.join();
+    if (writeFailed.load()) throw std::runtime_error("Failed writing encrypted output");
+}
+
+void EncryptedOutput::sealLoop() {
+    Gcm gcm;
+    Frame* frame;
+    while (unsealed.pop(frame)) {
+        size_t len = frame->plaintext.size();
+        uint32_t lengthField = static_cast<uint32_t>(len) | (frame->last ? kLastFrame : 0);
+        frame->sealed.resize(4 + len + kTagSize);
+        putLe32(frame->sealed.data(), lengthField);
+        if (!gcm.seal(fileKey, FrameContext(header, frame->index, lengthField), frame->plaintext.data(), len,
+                      frame->sealed.data() + 4)) {
+            frame->sealed.clear();
+        }
+        SecureBytes().swap(frame->plaintext);
+        sealedFrames.push(frame);
+    }
+}
+
+void EncryptedOutput::writeLoop() {
+    auto write = [this](const uint8_t* data, size_t len) {
+        if (writeFailed.load()) return;
+        if (destination->sputn(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(len)) !=
+            static_cast<std::streamsize>(len)) {
+            writeFailed.store(true);
+        }
+    };
+    write(header.data(), header.size());
+
+    std::map<uint64_t, Frame*> reorder;
+    uint64_t next = 0;
+    Frame* frame;
+    while (sealedFrames.pop(frame)) {
+        reorder.emplace(frame->index, frame);
+        for (auto it = reorder.begin(); it != reorder.end() && it->first == next; it = reorder.erase(it)) {
+            Frame* ready = it->second;
+            if (ready->sealed.empty()) writeFailed.store(true);  // sealing failed
+            write(ready->sealed.data(), ready->sealed.size());
+            if (ready->last && destination->pubsync() != 0) writeFailed.store(true);
+            delete ready;
+            next++;
+        }
+    }
+}
+
+uint64_t decryptOutput(std::istream& in, std::ostream& out, const SecureBytes& key) {
+    std::vector<uint8_t> header(kHeaderSize);
+    if (!in.read(reinterpret_cast<char*>(header.data()), kHeaderSize) ||
+        std::memcmp(header.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not an encrypted output file");
+    }
+    if (header[4] != kVersion) throw std::runtime_error("Unsupported encrypted output version " + std::to_string(header[4]));
+    size_t frameSize = getLe32(header.data() + 8);
+    if (frameSize == 0 || frameSize > kMaxFrameSize) throw std::runtime_error("Encrypted output has an invalid frame size");
+    SecureBytes fileKey = deriveFileKey(key, header.data() + kSaltOffset);
+
+    Gcm gcm;
+    std::vector<uint8_t> sealed(frameSize + kTagSize);
+    SecureBytes plaintext(frameSize);
+    uint64_t total = 0;
+    for (uint64_t index = 0;; index++) {
+        uint8_t lengthBytes[4];
+        if (!in.read(reinterpret_cast<char*>(lengthBytes), sizeof(lengthBytes))) {
+            throw std::runtime_error("Encrypted output is truncated after frame " + std::to_string(index));
+        }
+        uint32_t lengthField = getLe32(lengthBytes);
+        bool last = (lengthField & kLastFrame) != 0;
+        size_t len = lengthField & ~kLastFrame;
+        if (len > frameSize || (!last && len != frameSize)) {
+            throw std::runtime_error("Encrypted output frame " + std::to_string(index) + " has an invalid length");
+        }
+        if (!in.read(reinterpret_cast<char*>(sealed.data()), static_cast<std::streamsize>(len + kTagSize))) {
+            throw std::runtime_error("Encrypted output is truncated in frame " + std::to_string(index));
+        }
+        if (!gcm.open(fileKey, FrameContext(header, index, lengthField), sealed.data(), len, plaintext.data())) {
+            throw std::runtime_error("Encrypted output frame " + std::to_string(index) +
+                                     " failed authentication (wrong key or damaged file)");
+        }
+        out.write(reinterpret_cast<const char*>(plaintext.data()), static_cast<std::streamsize>(len));
+        OPENSSL_cleanse(plaintext.data(), len);
+        if (!out) throw std::runtime_error("Failed writing decrypted output");
+        total += len;
+        if (last) break;
+    }
+    if (in.peek() != std::char_traits<char>::eof()) throw std::runtime_error("Encrypted output has data after its last frame");
+    out.flush();
+    return total;
+}
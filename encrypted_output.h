@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+#include "secure_memory.h"
+
+/**
+ * Encrypted output (--encrypt-key FILE, --decrypt FILE).
+ *
+ * The output stream is cut into frames of a fixed plaintext size, each
+ * sealed with AES-256-GCM (EVP, so AES-NI where available). Frames are
+ * sealed on a pool of worker threads and written in order by a writer
+ * thread, so the thread producing output only copies into frame buffers.
+ *
+ *   0   "WGEO"
+ *   4   format version (1)
+ *   8   frame size, uint32 little-endian
+ *   16  salt, 32 random bytes
+ *   48  frames: length (uint32 little-endian, top bit set on the last
+ *       frame), ciphertext, tag (16)
+ *
+ * Each file has its own key, HMAC-SHA256(key, salt), and frame i uses the
+ * nonce 0^4 || uint64 big-endian i. The tag covers the header, the frame
+ * index and the length field, so frames cannot be altered, reordered,
+ * moved between files or dropped, and a file cut short is detected by its
+ * missing last frame. Every frame but the last is full.
+ */
+
+class EncryptedOutput : public std::streambuf {
+public:
+    static const size_t kDefaultFrameSize = 64 * 1024;
+
+    // threads = 0 picks one per CPU, up to 4
+    EncryptedOutput(std::streambuf* destination, const SecureBytes& key, unsigned int threads = 0,
+                    size_t frameSize = kDefaultFrameSize);
+    ~EncryptedOutput() override;
+
+    EncryptedOutput(const EncryptedOutput&) = delete;
+    EncryptedOutput& operator=(const EncryptedOutput&) = delete;
+
+    // Seals what is buffered as the last frame and waits until every frame
+    // is written. Throws std::runtime_error if writing failed. Output after
+    // close() is an error.
+    void close();
+
+    uint64_t plaintextBytes() const { return plaintextCount; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+    // Frames are only sealed when full, so there is nothing to flush early
+    int sync() override { return 0; }
+
+private:
+    struct Frame {
+        uint64_t index;
+        bool last;
+        SecureBytes plaintext;
+        std::vector<uint8_t> sealed;
+    };
+
+    std::streambuf* destination;
+    SecureBytes fileKey;
+    std::vector<uint8_t> header;
+    size_t frameSize;
+    Frame* current = nullptr;
+    uint64_t nextIndex = 0;
+    uint64_t plaintextCount = 0;
+    bool closed = false;
+    std::atomic<bool> writeFailed{false};
+    BoundedQueue<Frame*> unsealed;
+    BoundedQueue<Frame*> sealedFrames;
+    std::vector<std::thread> workers;
+    std::thread writer;
+
+    void startFrame();
+    void submit(bool last);
+    void sealLoop();
+    void writeLoop();
+};
+
+// Decrypts and verifies a file written through EncryptedOutput, frame by
+// frame. Returns the plaintext size. Throws std::runtime_error on a wrong
+// key, a damaged or truncated file, or a failed write; plaintext of the
+// frames before the failure has already been written by then.
+uint64_t decryptOutput(std::istream& in, std::ostream& out, const SecureBytes& key);
@@ -0,0 +1,637 @@
+#include "index_sweep.h"
+#include "bounded_queue.h"
+#include "crypto_kernels.h"
+#include "wallet_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const kChunkMagic = "#walletgen-chunk 1";
+const char* const kChunkColumns = "#columns index network path address private_key wif public_key";
+const char* const kChunkEnd = "#end records=";
+const char* const kCheckpointMagic = "#walletgen-checkpoint 1";
+
+std::string chunkHeader(const std::string& job, const ShardSpec& shard) {
+    return std::string(kChunkMagic) + "\n#job " + job + "\n#shard " + std::to_string(shard.index) + "/" +
+           std::to_string(shard.count) + (shard.strided ? " strided\n" : " contiguous\n") + kChunkColumns + "\n";
+}
+
+uint64_t parseNumber(const std::string& text, const std::string& what) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos || text.size() > 19) {
+        throw std::runtime_error("Invalid " + what + ": '" + text + "'");
+    }
+    return std::stoull(text);
+}
+
+// Position of shard k's first index in a contiguous split of total indices;
+// avoids the total * k overflow
+uint64_t sliceBoundary(uint64_t total, uint32_t k, uint32_t n) {
+    return total / n * k + total % n * k / n;
+}
+
+std::string shardLine(const ShardSpec& shard) {
+    return std::to_string(shard.index) + "/" + std::to_string(shard.count) + (shard.strided ? " strided" : " contiguous");
+}
+
+std::string hexDigest(const uint8_t* digest, size_t len) {
+    std::string hex(len * 2, '\0');
+    kernels().hexEncode(digest, len, &hex[0]);
+    return hex;
+}
+
+// fsync through a second descriptor: it flushes the file, not the descriptor
+void syncFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0 || ::fsync(fd) != 0) {
+        int error = errno;
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("Cannot sync " + path + ": " + strerror(error));
+    }
+    ::close(fd);
+}
+
+// Readers see either the previous contents or the new ones, even across a
+// crash: write a temporary file, sync it, rename it over the target and
+// sync the directory entry
+void writeFileAtomically(const std::string& path, const std::string& contents) {
+    const std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) throw std::runtime_error("Cannot write " + tmp + ": " + strerror(errno));
+    size_t done = 0;
+    while (done < contents.size()) {
+        ssize_t n = ::write(fd, contents.data() + done, contents.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("Cannot write " + tmp + ": " + strerror(error));
+        }
+        done += static_cast<size_t>(n);
+    }
+    if (::fsync(fd) != 0 || ::close(fd) != 0) throw std::runtime_error("Cannot sync " + tmp + ": " + strerror(errno));
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot rename " + tmp + " to " + path + ": " + strerror(errno));
+    }
+    size_t slash = path.find_last_of('/');
+    syncFile(slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash));
+}
+
+struct Block {
+    uint64_t unit;
+    size_t network;
+    uint64_t lastIndex = 0;
+    std::string text;
+    uint64_t records = 0;
+    std::string error;
+};
+
+struct ChunkReader {
+    std::string path;
+    std::ifstream in;
+    std::string job;
+    ShardSpec shard;
+    std::unique_ptr<IndexSweep> sweep;  // the shard's slice of the job
+    std::string line;         // current record
+    size_t network = 0;       // of the current record, as a position in the job's networks
+    uint64_t index = 0;
+    uint64_t records = 0;
+    bool atEnd = false;
+
+    std::string expect(const std::string& prefix) {
+        std::string header;
+        if (!std::getline(in, header) || header.compare(0, prefix.size(), prefix) != 0) {
+            throw std::runtime_error(path + ": not a walletgen chunk (expected '" + prefix + "')");
+        }
+        return header.substr(prefix.size());
+    }
+
+    void open(const std::string& file) {
+        path = file;
+        in.open(file);
+        if (!in) throw std::runtime_error("Cannot open chunk: " + file);
+        expect(kChunkMagic);
+        job = expect("#job ");
+        std::string spec = expect("#shard ");
+        size_t space = spec.find(' ');
+        shard = IndexSweep::parseShard(spec.substr(0, space), space == std::string::npos ? "" : spec.substr(space + 1));
+        expect(kChunkColumns);
+    }
+
+    // Reads the next record; checks it follows the previous one and
+    // belongs to this shard
+    void advance(const std::map<std::string, size_t>& networks) {
+        if (!std::getline(in, line)) {
+            throw std::runtime_error(path + ": truncated chunk (no end marker after " + std::to_string(records) + " records)");
+        }
+        if (line.compare(0, std::string(kChunkEnd).size(), kChunkEnd) == 0) {
+            if (parseNumber(line.substr(std::string(kChunkEnd).size()), "record count") != records) {
+                throw std::runtime_error(path + ": end marker does not match the " + std::to_string(records) + " records read");
+            }
+            atEnd = true;
+            return;
+        }
+
+        size_t tab = line.find('\t');
+        size_t tab2 = tab == std::string::npos ? tab : line.find('\t', tab + 1);
+        if (tab2 == std::string::npos) throw std::runtime_error(path + ": malformed record: " + line);
+        auto net = networks.find(line.substr(tab + 1, tab2 - tab - 1));
+        if (net == networks.end()) throw std::runtime_error(path + ": record for a network outside the job: " + line);
+        uint64_t next = parseNumber(line.substr(0, tab), "index");
+
+        bool inOrder = records == 0 || net->second > network || (net->second == network && next > index);
+        if (!inOrder || !sweep->covers(next)) {
+            throw std::runtime_error(path + ": record out of order or outside shard " + std::to_string(shard.index) +
+                                     "/" + std::to_string(shard.count) + ": index " + std::to_string(next));
+        }
+        network = net->second;
+        index = next;
+        records++;
+    }
+};
+
+} // namespace
+
+// Writes the chunk in order, keeps the running output digest and saves a
+// checkpoint whenever one is due
+struct SweepWriter {
+    std::ostream& out;
+    SweepProgress progress;
+    EVP_MD_CTX* hash = nullptr;        // only when checkpointing
+    std::function<void()> checkpoint;  // saves progress
+    std::chrono::steady_clock::duration interval{};
+    std::chrono::steady_clock::time_point due{};
+
+    explicit SweepWriter(std::ostream& out) : out(out) {}
+
+    ~SweepWriter() {
+        if (hash) EVP_MD_CTX_free(hash);
+    }
+
+    void startHash() {
+        hash = EVP_MD_CTX_new();
+        if (!hash || EVP_DigestInit_ex(hash, EVP_sha256(), nullptr) != 1) {
+            throw std::runtime_error("Failed to create SHA-256 context");
+        }
+    }
+
+    void hashBytes(const char* data, size_t len) {
+        if (hash && EVP_DigestUpdate(hash, data, len) != 1) throw std::runtime_error("SHA-256 update failed");
+    }
+
+    void write(const std::string& text) {
+        out << text;
+        hashBytes(text.data(), text.size());
+        progress.bytes += text.size();
+    }
+
+    // Digest of everything written so far; the running context stays open
+    std::string digest() const {
+        EVP_MD_CTX* copy = EVP_MD_CTX_new();
+        uint8_t value[32];
+        unsigned int len = 0;
+        bool ok = copy && EVP_MD_CTX_copy_ex(copy, hash) == 1 && EVP_DigestFinal_ex(copy, value, &len) == 1;
+        EVP_MD_CTX_free(copy);
+        if (!ok) throw std::runtime_error("SHA-256 digest failed");
+        return hexDigest(value, len);
+    }
+
+    void blockWritten() {
+        if (!checkpoint) return;
+        auto now = std::chrono::steady_clock::now();
+        if (now < due) return;
+        checkpoint();
+        due = now + interval;
+    }
+};
+
+IndexSweep::IndexSweep(const SweepOptions& options) : options(options) {
+    if (this->options.networks.empty()) {
+        throw std::runtime_error("No networks selected");
+    }
+    for (const std::string& net : this->options.networks) {
+        if (WalletGenerator::networks.find(net) == WalletGenerator::networks.end()) {
+            throw std::runtime_error("Unsupported network: " + net);
+        }
+    }
+    if (this->options.end <= this->options.start) {
+        throw std::runtime_error("Empty index range: --end must be greater than --start");
+    }
+    if (this->options.end > (1ULL << 32)) {
+        throw std::runtime_error("Index range exceeds 2^32");
+    }
+    const ShardSpec& shard = this->options.shard;
+    if (shard.count == 0 || shard.index >= shard.count) {
+        throw std::runtime_error("Invalid shard " + std::to_string(shard.index) + "/" + std::to_string(shard.count));
+    }
+    if (!shard.strided) {
+        sliceBegin = sliceBoundary(this->options.end - this->options.start, shard.index, shard.count);
+    }
+    if (this->options.threads == 0) this->options.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (this->options.blockSize == 0) this->options.blockSize = 1;
+    if (this->options.queueDepth < 2) this->options.queueDepth = 2;
+}
+
+uint64_t IndexSweep::shardSize() const {
+    uint64_t total = options.end - options.start;
+    const ShardSpec& shard = options.shard;
+    if (shard.strided) {
+        return total > shard.index ? (total - shard.index - 1) / shard.count + 1 : 0;
+    }
+    return sliceBoundary(total, shard.index + 1, shard.count) - sliceBegin;
+}
+
+bool IndexSweep::covers(uint64_t index) const {
+    if (index < options.start || index >= options.end) return false;
+    uint64_t offset = index - options.start;
+    if (options.shard.strided) return offset % options.shard.count == options.shard.index;
+    return offset >= sliceBegin && offset < sliceBegin + shardSize();
+}
+
+uint64_t IndexSweep::indexAt(uint64_t position) const {
+    const ShardSpec& shard = options.shard;
+    return shard.strided ? options.start + shard.index + position * shard.count
+                         : options.start + sliceBegin + position;
+}
+
+ShardSpec IndexSweep::parseShard(const std::string& spec, const std::string& mode) {
+    ShardSpec shard;
+    size_t slash = spec.find('/');
+    if (slash == std::string::npos) {
+        throw std::runtime_error("Invalid shard '" + spec + "': expected K/N");
+    }
+    uint64_t k = parseNumber(spec.substr(0, slash), "shard index");
+    uint64_t n = parseNumber(spec.substr(slash + 1), "shard count");
+    if (n == 0 || n > 0xffffffffULL || k >= n) {
+        throw std::runtime_error("Invalid shard '" + spec + "': K must be from 0 to N-1");
+    }
+    shard.index = static_cast<uint32_t>(k);
+    shard.count = static_cast<uint32_t>(n);
+    if (mode == "strided") {
+        shard.strided = true;
+    } else if (mode != "contiguous" && !mode.empty()) {
+        throw std::runtime_error("Unknown shard mode: " + mode);
+    }
+    return shard;
+}
+
+std::string IndexSweep::seedFingerprint(ByteView seed) {
+    uint8_t digest[32];
+    char hex[8];
+    kernels().sha256(seed.data(), seed.size(), digest);
+    kernels().hexEncode(digest, 4, hex);
+    OPENSSL_cleanse(digest, sizeof(digest));
+    return std::string(hex, sizeof(hex));
+}
+
+std::string IndexSweep::jobLine(const std::string& fingerprint) const {
+    std::string networks;
+    for (const std::string& net : options.networks) {
+        networks += (networks.empty() ? "" : ",") + net;
+    }
+    return "networks=" + networks + " start=" + std::to_string(options.start) + " end=" +
+           std::to_string(options.end) + " seed=" + fingerprint;
+}
+
+uint64_t IndexSweep::run(ByteView seed, std::ostream& out) {
+    SweepWriter writer(out);
+    return sweep(seed, writer);
+}
+
+uint64_t IndexSweep::run(ByteView seed, const std::string& outputPath, const std::string& checkpointPath, bool resume) {
+    const std::string fingerprint = seedFingerprint(seed);
+    std::ofstream out;
+    SweepWriter writer(out);
+    writer.startHash();
+
+    if (resume) {
+        // Keep exactly the output the checkpoint vouches for: anything
+        // written after it is cut off and derived again
+        writer.progress = loadCheckpoint(checkpointPath, fingerprint);
+        std::ifstream previous(outputPath, std::ios::binary);
+        if (!previous) throw std::runtime_error("Cannot open output file to resume: " + outputPath);
+        std::vector<char> buffer(1 << 16);
+        uint64_t left = writer.progress.bytes;
+        while (left > 0) {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(left, buffer.size()));
+            if (!previous.read(buffer.data(), want)) {
+                throw std::runtime_error(outputPath + " is shorter than its checkpoint records");
+            }
+            writer.hashBytes(buffer.data(), want);
+            left -= want;
+        }
+        previous.close();
+        if (writer.digest() != writer.progress.sha256) {
+            throw std::runtime_error(outputPath + " does not match its checkpoint (output changed since it was written)");
+        }
+        if (::truncate(outputPath.c_str(), static_cast<off_t>(writer.progress.bytes)) != 0) {
+            throw std::runtime_error("Cannot truncate " + outputPath + ": " + strerror(errno));
+        }
+        out.open(outputPath, std::ios::out | std::ios::app | std::ios::binary);
+    } else {
+        out.open(outputPath, std::ios::out | std::ios::trunc | std::ios::binary);
+    }
+    if (!out) throw std::runtime_error("Cannot open output file: " + outputPath);
+
+    writer.interval = std::chrono::seconds(options.checkpointSeconds);
+    writer.due = std::chrono::steady_clock::now() + writer.interval;
+    writer.checkpoint = [&]() {
+        // The output must be on disk before a checkpoint vouches for it
+        out.flush();
+        if (!out) throw std::runtime_error("Failed writing output file: " + outputPath);
+        syncFile(outputPath);
+        writer.progress.sha256 = writer.digest();
+        saveCheckpoint(checkpointPath, fingerprint, writer.progress);
+    };
+
+    uint64_t records = sweep(seed, writer);
+    out.close();
+    if (!out) throw std::runtime_error("Failed writing output file: " + outputPath);
+    syncFile(outputPath);
+    std::remove(checkpointPath.c_str());
+    return records;
+}
+
+void IndexSweep::saveCheckpoint(const std::string& path, const std::string& fingerprint,
+                                const SweepProgress& progress) const {
+    std::string text = std::string(kCheckpointMagic) + "\n";
+    text += "job " + jobLine(fingerprint) + "\n";
+    text += "shard " + shardLine(options.shard) + "\n";
+    text += "block " + std::to_string(options.blockSize) + "\n";
+    text += "units " + std::to_string(progress.units) + "\n";
+    text += "records " + std::to_string(progress.records) + "\n";
+    text += "bytes " + std::to_string(progress.bytes) + "\n";
+    text += "sha256 " + progress.sha256 + "\n";
+    for (const std::string& net : options.networks) {
+        auto last = progress.lastIndex.find(net);
+        if (last != progress.lastIndex.end()) text += "last " + net + " " + std::to_string(last->second) + "\n";
+    }
+    writeFileAtomically(path, text);
+}
+
+SweepProgress IndexSweep::loadCheckpoint(const std::string& path, const std::string& fingerprint) const {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot open checkpoint: " + path);
+    std::string line;
+    if (!std::getline(in, line) || line != kCheckpointMagic) {
+        throw std::runtime_error(path + ": not a walletgen checkpoint");
+    }
+
+    SweepProgress progress;
+    std::string job, shard, block;
+    while (std::getline(in, line)) {
+        size_t space = line.find(' ');
+        std::string key = line.substr(0, space);
+        std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+        if (key == "job") {
+            job = value;
+        } else if (key == "shard") {
+            shard = value;
+        } else if (key == "block") {
+            block = value;
+        } else if (key == "units") {
+            progress.units = parseNumber(value, "checkpoint units");
+        } else if (key == "records") {
+            progress.records = parseNumber(value, "checkpoint records");
+        } else if (key == "bytes") {
+            progress.bytes = parseNumber(value, "checkpoint bytes");
+        } else if (key == "sha256") {
+            progress.sha256 = value;
+        } else if (key == "last") {
+            size_t split = value.find(' ');
+            progress.lastIndex[value.substr(0, split)] =
+                parseNumber(split == std::string::npos ? "" : value.substr(split + 1), "checkpoint index");
+        }
+    }
+
+    // Resuming with other parameters would splice two different sweeps
+    if (job != jobLine(fingerprint)) {
+        throw std::runtime_error(path + ": checkpoint is for a different job (" + job + ")");
+    }
+    if (shard != shardLine(options.shard) || block != std::to_string(options.blockSize)) {
+        throw std::runtime_error(path + ": checkpoint is for shard " + shard + " with blocks of " + block);
+    }
+    const uint64_t blocksPerNetwork = (shardSize() + options.blockSize - 1) / options.blockSize;
+    if (progress.units > blocksPerNetwork * options.networks.size() || progress.sha256.size() != 64) {
+        throw std::runtime_error(path + ": corrupt checkpoint");
+    }
+    return progress;
+}
+
+uint64_t IndexSweep::sweep(ByteView seed, SweepWriter& writer) {
+    const uint64_t perNetwork = shardSize();
+    const uint64_t blocksPerNetwork = (perNetwork + options.blockSize - 1) / options.blockSize;
+    const uint64_t units = blocksPerNetwork * options.networks.size();
+    SweepProgress& progress = writer.progress;
+
+    if (progress.bytes == 0) {
+        writer.write(chunkHeader(jobLine(seedFingerprint(seed)), options.shard));
+    }
+
+    BoundedQueue<Block*> done(options.queueDepth);
+    std::atomic<uint64_t> nextUnit(progress.units);
+    std::atomic<uint64_t> writtenUnits(progress.units);
+    std::atomic<bool> failed(false);
+
+    // Workers claim units in order and stay at most queueDepth units ahead
+    // of the writer, which bounds both the queue and the reorder buffer
+    auto worker = [&]() {
+        WalletGenerator generator;
+        for (;;) {
+            uint64_t unit = nextUnit.fetch_add(1);
+            if (unit >= units || failed.load(std::memory_order_relaxed)) break;
+            while (unit >= writtenUnits.load(std::memory_order_acquire) + options.queueDepth &&
+                   !failed.load(std::memory_order_relaxed)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+
+            Block* block = new Block();
+            block->unit = unit;
+            block->network = static_cast<size_t>(unit / blocksPerNetwork);
+            try {
+                const std::string& network = options.networks[block->network];
+                uint64_t first = (unit % blocksPerNetwork) * options.blockSize;
+                uint64_t last = std::min<uint64_t>(first + options.blockSize, perNetwork);
+                std::vector<std::string> paths;
+                std::vector<uint64_t> indices;
+                for (uint64_t position = first; position < last; position++) {
+                    indices.push_back(indexAt(position));
+                    paths.push_back(WalletGenerator::indexedPath(network, static_cast<uint32_t>(indices.back())));
+                }
+                std::vector<WalletGenerator::WalletInfo> wallets = generator.generateWallets(seed, network, paths);
+                for (size_t i = 0; i < wallets.size(); i++) {
+                    const WalletGenerator::WalletInfo& wallet = wallets[i];
+                    block->text += std::to_string(indices[i]) + "\t" + network + "\t" + wallet.derivationPath + "\t" +
+                                   wallet.address + "\t";
+                    block->text += wallet.privateKey;
+                    block->text += "\t";
+                    block->text += wallet.wif;
+                    block->text += "\t" + wallet.publicKey + "\n";
+                }
+                block->records = wallets.size();
+                block->lastIndex = indices.empty() ? 0 : indices.back();
+            } catch (const std::exception& e) {
+                block->error = e.what();
+                failed.store(true, std::memory_order_relaxed);
+            }
+            secureArenaReset();
+            done.push(block);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    auto remaining = std::make_shared<std::atomic<unsigned int>>(options.threads);
+    for (unsigned int i = 0; i < options.threads; i++) {
+        threads.emplace_back([&, remaining]() {
+            worker();
+            if (remaining->fetch_sub(1) == 1) done.close();
+        });
+    }
+
+    std::map<uint64_t, Block*> reorder;
+    std::string error;
+    Block* block;
+    while (done.pop(block)) {
+        reorder.emplace(block->unit, block);
+        for (auto it = reorder.begin(); it != reorder.end() && it->first == writtenUnits.load(); it = reorder.erase(it)) {
+            Block* ready = it->second;
+            if (!ready->error.empty()) {
+                if (error.empty()) error = ready->error;
+            } else if (error.empty()) {
+                try {
+                    WG_STAT_SCOPE(StatStage::Output, ready->text.size());
+                    writer.write(ready->text);
+                    progress.units = ready->unit + 1;
+                    progress.records += ready->records;
+                    if (ready->records > 0) progress.lastIndex[options.networks[ready->network]] = ready->lastIndex;
+                    writer.blockWritten();
+                } catch (const std::exception& e) {
+                    error = e.what();
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            if (!ready->text.empty()) OPENSSL_cleanse(&ready->text[0], ready->text.size());
+            delete ready;
+            writtenUnits.fetch_add(1, std::memory_order_release);
+        }
+    }
+    for (std::thread& t : threads) t.join();
+    for (auto& entry : reorder) delete entry.second;  // after a failure, units past the gap
+
+    if (!error.empty()) throw std::runtime_error(error);
+    writer.write(kChunkEnd + std::to_string(progress.records) + "\n");
+    writer.out.flush();
+    return progress.records;
+}
+
+uint64_t IndexSweep::mergeChunks(const std::vector<std::string>& paths, std::ostream& out) {
+    if (paths.empty()) throw std::runtime_error("No chunks to merge");
+
+    std::vector<std::unique_ptr<ChunkReader>> readers;
+    for (const std::string& path : paths) {
+        readers.emplace_back(new ChunkReader());
+        readers.back()->open(path);
+    }
+
+    // Every chunk must come from the same job, and each shard appear once
+    const std::string job = readers[0]->job;
+    const uint32_t shardCount = readers[0]->shard.count;
+    const bool strided = readers[0]->shard.strided;
+    std::vector<bool> seen(shardCount, false);
+    for (const auto& reader : readers) {
+        if (reader->job != job) {
+            throw std::runtime_error(reader->path + ": belongs to a different job (" + reader->job + " vs " + job + ")");
+        }
+        if (reader->shard.count != shardCount || reader->shard.strided != strided) {
+            throw std::runtime_error(reader->path + ": shard layout differs from " + readers[0]->path);
+        }
+        if (seen[reader->shard.index]) {
+            throw std::runtime_error(reader->path + ": shard " + std::to_string(reader->shard.index) + " given twice");
+        }
+        seen[reader->shard.index] = true;
+    }
+    if (readers.size() != shardCount) {
+        throw std::runtime_error("Missing chunks: " + std::to_string(readers.size()) + " of " + std::to_string(shardCount) + " shards given");
+    }
+
+    SweepOptions jobOptions;
+    std::stringstream fields(job);
+    std::string field;
+    std::string fingerprint;
+    while (fields >> field) {
+        size_t eq = field.find('=');
+        std::string key = field.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : field.substr(eq + 1);
+        if (key == "networks") {
+            std::stringstream names(value);
+            std::string name;
+            while (std::getline(names, name, ',')) jobOptions.networks.push_back(name);
+        } else if (key == "start") {
+            jobOptions.start = parseNumber(value, "job start");
+        } else if (key == "end") {
+            jobOptions.end = parseNumber(value, "job end");
+        } else if (key == "seed") {
+            fingerprint = value;
+        }
+    }
+    std::map<std::string, size_t> networks;
+    for (size_t i = 0; i < jobOptions.networks.size(); i++) networks[jobOptions.networks[i]] = i;
+
+    for (const auto& reader : readers) {
+        SweepOptions shardOptions = jobOptions;
+        shardOptions.shard = reader->shard;
+        reader->sweep.reset(new IndexSweep(shardOptions));
+        reader->advance(networks);
+    }
+
+    IndexSweep whole(jobOptions);
+    out << chunkHeader(whole.jobLine(fingerprint), ShardSpec());
+
+    // Per network, a k-way merge on index; contiguous shards drain one after
+    // another, strided ones interleave
+    uint64_t records = 0;
+    typedef std::pair<uint64_t, size_t> HeapEntry;
+    for (size_t net = 0; net < jobOptions.networks.size(); net++) {
+        std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+        for (size_t r = 0; r < readers.size(); r++) {
+            if (!readers[r]->atEnd && readers[r]->network == net) heap.push(HeapEntry(readers[r]->index, r));
+        }
+        uint64_t expected = jobOptions.start;
+        while (!heap.empty()) {
+            size_t r = heap.top().second;
+            ChunkReader& reader = *readers[r];
+            heap.pop();
+            if (reader.index != expected) {
+                throw std::runtime_error("Chunks do not cover index " + std::to_string(expected) + " of " +
+                                         jobOptions.networks[net] + " exactly once");
+            }
+            out << reader.line << "\n";
+            records++;
+            expected++;
+            reader.advance(networks);
+            if (!reader.atEnd && reader.network == net) heap.push(HeapEntry(reader.index, r));
+        }
+        if (expected != jobOptions.end) {
+            throw std::runtime_error("Chunks do not cover index " + std::to_string(expected) + " of " + jobOptions.networks[net]);
+        }
+    }
+    out << kChunkEnd << records << "\n";
+    out.flush();
+    return records;
+}
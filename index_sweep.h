@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "wallet_generator.h"
+
+/**
+ * Index sweeps (--start/--end, --shard K/N).
+ *
+ * A sweep derives the default-path wallets of one seed for every index in
+ * [start, end) and every selected network. Sharding splits the range into N
+ * disjoint slices, either contiguous or strided (index % N == K), so the
+ * shards can run as separate processes or on separate machines.
+ *
+ * Each run writes a self-describing chunk:
+ *
+ *   #walletgen-chunk 1
+ *   #job networks=bitcoin,ethereum start=0 end=1000 seed=1a2b3c4d
+ *   #shard 2/4 contiguous
+ *   #columns index network path address private_key wif public_key
+ *   500<TAB>bitcoin<TAB>m/44'/0'/0'/0/500<TAB>...
+ *   #end records=500
+ *
+ * Records are ordered by network, then index. mergeChunks() checks that the
+ * chunks of one job cover it exactly once and reassembles them into the
+ * chunk a single "--shard 0/1" run would have written, byte for byte.
+ *
+ * Worker threads take blocks of indices; the writer restores block order.
+ *
+ * A sweep written to a file can checkpoint: every checkpointSeconds the
+ * writer syncs the output and atomically replaces the checkpoint file with
+ * the job, the blocks written so far, the output size and its SHA-256, and
+ * the last index written per network. Resuming checks the job and the
+ * output against the checkpoint, cuts off anything written after it and
+ * continues with the next block, so no record is duplicated or skipped.
+ */
+
+struct ShardSpec {
+    uint32_t index = 0;    // K, from 0 to count - 1
+    uint32_t count = 1;    // N
+    bool strided = false;  // every Nth index instead of a contiguous slice
+};
+
+struct SweepOptions {
+    std::vector<std::string> networks;
+    uint64_t start = 0;
+    uint64_t end = 1;        // exclusive; at most 2^32
+    ShardSpec shard;
+    unsigned int threads = 0;   // 0 = hardware concurrency
+    uint32_t blockSize = 256;   // indices per work unit
+    size_t queueDepth = 64;     // blocks in flight ahead of the writer
+    unsigned int checkpointSeconds = 30;
+};
+
+// How far a sweep's output has got, as recorded in its checkpoint
+struct SweepProgress {
+    uint64_t units = 0;    // blocks written, in order
+    uint64_t records = 0;
+    uint64_t bytes = 0;    // output size, header included
+    std::string sha256;    // of those bytes
+    std::map<std::string, uint64_t> lastIndex;  // last index written per network
+};
+
+struct SweepWriter;
+
+class IndexSweep {
+public:
+    explicit IndexSweep(const SweepOptions& options);
+
+    // Indices of one network this shard covers, and the i-th of them
+    uint64_t shardSize() const;
+    uint64_t indexAt(uint64_t position) const;
+    bool covers(uint64_t index) const;
+
+    // Returns the number of records written
+    uint64_t run(ByteView seed, std::ostream& out);
+
+    // Writes outputPath with checkpoints in checkpointPath, which is removed
+    // once the sweep completes; resume continues from an existing checkpoint
+    uint64_t run(ByteView seed, const std::string& outputPath, const std::string& checkpointPath, bool resume);
+
+    // Parses "K/N" and a mode ("contiguous" or "strided")
+    static ShardSpec parseShard(const std::string& spec, const std::string& mode);
+
+    // Identifies the seed in chunk headers without revealing it
+    static std::string seedFingerprint(ByteView seed);
+
+    // Reassembles the chunks of one job in canonical order; returns the
+    // number of records written
+    static uint64_t mergeChunks(const std::vector<std::string>& paths, std::ostream& out);
+
+private:
+    SweepOptions options;
+    uint64_t sliceBegin = 0;  // contiguous shards: first position's offset from start
+
+    // The "#job" line shared by every chunk of this sweep
+    std::string jobLine(const std::string& fingerprint) const;
+
+    uint64_t sweep(ByteView seed, SweepWriter& writer);
+    void saveCheckpoint(const std::string& path, const std::string& fingerprint, const SweepProgress& progress) const;
+    SweepProgress loadCheckpoint(const std::string& path, const std::string& fingerprint) const;
+};
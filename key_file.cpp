@@ -0,0 +1,83 @@
+#include "key_file.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <openssl/rand.h>
+
+namespace {
+
+// mkdir -p, private to the user
+void makeDirectories(const std::string& dir) {
+    for (size_t slash = dir.find('/', 1); ; slash = dir.find('/', slash + 1)) {
+        std::string part = dir.substr(0, slash);
+        if (::mkdir(part.c_str(), 0700) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Cannot create " + part + ": " + strerror(errno));
+        }
+        if (slash == std::string::npos) return;
+    }
+}
+
+// Exactly len bytes, then end of file
+bool readExactly(int fd, uint8_t* out, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = ::read(fd, out + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    uint8_t extra;
+    return ::read(fd, &extra, 1) == 0;
+}
+
+bool writeAll(int fd, const uint8_t* data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = ::write(fd, data + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+SecureBytes loadKeyFile(const std::string& path, const std::string& what, bool create) {
+    SecureBytes key(kKeyFileSize);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0 && errno == ENOENT && create) {
+        size_t slash = path.find_last_of('/');
+        if (slash != std::string::npos && slash > 0) makeDirectories(path.substr(0, slash));
+        if (RAND_bytes(key.data(), static_cast<int>(key.size())) != 1) {
+            throw std::runtime_error("Cannot generate " + what + " " + path);
+        }
+        // O_EXCL: if another process created the key first, use that one
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            bool ok = writeAll(fd, key.data(), key.size()) && ::fsync(fd) == 0;
+            ::close(fd);
+            if (!ok) {
+                ::unlink(path.c_str());
+                throw std::runtime_error("Cannot write " + what + " " + path);
+            }
+            return key;
+        }
+        if (errno != EEXIST) throw std::runtime_error("Cannot create " + what + " " + path + ": " + strerror(errno));
+        fd = ::open(path.c_str(), O_RDONLY);
+    }
+    if (fd < 0) throw std::runtime_error("Cannot open " + what + " " + path + ": " + strerror(errno));
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || (st.st_mode & 077) != 0) {
+        ::close(fd);
+        throw std::runtime_error(what + " " + path + " must not be accessible by other users (chmod 600)");
+    }
+    bool ok = readExactly(fd, key.data(), key.size());
+    ::close(fd);
+    if (!ok) throw std::runtime_error(what + " " + path + " is not " + std::to_string(kKeyFileSize) + " bytes");
+    return key;
+}
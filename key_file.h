@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "secure_memory.h"
+
+/**
+ * Secret key files (--seed-cache-key, --encrypt-key).
+ *
+ * A key file holds exactly kKeyFileSize raw random bytes with mode 0600.
+ * Like ssh private keys, a key file that other users can access is refused.
+ */
+
+const size_t kKeyFileSize = 32;
+
+// Reads the key at path. If the file does not exist and create is set, a
+// random key is written there first, along with any missing directories
+// (mode 0700); concurrent creators all end up with the first one's key.
+// what names the key in errors, e.g. "Seed cache host key".
+SecureBytes loadKeyFile(const std::string& path, const std::string& what, bool create);
@@ -0,0 +1,181 @@
+#include "mnemonic_file.h"
+#include "bip39.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[4] = {'W', 'G', 'M', 'N'};
+const uint8_t kVersion = 1;
+const uint8_t kLanguageEnglish = 0;
+
+size_t recordBytes(MnemonicEncoding encoding, size_t words) {
+    return encoding == MnemonicEncoding::Indices ? packedIndexBytes(words) : words * 4 / 3;
+}
+
+void writeHeader(std::ostream& out, MnemonicEncoding encoding, size_t words, uint64_t count) {
+    uint8_t header[kMnemonicFileHeaderSize] = {0};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    header[4] = kVersion;
+    header[5] = static_cast<uint8_t>(encoding);
+    header[6] = kLanguageEnglish;
+    header[7] = static_cast<uint8_t>(words);
+    for (int i = 0; i < 8; i++) {
+        header[8 + i] = static_cast<uint8_t>(count >> (8 * i));
+    }
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+} // namespace
+
+MnemonicFile::MnemonicFile(const std::string& path)
+    : data(nullptr), length(0), recordCount(0), words(0), recordSize(0),
+      recordEncoding(MnemonicEncoding::Indices) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open packed mnemonic file: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kMnemonicFileHeaderSize) {
+        close(fd);
+        throw std::runtime_error("Packed mnemonic file is truncated: " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map packed mnemonic file: " + path);
+    }
+    data = static_cast<const uint8_t*>(mapping);
+    // Records are read front to back exactly once
+    madvise(mapping, length, MADV_SEQUENTIAL);
+
+    try {
+        if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+            throw std::runtime_error("Not a packed mnemonic file: " + path);
+        }
+        if (data[4] != kVersion) {
+            throw std::runtime_error("Unsupported packed mnemonic file version " + std::to_string(data[4]));
+        }
+        if (data[5] > static_cast<uint8_t>(MnemonicEncoding::Entropy)) {
+            throw std::runtime_error("Unknown packed mnemonic encoding " + std::to_string(data[5]));
+        }
+        if (data[6] != kLanguageEnglish) {
+            throw std::runtime_error("Unsupported mnemonic language " + std::to_string(data[6]));
+        }
+        words = data[7];
+        if (words < 12 || words > kBip39MaxWords || words % 3 != 0) {
+            throw std::runtime_error("Invalid word count " + std::to_string(words));
+        }
+        recordEncoding = static_cast<MnemonicEncoding>(data[5]);
+        for (int i = 0; i < 8; i++) {
+            recordCount |= static_cast<uint64_t>(data[8 + i]) << (8 * i);
+        }
+        recordSize = recordBytes(recordEncoding, words);
+        if ((length - kMnemonicFileHeaderSize) / recordSize < recordCount) {
+            throw std::runtime_error("Packed mnemonic file is truncated: " + path);
+        }
+    } catch (...) {
+        munmap(const_cast<uint8_t*>(data), length);
+        throw;
+    }
+}
+
+MnemonicFile::~MnemonicFile() {
+    munmap(const_cast<uint8_t*>(data), length);
+}
+
+bool MnemonicFile::isPacked(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool MnemonicFile::indicesAt(uint64_t i, uint16_t* out) const {
+    const uint8_t* record = data + kMnemonicFileHeaderSize + i * recordSize;
+    if (recordEncoding == MnemonicEncoding::Entropy) {
+        std::vector<uint16_t> indices = entropyToIndices(record, recordSize);
+        std::memcpy(out, indices.data(), words * sizeof(uint16_t));
+        return true;
+    }
+    unpackIndices(record, words, out);
+    return indicesChecksumValid(out, words);
+}
+
+bool MnemonicFile::mnemonicAt(uint64_t i, std::string& out) const {
+    uint16_t indices[kBip39MaxWords];
+    if (!indicesAt(i, indices)) return false;
+    indicesToMnemonic(indices, words, out);
+    return true;
+}
+
+uint64_t packMnemonics(std::istream& in, const std::string& outPath, MnemonicEncoding encoding) {
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open output file: " + outPath);
+    }
+
+    // Placeholder header; the word and record counts are known at the end
+    writeHeader(out, encoding, 0, 0);
+
+    std::string line;
+    uint64_t lineNumber = 0;
+    uint64_t count = 0;
+    size_t words = 0;
+    uint8_t record[33];
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        std::vector<uint16_t> indices;
+        try {
+            indices = mnemonicToIndices(line.substr(0, line.find('\t')));
+            if (words == 0) words = indices.size();
+            if (indices.size() != words) {
+                throw std::runtime_error("all mnemonics in a packed file must have " + std::to_string(words) + " words");
+            }
+            // Checksum is validated for both encodings
+            std::vector<uint8_t> entropy = indicesToEntropy(indices.data(), indices.size());
+            if (encoding == MnemonicEncoding::Entropy) {
+                std::memcpy(record, entropy.data(), entropy.size());
+            } else {
+                packIndices(indices.data(), indices.size(), record);
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error("line " + std::to_string(lineNumber) + ": " + e.what());
+        }
+        out.write(reinterpret_cast<const char*>(record), recordBytes(encoding, words));
+        count++;
+    }
+    if (count == 0) {
+        throw std::runtime_error("No mnemonics to pack");
+    }
+
+    out.seekp(0);
+    writeHeader(out, encoding, words, count);
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed writing output file: " + outPath);
+    }
+    return count;
+}
+
+uint64_t unpackMnemonics(const MnemonicFile& file, std::ostream& out) {
+    std::string line;
+    for (uint64_t i = 0; i < file.size(); i++) {
+        line.clear();
+        if (!file.mnemonicAt(i, line)) {
+            throw std::runtime_error("record " + std::to_string(i + 1) + ": invalid mnemonic checksum");
+        }
+        line += '\n';
+        out.write(line.data(), line.size());
+    }
+    out.flush();
+    return file.size();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Packed binary mnemonic files (.wgm).
+ *
+ * A 16-byte header followed by fixed-size records, all with the same word
+ * count:
+ *
+ *   offset 0  "WGMN" magic
+ *          4  format version (1)
+ *          5  encoding: 0 = packed 11-bit word indices, 1 = raw entropy
+ *          6  language: 0 = English
+ *          7  words per mnemonic (12, 15, 18, 21 or 24)
+ *          8  record count, uint64 little-endian
+ *
+ * Index records take ceil(words * 11 / 8) bytes (17 for 12 words, 33 for 24)
+ * and keep the checksum bits; entropy records take words * 4 / 3 bytes (16 to
+ * 32) and the checksum is recomputed on read. Mnemonics only: passphrases and
+ * paths come from the command line.
+ */
+
+enum class MnemonicEncoding : uint8_t {
+    Indices = 0,
+    Entropy = 1
+};
+
+const size_t kMnemonicFileHeaderSize = 16;
+
+// Read-only, memory-mapped view of a packed file. Records are decoded
+// straight from the mapping; nothing is copied up front.
+class MnemonicFile {
+public:
+    explicit MnemonicFile(const std::string& path);
+    ~MnemonicFile();
+
+    MnemonicFile(const MnemonicFile&) = delete;
+    MnemonicFile& operator=(const MnemonicFile&) = delete;
+
+    // True if the file starts with the packed-file magic
+    static bool isPacked(const std::string& path);
+
+    uint64_t size() const { return recordCount; }
+    size_t wordCount() const { return words; }
+    MnemonicEncoding encoding() const { return recordEncoding; }
+
+    // Word indices of record i (wordCount() entries); false if an index
+    // record's checksum is wrong
+    bool indicesAt(uint64_t i, uint16_t* out) const;
+
+    // Appends record i's mnemonic text to out
+    bool mnemonicAt(uint64_t i, std::string& out) const;
+
+private:
+    const uint8_t* data;
+    size_t length;
+    uint64_t recordCount;
+    size_t words;
+    size_t recordSize;
+    MnemonicEncoding recordEncoding;
+};
+
+// Converts text (first tab-separated field of each non-comment line) to a
+// packed file. Returns the number of records written.
+uint64_t packMnemonics(std::istream& in, const std::string& outPath, MnemonicEncoding encoding);
+
+// Writes every record as one text line. Returns the number of records.
+uint64_t unpackMnemonics(const MnemonicFile& file, std::ostream& out);
@@ -0,0 +1,185 @@
+#include "secure_memory.h"
+#include <algorithm>
+#include <atomic>
+#include <openssl/crypto.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t kChunkSize = 64 * 1024;
+
+struct SecureArena;
+
+struct Chunk {
+    SecureArena* arena;
+    uint8_t* base;
+    size_t size;
+    size_t used;               // owning thread only
+    bool locked;
+    std::atomic<size_t> live;  // decremented by whichever thread frees
+};
+
+// Precedes every block; 16 bytes so blocks stay 16-byte aligned
+struct BlockHeader {
+    Chunk* chunk;  // nullptr: plain heap block (allocated during thread exit)
+    size_t size;
+};
+
+struct SecureArena {
+    std::vector<Chunk*> chunks;
+    size_t current = 0;
+    // One reference for the owning thread plus one per live block; whoever
+    // drops the last one destroys the arena
+    std::atomic<size_t> refs{1};
+
+    ~SecureArena() {
+        for (Chunk* chunk : chunks) {
+            OPENSSL_cleanse(chunk->base, chunk->used);
+            if (chunk->locked) munlock(chunk->base, chunk->size);
+            munmap(chunk->base, chunk->size);
+            delete chunk;
+        }
+    }
+};
+
+void release(SecureArena* arena) {
+    if (arena->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete arena;
+    }
+}
+
+Chunk* mapChunk(SecureArena* arena, size_t minSize) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = std::max(kChunkSize, (minSize + page - 1) / page * page);
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+#ifdef MADV_DONTDUMP
+    madvise(base, size, MADV_DONTDUMP);
+#endif
+
+    Chunk* chunk = new Chunk();
+    chunk->arena = arena;
+    chunk->base = static_cast<uint8_t*>(base);
+    chunk->size = size;
+    chunk->used = 0;
+    // Over RLIMIT_MEMLOCK the pages stay usable, just swappable
+    chunk->locked = mlock(base, size) == 0;
+    chunk->live.store(0, std::memory_order_relaxed);
+    return chunk;
+}
+
+// Zeroes a chunk whose blocks have all been freed and makes it reusable
+bool rewind(Chunk* chunk) {
+    if (chunk->live.load(std::memory_order_acquire) != 0) return false;
+    if (chunk->used != 0) {
+        OPENSSL_cleanse(chunk->base, chunk->used);
+        chunk->used = 0;
+    }
+    return true;
+}
+
+struct ArenaSlot {
+    SecureArena* arena = nullptr;
+    bool exited = false;
+
+    ~ArenaSlot() {
+        exited = true;
+        if (!arena) return;
+        for (Chunk* chunk : arena->chunks) rewind(chunk);
+        release(arena);  // blocks still held elsewhere keep the arena alive
+        arena = nullptr;
+    }
+};
+
+thread_local ArenaSlot slot;
+
+} // namespace
+
+void* secureAllocate(size_t size) {
+    size_t need = sizeof(BlockHeader) + ((size + 15) & ~static_cast<size_t>(15));
+    if (need < size) throw std::bad_alloc();
+
+    if (slot.exited) {
+        BlockHeader* header = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + size));
+        header->chunk = nullptr;
+        header->size = size;
+        return header + 1;
+    }
+
+    if (!slot.arena) slot.arena = new SecureArena();
+    SecureArena* arena = slot.arena;
+
+    Chunk* chunk = arena->chunks.empty() ? nullptr : arena->chunks[arena->current];
+    if (chunk) rewind(chunk);
+    if (!chunk || chunk->size - chunk->used < need) {
+        chunk = nullptr;
+        for (size_t i = 0; i < arena->chunks.size(); i++) {
+            if (arena->chunks[i]->size >= need && rewind(arena->chunks[i])) {
+                chunk = arena->chunks[i];
+                arena->current = i;
+                break;
+            }
+        }
+        if (!chunk) {
+            chunk = mapChunk(arena, need);
+            arena->chunks.push_back(chunk);
+            arena->current = arena->chunks.size() - 1;
+        }
+    }
+
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(chunk->base + chunk->used);
+    chunk->used += need;
+    header->chunk = chunk;
+    header->size = size;
+    chunk->live.fetch_add(1, std::memory_order_relaxed);
+    arena->refs.fetch_add(1, std::memory_order_relaxed);
+    return header + 1;
+}
+
+void secureDeallocate(void* block) noexcept {
+    if (!block) return;
+    BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+    Chunk* chunk = header->chunk;
+    if (!chunk) {
+        OPENSSL_cleanse(header, sizeof(BlockHeader) + header->size);
+        ::operator delete(header);
+        return;
+    }
+    SecureArena* arena = chunk->arena;
+    chunk->live.fetch_sub(1, std::memory_order_release);
+    release(arena);
+}
+
+bool secureArenaReset() {
+    if (!slot.arena) return true;
+    bool allEmpty = true;
+    for (Chunk* chunk : slot.arena->chunks) {
+        allEmpty = rewind(chunk) && allEmpty;
+    }
+    return allEmpty;
+}
+
+SecureArenaStats secureArenaStats() {
+    SecureArenaStats stats;
+    if (!slot.arena) return stats;
+    for (const Chunk* chunk : slot.arena->chunks) {
+        stats.chunks++;
+        stats.reservedBytes += chunk->size;
+        if (chunk->locked) stats.lockedBytes += chunk->size;
+        stats.usedBytes += chunk->used;
+        stats.liveBlocks += chunk->live.load(std::memory_order_acquire);
+    }
+    return stats;
+}
+
+bool secureArenaOwns(const void* pointer) {
+    if (!slot.arena) return false;
+    const uint8_t* p = static_cast<const uint8_t*>(pointer);
+    for (const Chunk* chunk : slot.arena->chunks) {
+        if (p >= chunk->base && p < chunk->base + chunk->size) return true;
+    }
+    return false;
+}
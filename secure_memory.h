@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * Locked, non-dumpable storage for key material.
+ *
+ * Every thread owns an arena of mlock'd chunks marked MADV_DONTDUMP (not
+ * swapped, left out of core dumps). SecureAllocator bump-allocates from the
+ * calling thread's arena; freeing a block only decrements its chunk's live
+ * count, and a chunk is zeroed in one pass and reused once it is empty. Blocks
+ * may be freed on any thread, so buffers can travel through queues.
+ *
+ * Zeroing happens when the owning thread next allocates from an empty chunk,
+ * on secureArenaReset() (call it between batches) and at thread exit.
+ */
+
+void* secureAllocate(size_t size);
+void secureDeallocate(void* block) noexcept;
+
+// Zeroes and rewinds every empty chunk of the calling thread's arena.
+// Returns false if some blocks are still live (those chunks are left alone).
+bool secureArenaReset();
+
+struct SecureArenaStats {
+    size_t chunks = 0;
+    size_t reservedBytes = 0;  // mapped for this thread's arena
+    size_t lockedBytes = 0;    // of which mlock succeeded (RLIMIT_MEMLOCK)
+    size_t usedBytes = 0;      // bumped since the chunks were last zeroed
+    size_t liveBlocks = 0;
+};
+
+// For the calling thread's arena
+SecureArenaStats secureArenaStats();
+bool secureArenaOwns(const void* pointer);
+
+template <typename T>
+class SecureAllocator {
+public:
+    using value_type = T;
+
+    SecureAllocator() noexcept = default;
+    template <typename U>
+    SecureAllocator(const SecureAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n > static_cast<size_t>(-1) / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T*>(secureAllocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t) noexcept {
+        secureDeallocate(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const SecureAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const SecureAllocator<U>&) const noexcept { return false; }
+};
+
+using SecureBytes = std::vector<uint8_t, SecureAllocator<uint8_t>>;
+using SecureString = std::basic_string<char, std::char_traits<char>, SecureAllocator<char>>;
+
+// Read-only view so primitives accept secure and ordinary buffers alike
+class ByteView {
+public:
+    ByteView(const uint8_t* data, size_t size) : ptr(data), len(size) {}
+    ByteView(const std::vector<uint8_t>& bytes) : ptr(bytes.data()), len(bytes.size()) {}
+    ByteView(const SecureBytes& bytes) : ptr(bytes.data()), len(bytes.size()) {}
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    const uint8_t* begin() const { return ptr; }
+    const uint8_t* end() const { return ptr + len; }
+
+private:
+    const uint8_t* ptr;
+    size_t len;
+};
@@ -0,0 +1,206 @@
+#include "seed_cache.h"
+#include "key_file.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+namespace {
+
+const char kMagic[4] = {'W', 'G', 'S', 'C'};
+const uint8_t kVersion = 1;
+const size_t kHeaderSize = 16;
+const size_t kNonceSize = 12;
+const size_t kSeedSize = 64;
+const size_t kTagSize = 16;
+
+SecureBytes hmacSha256(const SecureBytes& key, const uint8_t* data, size_t len) {
+    SecureBytes out(32);
+    unsigned int outLen = 0;
+    if (!HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), data, len, out.data(), &outLen) || outLen != 32) {
+        throw std::runtime_error("HMAC-SHA256 failed");
+    }
+    return out;
+}
+
+SecureBytes subkey(const SecureBytes& hostKey, const char* label) {
+    return hmacSha256(hostKey, reinterpret_cast<const uint8_t*>(label), std::strlen(label));
+}
+
+bool writeAll(int fd, const uint8_t* data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = ::write(fd, data + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+SeedCache::SeedCache(const std::string& path, const std::string& keyPath) : path(path) {
+    SecureBytes hostKey = loadKeyFile(keyPath, "Seed cache host key", true);
+    idKey = subkey(hostKey, "walletgen seed cache id");
+    encryptionKey = subkey(hostKey, "walletgen seed cache encryption");
+    readFile(path, entries);
+}
+
+std::string SeedCache::defaultKeyPath() {
+    const char* config = std::getenv("XDG_CONFIG_HOME");
+    if (config && *config) return std::string(config) + "/walletgen/host.key";
+    const char* home = std::getenv("HOME");
+    if (!home || !*home) throw std::runtime_error("No HOME for the seed cache host key; use --seed-cache-key FILE");
+    return std::string(home) + "/.config/walletgen/host.key";
+}
+
+SeedCache::Id SeedCache::entryId(const std::string& mnemonic, const std::string& passphrase) const {
+    SecureString text(mnemonic.data(), mnemonic.size());
+    text.push_back('\0');
+    text.append(passphrase.data(), passphrase.size());
+    SecureBytes mac = hmacSha256(idKey, reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    return Id(mac.begin(), mac.begin() + kIdSize);
+}
+
+bool SeedCache::lookup(const std::string& mnemonic, const std::string& passphrase, SecureBytes& seed) {
+    Id id = entryId(mnemonic, passphrase);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(id);
+    bool found = false;
+    if (it != entries.end()) {
+        const uint8_t* nonce = it->second.bytes;
+        const uint8_t* ciphertext = nonce + kNonceSize;
+        const uint8_t* tag = ciphertext + kSeedSize;
+        SecureBytes plain(kSeedSize);
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+        int len = 0;
+        found = ctx && EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, encryptionKey.data(), nonce) == 1 &&
+                EVP_DecryptUpdate(ctx, nullptr, &len, id.data(), static_cast<int>(id.size())) == 1 &&
+                EVP_DecryptUpdate(ctx, plain.data(), &len, ciphertext, static_cast<int>(kSeedSize)) == 1 &&
+                EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(kTagSize), const_cast<uint8_t*>(tag)) == 1 &&
+                EVP_DecryptFinal_ex(ctx, plain.data() + len, &len) == 1;
+        EVP_CIPHER_CTX_free(ctx);
+        if (found) seed = std::move(plain);
+    }
+    (found ? hitCount : missCount)++;
+    return found;
+}
+
+void SeedCache::insert(const std::string& mnemonic, const std::string& passphrase, const SecureBytes& seed) {
+    if (seed.size() != kSeedSize) throw std::runtime_error("Seed cache entries must be 64-byte seeds");
+    Id id = entryId(mnemonic, passphrase);
+    Sealed sealed;
+    uint8_t* nonce = sealed.bytes;
+    uint8_t* ciphertext = nonce + kNonceSize;
+    uint8_t* tag = ciphertext + kSeedSize;
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    int len = 0;
+    bool ok = ctx && RAND_bytes(nonce, static_cast<int>(kNonceSize)) == 1 &&
+              EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, encryptionKey.data(), nonce) == 1 &&
+              EVP_EncryptUpdate(ctx, nullptr, &len, id.data(), static_cast<int>(id.size())) == 1 &&
+              EVP_EncryptUpdate(ctx, ciphertext, &len, seed.data(), static_cast<int>(kSeedSize)) == 1 &&
+              EVP_EncryptFinal_ex(ctx, ciphertext + len, &len) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(kTagSize), tag) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    if (!ok) throw std::runtime_error("Seed cache encryption failed");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[id] = sealed;
+    added[id] = sealed;
+}
+
+void SeedCache::readFile(const std::string& file, std::map<Id, Sealed>& out) {
+    struct stat st;
+    if (::stat(file.c_str(), &st) != 0 && errno == ENOENT) return;
+    std::ifstream in(file, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open seed cache " + file);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < kHeaderSize || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a seed cache: " + file);
+    }
+    if (data[4] != kVersion) throw std::runtime_error("Unsupported seed cache version " + std::to_string(data[4]));
+    uint64_t count = 0;
+    for (int i = 0; i < 8; i++) count |= static_cast<uint64_t>(data[8 + i]) << (8 * i);
+    const size_t entrySize = kIdSize + sizeof(Sealed);
+    if ((data.size() - kHeaderSize) % entrySize != 0 || (data.size() - kHeaderSize) / entrySize != count) {
+        throw std::runtime_error("Seed cache is truncated: " + file);
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        const uint8_t* entry = data.data() + kHeaderSize + i * entrySize;
+        Sealed sealed;
+        std::memcpy(sealed.bytes, entry + kIdSize, sizeof(sealed.bytes));
+        out[Id(entry, entry + kIdSize)] = sealed;
+    }
+}
+
+void SeedCache::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (added.empty()) return;
+
+    // Other processes may have saved since this one loaded: merge under the
+    // lock, then rename a complete file into place
+    const std::string lockPath = path + ".lock";
+    int lockFd = ::open(lockPath.c_str(), O_RDWR | O_CREAT, 0600);
+    if (lockFd < 0 || ::flock(lockFd, LOCK_EX) != 0) {
+        int error = errno;
+        if (lockFd >= 0) ::close(lockFd);
+        throw std::runtime_error("Cannot lock " + lockPath + ": " + strerror(error));
+    }
+    try {
+        std::map<Id, Sealed> merged;
+        readFile(path, merged);
+        for (const auto& entry : added) merged[entry.first] = entry.second;
+
+        std::vector<uint8_t> data(kHeaderSize);
+        std::memcpy(data.data(), kMagic, sizeof(kMagic));
+        data[4] = kVersion;
+        for (int i = 0; i < 8; i++) data[8 + i] = static_cast<uint8_t>(static_cast<uint64_t>(merged.size()) >> (8 * i));
+        for (const auto& entry : merged) {
+            data.insert(data.end(), entry.first.begin(), entry.first.end());
+            data.insert(data.end(), entry.second.bytes, entry.second.bytes + sizeof(entry.second.bytes));
+        }
+
+        const std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) throw std::runtime_error("Cannot write " + tmp + ": " + strerror(errno));
+        bool ok = writeAll(fd, data.data(), data.size()) && ::fsync(fd) == 0;
+        ok = ::close(fd) == 0 && ok;
+        if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+            int error = errno;
+            ::unlink(tmp.c_str());
+            throw std::runtime_error("Cannot write seed cache " + path + ": " + strerror(error));
+        }
+        entries.swap(merged);
+        added.clear();
+    } catch (...) {
+        ::close(lockFd);
+        throw;
+    }
+    ::close(lockFd);
+}
+
+uint64_t SeedCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hitCount;
+}
+
+uint64_t SeedCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return missCount;
+}
+
+std::string SeedCache::report() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::to_string(hitCount) + (hitCount == 1 ? " hit, " : " hits, ") + std::to_string(missCount) +
+           (missCount == 1 ? " miss" : " misses");
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "secure_memory.h"
+
+/**
+ * Encrypted seed cache (--seed-cache FILE).
+ *
+ * Keeps the 64-byte BIP39 seed of each (mnemonic, passphrase) pair seen, so a
+ * repeat run skips the 2048 PBKDF2 rounds and goes straight to path
+ * derivation. Entries are encrypted at rest with AES-256-GCM under a 32-byte
+ * host key kept in a separate file (--seed-cache-key, by default
+ * ~/.config/walletgen/host.key, created mode 0600 on first use):
+ *
+ *   0   "WGSC"
+ *   4   format version (1)
+ *   8   entry count, uint64 little-endian
+ *   16  entries, 108 bytes each: id (16), nonce (12), ciphertext (64), tag (16)
+ *
+ * The id is an HMAC of the mnemonic and passphrase under the host key, so
+ * the file reveals neither, and the tag authenticates the ciphertext and
+ * the id together. Entries that do not decrypt (another host's key, damage)
+ * count as misses and are left in place.
+ *
+ * save() merges with whatever other processes wrote to the file meanwhile
+ * and replaces it atomically, under an advisory lock on FILE.lock.
+ * Thread-safe.
+ */
+
+class SeedCache {
+public:
+    static const size_t kIdSize = 16;
+
+    // Loads the cache (a missing file is an empty cache) and the host key,
+    // creating the key file if it does not exist
+    SeedCache(const std::string& path, const std::string& keyPath);
+
+    SeedCache(const SeedCache&) = delete;
+    SeedCache& operator=(const SeedCache&) = delete;
+
+    // ~/.config/walletgen/host.key, honouring XDG_CONFIG_HOME
+    static std::string defaultKeyPath();
+
+    // The cached seed, if any; counts a hit or a miss
+    bool lookup(const std::string& mnemonic, const std::string& passphrase, SecureBytes& seed);
+    void insert(const std::string& mnemonic, const std::string& passphrase, const SecureBytes& seed);
+
+    // Writes entries added since loading; no-op if there are none
+    void save();
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+    // "2 hits, 1 miss"
+    std::string report() const;
+
+private:
+    struct Sealed {
+        uint8_t bytes[12 + 64 + 16];  // nonce, ciphertext, tag
+    };
+    typedef std::vector<uint8_t> Id;
+
+    std::string path;
+    SecureBytes idKey;
+    SecureBytes encryptionKey;
+    std::map<Id, Sealed> entries;
+    std::map<Id, Sealed> added;  // since loading, to merge on save
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+    mutable std::mutex mutex;
+
+    Id entryId(const std::string& mnemonic, const std::string& passphrase) const;
+    static void readFile(const std::string& path, std::map<Id, Sealed>& out);
+};
@@ -0,0 +1,288 @@
+#include "shm_ring.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[4] = {'W', 'G', 'R', 'G'};
+
+void closeAll(const int* fds, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (fds[i] >= 0) ::close(fds[i]);
+    }
+}
+
+// Value of a string field in a flat JSON reply line, unescaped enough for
+// error messages
+std::string replyField(const std::string& line, const std::string& key) {
+    const std::string marker = "\"" + key + "\":\"";
+    size_t start = line.find(marker);
+    if (start == std::string::npos) return "";
+    start += marker.size();
+    std::string value;
+    for (size_t i = start; i < line.size() && line[i] != '"'; i++) {
+        if (line[i] == '\\' && i + 1 < line.size()) i++;
+        value += line[i];
+    }
+    return value;
+}
+
+} // namespace
+
+size_t RingMapping::mappedSize(uint32_t slots) {
+    return kHeaderSize + static_cast<size_t>(slots) * (sizeof(RingRequest) + sizeof(RingResponse));
+}
+
+RingMapping RingMapping::create(uint32_t slots) {
+    if (slots == 0 || slots > kRingMaxSlots || (slots & (slots - 1)) != 0) {
+        throw std::runtime_error("Ring slots must be a power of two up to " + std::to_string(kRingMaxSlots));
+    }
+    int fd = memfd_create("walletgen-ring", MFD_CLOEXEC);
+    if (fd < 0) throw std::runtime_error(std::string("memfd_create failed: ") + strerror(errno));
+    const size_t size = mappedSize(slots);
+    void* base = ftruncate(fd, static_cast<off_t>(size)) == 0
+                     ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                     : MAP_FAILED;
+    if (base == MAP_FAILED) {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error(std::string("Cannot map ring: ") + strerror(error));
+    }
+    // Mnemonics and keys pass through here: keep them out of swap and core
+    // dumps where the limits allow
+    madvise(base, size, MADV_DONTDUMP);
+    mlock(base, size);
+
+    RingHeader* header = new (base) RingHeader();
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->version = kRingVersion;
+    header->slots = slots;
+    header->requestSize = sizeof(RingRequest);
+    header->responseSize = sizeof(RingResponse);
+    header->requestHead.store(0);
+    header->requestTail.store(0);
+    header->responseHead.store(0);
+    header->responseTail.store(0);
+    return RingMapping(fd, base, size, slots);
+}
+
+RingMapping RingMapping::attach(int fd) {
+    struct stat st;
+    void* base = MAP_FAILED;
+    size_t size = 0;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= kHeaderSize) {
+        size = static_cast<size_t>(st.st_size);
+        base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map the ring from the daemon");
+    }
+    const RingHeader* header = static_cast<const RingHeader*>(base);
+    uint32_t slots = header->slots;
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kRingVersion ||
+        header->requestSize != sizeof(RingRequest) || header->responseSize != sizeof(RingResponse) ||
+        slots == 0 || slots > kRingMaxSlots || (slots & (slots - 1)) != 0 || mappedSize(slots) != size) {
+        munmap(base, size);
+        ::close(fd);
+        throw std::runtime_error("Ring layout does not match this client");
+    }
+    madvise(base, size, MADV_DONTDUMP);
+    mlock(base, size);
+    return RingMapping(fd, base, size, slots);
+}
+
+RingMapping::RingMapping(RingMapping&& other) noexcept
+    : memfd(other.memfd), base(other.base), size(other.size), slotCount(other.slotCount) {
+    other.memfd = -1;
+    other.base = nullptr;
+    other.size = 0;
+}
+
+RingMapping& RingMapping::operator=(RingMapping&& other) noexcept {
+    // other unmaps what this held when it goes
+    std::swap(memfd, other.memfd);
+    std::swap(base, other.base);
+    std::swap(size, other.size);
+    std::swap(slotCount, other.slotCount);
+    return *this;
+}
+
+RingMapping::~RingMapping() {
+    if (base) munmap(base, size);
+    if (memfd >= 0) ::close(memfd);
+}
+
+RingRequest& RingMapping::request(uint64_t index) const {
+    RingRequest* records = reinterpret_cast<RingRequest*>(static_cast<char*>(base) + kHeaderSize);
+    return records[index & (slotCount - 1)];
+}
+
+RingResponse& RingMapping::response(uint64_t index) const {
+    RingResponse* records = reinterpret_cast<RingResponse*>(static_cast<char*>(base) + kHeaderSize +
+                                                            static_cast<size_t>(slotCount) * sizeof(RingRequest));
+    return records[index & (slotCount - 1)];
+}
+
+void ringSignal(int eventFd) {
+    uint64_t one = 1;
+    ssize_t ignored = ::write(eventFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void ringReset(int eventFd) {
+    uint64_t counter;
+    ssize_t ignored = ::read(eventFd, &counter, sizeof(counter));
+    (void)ignored;
+}
+
+bool sendRingDescriptors(int socketFd, const std::string& line, const int fds[3]) {
+    iovec iov{};
+    iov.iov_base = const_cast<char*>(line.data());
+    iov.iov_len = line.size();
+    alignas(cmsghdr) char control[CMSG_SPACE(3 * sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(3 * sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), fds, 3 * sizeof(int));
+    ssize_t n;
+    do {
+        n = sendmsg(socketFd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == static_cast<ssize_t>(line.size());
+}
+
+RingClient::Descriptors RingClient::handshake(const std::string& socketPath, uint32_t slots) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) throw std::runtime_error("Socket path too long: " + socketPath);
+    socketPath.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        int error = errno;
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("Cannot connect to " + socketPath + ": " + strerror(error));
+    }
+
+    const std::string request = "{\"op\":\"ring\",\"slots\":" + std::to_string(slots) + "}\n";
+    Descriptors fds{fd, -1, -1, -1};
+    std::string reply;
+    bool sent = ::send(fd, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size());
+    // The descriptors ride on the first byte of the reply
+    while (sent && (reply.empty() || reply.back() != '\n')) {
+        char buffer[256];
+        iovec iov{buffer, sizeof(buffer)};
+        alignas(cmsghdr) char control[CMSG_SPACE(3 * sizeof(int))] = {};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+                cmsg->cmsg_len == CMSG_LEN(3 * sizeof(int)) && fds.memfd < 0) {
+                int received[3];
+                std::memcpy(received, CMSG_DATA(cmsg), sizeof(received));
+                fds.memfd = received[0];
+                fds.requestEvent = received[1];
+                fds.responseEvent = received[2];
+            }
+        }
+        reply.append(buffer, static_cast<size_t>(n));
+    }
+
+    if (reply.compare(0, 10, "{\"ok\":true") != 0 || fds.memfd < 0) {
+        int all[] = {fds.socketFd, fds.memfd, fds.requestEvent, fds.responseEvent};
+        closeAll(all, 4);
+        std::string error = replyField(reply, "error");
+        throw std::runtime_error("Daemon refused the ring: " + (error.empty() ? std::string("no reply") : error));
+    }
+    return fds;
+}
+
+RingMapping RingClient::attachOrClose(const Descriptors& fds) {
+    try {
+        return RingMapping::attach(fds.memfd);
+    } catch (...) {
+        int others[] = {fds.socketFd, fds.requestEvent, fds.responseEvent};
+        closeAll(others, 3);
+        throw;
+    }
+}
+
+RingClient::RingClient(const std::string& socketPath, uint32_t slots) : RingClient(handshake(socketPath, slots)) {}
+
+RingClient::RingClient(const Descriptors& fds)
+    : socketFd(fds.socketFd),
+      requestEvent(fds.requestEvent),
+      responseEvent(fds.responseEvent),
+      ring(attachOrClose(fds)),
+      requestHead(ring.header().requestHead.load(std::memory_order_relaxed)),
+      responseTail(ring.header().responseTail.load(std::memory_order_relaxed)) {}
+
+RingClient::~RingClient() {
+    int fds[] = {socketFd, requestEvent, responseEvent};
+    closeAll(fds, 3);
+}
+
+RingRequest* RingClient::nextRequest() {
+    uint64_t tail = ring.header().requestTail.load(std::memory_order_acquire);
+    if (requestHead - tail >= ring.slots()) return nullptr;
+    RingRequest* request = &ring.request(requestHead++);
+    std::memset(request, 0, sizeof(*request));
+    return request;
+}
+
+void RingClient::publish() {
+    ring.header().requestHead.store(requestHead, std::memory_order_release);
+    ringSignal(requestEvent);
+}
+
+const RingResponse* RingClient::nextResponse(int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+    for (;;) {
+        ringReset(responseEvent);
+        if (responseTail != ring.header().responseHead.load(std::memory_order_acquire)) {
+            return &ring.response(responseTail++);
+        }
+
+        int wait = -1;
+        if (timeoutMs >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0) return nullptr;
+            wait = static_cast<int>(left.count());
+        }
+        // The daemon never writes to the socket after the handshake: any
+        // activity there means it went away
+        pollfd fds[2] = {{responseEvent, POLLIN, 0}, {socketFd, POLLIN, 0}};
+        int n = poll(fds, 2, wait);
+        if (n < 0 && errno != EINTR) throw std::runtime_error(std::string("poll failed: ") + strerror(errno));
+        if (n > 0 && fds[1].revents) throw std::runtime_error("Daemon closed the ring");
+    }
+}
+
+void RingClient::release() {
+    ring.header().responseTail.store(responseTail, std::memory_order_release);
+    ringSignal(requestEvent);
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Shared-memory transport for clients on the same host ({"op":"ring"}).
+ *
+ * A client sends {"op":"ring","slots":N} as the first line of a --serve
+ * connection. The daemon answers with one JSON line carrying three file
+ * descriptors (SCM_RIGHTS): a memfd holding two single-producer,
+ * single-consumer rings, and two eventfds. The client writes fixed-size
+ * RingRequest records into the request ring; the daemon answers every
+ * request with RingResponse records, one per wallet, in the response ring.
+ * Keys are binary and text fields are NUL-terminated, so nothing is
+ * serialized or copied through the kernel.
+ *
+ *   0      RingHeader (one page): magic "WGRG", version, slot count, record
+ *          sizes, then the four ring indices on cache lines of their own
+ *   4096   request ring, N RingRequest records
+ *          response ring, N RingResponse records
+ *
+ * Indices count records since the ring was created; a record lives in slot
+ * index % N (N is a power of two). Each index has one writer, which
+ * publishes it with a release store after filling or reading records.
+ *
+ * The first eventfd is signalled by the client after publishing requests
+ * or releasing responses, the second by the daemon after publishing
+ * responses: once per batch, not per record. Each side resets its eventfd
+ * before looking at the rings, so a signal is never lost between a check
+ * and a wait.
+ *
+ * One daemon thread serves each ring and coalesces its requests into
+ * multi-lane KDF passes. The daemon copies each request out of shared
+ * memory before checking it and wipes the slot; a client that publishes
+ * impossible indices loses its ring. The ring lives until the client
+ * closes the socket. Linux only.
+ */
+
+const uint32_t kRingVersion = 1;
+const uint32_t kRingDefaultSlots = 256;
+const uint32_t kRingMaxSlots = 65536;
+
+enum class RingOp : uint8_t {
+    Ping = 0,
+    Seed = 1,      // the BIP39 seed, in RingResponse::seed
+    Generate = 2   // count wallets from start (or path), one response each
+};
+
+struct RingRequest {
+    uint64_t id;          // echoed in every response
+    RingOp op;
+    uint8_t reserved[3];
+    uint32_t start;       // first address index
+    uint32_t count;       // wallets to derive
+    char network[16];     // NUL-terminated; empty means bitcoin
+    char path[96];        // a fixed path instead of start/count indexing
+    char mnemonic[256];
+    char passphrase[128];
+};
+
+struct RingResponse {
+    uint64_t id;
+    uint32_t index;       // wallet within the request, from 0
+    uint8_t ok;
+    uint8_t last;         // last response of its request
+    uint8_t reserved[2];
+    uint8_t privateKey[32];
+    uint8_t publicKey[65]; // uncompressed
+    uint8_t seed[64];
+    char address[96];
+    char wif[64];
+    char path[96];
+    char error[128];       // set when ok is 0
+};
+
+struct RingHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t slots;
+    uint32_t requestSize;
+    uint32_t responseSize;
+    alignas(64) std::atomic<uint64_t> requestHead;   // client
+    alignas(64) std::atomic<uint64_t> requestTail;   // daemon
+    alignas(64) std::atomic<uint64_t> responseHead;  // daemon
+    alignas(64) std::atomic<uint64_t> responseTail;  // client
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring indices must be lock-free to be shared");
+static_assert(sizeof(RingHeader) <= 4096, "ring header must fit its page");
+
+// A mapped ring memfd, on either side
+class RingMapping {
+public:
+    static const size_t kHeaderSize = 4096;
+
+    // Creates and maps a ring (daemon side). Throws std::runtime_error if
+    // slots is not a power of two up to kRingMaxSlots.
+    static RingMapping create(uint32_t slots);
+    // Maps a ring received from the daemon and checks its header
+    static RingMapping attach(int fd);
+
+    RingMapping(RingMapping&& other) noexcept;
+    RingMapping& operator=(RingMapping&& other) noexcept;
+    ~RingMapping();
+
+    RingMapping(const RingMapping&) = delete;
+    RingMapping& operator=(const RingMapping&) = delete;
+
+    int fd() const { return memfd; }
+    RingHeader& header() const { return *static_cast<RingHeader*>(base); }
+    // As created or checked at attach; the header copy is writable by the peer
+    uint32_t slots() const { return slotCount; }
+    RingRequest& request(uint64_t index) const;
+    RingResponse& response(uint64_t index) const;
+
+    static size_t mappedSize(uint32_t slots);
+
+private:
+    RingMapping(int fd, void* base, size_t size, uint32_t slots)
+        : memfd(fd), base(base), size(size), slotCount(slots) {}
+
+    int memfd;
+    void* base;
+    size_t size;
+    uint32_t slotCount;
+};
+
+// Reference client. Not thread-safe: one thread submits and reads, as the
+// rings have a single producer and consumer on each side. The daemon stops
+// writing once slots() responses are unreleased, so release() at least that
+// often.
+//
+//   RingClient client("/run/walletgen.sock");
+//   RingRequest* request = client.nextRequest();   // nullptr when full
+//   ... fill *request ...
+//   client.publish();
+//   while (const RingResponse* response = client.nextResponse(1000)) {
+//       ... read *response in place ...
+//       if (response->last) break;
+//   }
+//   client.release();
+class RingClient {
+public:
+    // Connects and attaches a ring; throws std::runtime_error if the daemon
+    // refuses (bad slot count, too many rings) or cannot be reached
+    explicit RingClient(const std::string& socketPath, uint32_t slots = kRingDefaultSlots);
+    ~RingClient();
+
+    RingClient(const RingClient&) = delete;
+    RingClient& operator=(const RingClient&) = delete;
+
+    uint32_t slots() const { return ring.slots(); }
+
+    // A zeroed request slot to fill in, or nullptr if the ring is full
+    RingRequest* nextRequest();
+    // Hands every request filled since the last publish to the daemon
+    void publish();
+
+    // The next response, read in place, or nullptr if none arrives within
+    // timeoutMs (-1 waits forever). Valid until release().
+    const RingResponse* nextResponse(int timeoutMs = -1);
+    // Returns the slots of every response read so far to the daemon
+    void release();
+
+private:
+    int socketFd;
+    int requestEvent;
+    int responseEvent;
+    RingMapping ring;
+    uint64_t requestHead;   // filled, maybe not yet published
+    uint64_t responseTail;  // read, maybe not yet released
+
+    struct Descriptors {
+        int socketFd;
+        int memfd;
+        int requestEvent;
+        int responseEvent;
+    };
+
+    explicit RingClient(const Descriptors& fds);
+    static Descriptors handshake(const std::string& socketPath, uint32_t slots);
+    static RingMapping attachOrClose(const Descriptors& fds);
+};
+
+// Sends the three ring descriptors with a reply line (daemon side)
+bool sendRingDescriptors(int socketFd, const std::string& line, const int fds[3]);
+
+// Signals an eventfd, and clears one before the rings are checked
+void ringSignal(int eventFd);
+void ringReset(int eventFd);
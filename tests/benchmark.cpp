@@ -0,0 +1,417 @@
+/**
+ * Microbenchmarks for the generator primitives and end-to-end generation.
+ *
+ * Each benchmark is warmed up, calibrated so one sample lasts at least
+ * --min-sample-ms, then sampled --samples times. Samples outside Tukey's
+ * fences (1.5 IQR beyond the quartiles) are dropped as outliers (scheduler
+ * noise, page faults) before the median, p99 and mean are computed. Times
+ * are nanoseconds per operation.
+ *
+ * Usage: ./benchmark_suite [--filter TEXT] [--samples N] [--min-sample-ms N]
+ *                          [--json FILE] [--baseline FILE] [--tolerance PCT]
+ *                          [--cpu-features LIST] [--ec-backend NAME]
+ *                          [--ec-table FILE]
+ *
+ * With --baseline, medians are compared against a previous --json run and
+ * the exit status is 1 if any benchmark is slower by more than --tolerance
+ * percent (default 15). Baselines are only meaningful on the same machine
+ * and build flags. --cpu-features times one kernel variant set, as in
+ * wallet_generator (e.g. "none" for the baseline kernels); --ec-backend
+ * selects the backend of the end-to-end benchmarks. The ec_* benchmarks
+ * run every backend; with --ec-table the native one uses the mapped table.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <openssl/ec.h>
+#include <openssl/obj_mac.h>
+#include "../wallet_generator.h"
+#include "../crypto_kernels.h"
+#include "../cpu_features.h"
+#include "../ec_backend.h"
+#include "../encrypted_output.h"
+
+struct BenchmarkResult {
+    std::string name;
+    uint64_t opsPerSample;
+    size_t samples;
+    size_t outliers;
+    double minNs;
+    double medianNs;
+    double p99Ns;
+    double meanNs;
+};
+
+struct BenchmarkOptions {
+    std::string filter;
+    size_t samples = 31;
+    double minSampleMs = 5.0;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerancePct = 15.0;
+};
+
+// Consumes results so the optimizer cannot drop the benchmarked calls
+static volatile uint8_t sink;
+
+template <typename Container>
+static void consume(const Container& c) {
+    if (!c.empty()) sink = sink ^ static_cast<uint8_t>(c[0]);
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    double rank = p * (sorted.size() - 1);
+    size_t lo = static_cast<size_t>(std::floor(rank));
+    size_t hi = static_cast<size_t>(std::ceil(rank));
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+}
+
+class WalletGeneratorBenchmark {
+public:
+    explicit WalletGeneratorBenchmark(const BenchmarkOptions& options) : options(options) {}
+
+    std::vector<BenchmarkResult> runAll() {
+        const std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        const std::vector<uint8_t> seed = generator.mnemonicToSeed(mnemonic);
+        const std::vector<uint8_t> chainKey = {'B', 'i', 't', 'c', 'o', 'i', 'n', ' ', 's', 'e', 'e', 'd'};
+        std::vector<uint8_t> hmacData(seed);
+        hmacData.insert(hmacData.end(), 16, 0x2F);
+        const std::vector<uint8_t> key32(seed.begin(), seed.begin() + 32);
+        const std::vector<uint8_t> pubkey33(33, 0x02);
+        const std::vector<uint8_t> pubkey64(64, 0x5A);
+        std::vector<uint8_t> address25(25, 0x00);
+        for (size_t i = 1; i < address25.size(); i++) address25[i] = static_cast<uint8_t>(i * 37);
+
+        // Primitives
+        run("pbkdf2_sha512_2048", [&]() { consume(generator.pbkdf2(mnemonic, "mnemonic", 2048, 64)); });
+        run("pbkdf2_sha512_batch4_per_seed", [&]() {
+            consume(generator.mnemonicToSeedBatch({mnemonic, mnemonic, mnemonic, mnemonic})[3]);
+        }, 4);
+        run("hmac_sha512_80B", [&]() { consume(generator.hmacSha512(chainKey, hmacData)); });
+        run("sha256_33B", [&]() { consume(generator.sha256(pubkey33)); });
+        run("ripemd160_32B", [&]() { consume(generator.ripemd160(key32)); });
+        run("keccak256_64B", [&]() { consume(generator.keccak256(pubkey64)); });
+        run("base58_encode_25B", [&]() { consume(generator.base58Encode(address25)); });
+        run("bytes_to_hex_32B", [&]() { consume(generator.bytesToHex(key32)); });
+        // The stringstream encoding bytesToHex used before the hex kernels, for reference
+        const std::vector<uint8_t> pubkey65(65, 0x4B);
+        run("hex_stringstream_65B", [&]() {
+            std::stringstream ss;
+            for (uint8_t b : pubkey65) ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(b);
+            consume(ss.str());
+        });
+        run("bytes_to_hex_65B", [&]() { consume(generator.bytesToHex(pubkey65)); });
+        const std::string seedHex = generator.bytesToHex(seed);
+        std::vector<uint8_t> decoded(64);
+        run("hex_decode_64B", [&]() {
+            if (kernels().hexDecode(seedHex.data(), 64, decoded.data())) sink = sink ^ decoded[63];
+        });
+        run("derive_key", [&]() { consume(generator.deriveKey(seed, "m/44'/0'/0'/0/0")); });
+        std::vector<std::string> siblingPaths;
+        for (uint32_t i = 0; i < 8; i++) siblingPaths.push_back(WalletGenerator::indexedPath("bitcoin", i));
+        run("derive_keys_x8_per_key", [&]() { consume(generator.deriveKeys(seed, siblingPaths)[7]); }, 8);
+
+        // Every EC backend on the same keys
+        std::vector<uint8_t> batchKeys(32 * 16);
+        std::vector<const uint8_t*> batchKeyPointers;
+        for (size_t i = 0; i < 16; i++) {
+            std::copy(key32.begin(), key32.end(), batchKeys.begin() + 32 * i);
+            batchKeys[32 * i + 31] = static_cast<uint8_t>(i);
+            batchKeyPointers.push_back(&batchKeys[32 * i]);
+        }
+        for (const std::string& name : ecBackendNames()) {
+            std::unique_ptr<EcBackend> backend = createEcBackend(name);
+            EcPubkey pubkey;
+            run("ec_" + name + "_create", [&]() {
+                if (backend->pubkeyCreate(key32.data(), pubkey)) sink = sink ^ pubkey.xy[63];
+            });
+            std::vector<EcPubkey> pubkeys(16);
+            bool ok[16];
+            run("ec_" + name + "_x16_per_key", [&]() {
+                backend->pubkeyCreateBatch(batchKeyPointers.data(), 16, pubkeys.data(), ok);
+                sink = sink ^ pubkeys[15].xy[63];
+            }, 16);
+            run("ec_" + name + "_tweak_add", [&]() {
+                if (backend->pubkeyTweakAdd(pubkey, key32.data())) sink = sink ^ pubkey.xy[63];
+            });
+        }
+        // Generic OpenSSL scalar multiplication, for reference
+        EC_GROUP* group = EC_GROUP_new_by_curve_name(NID_secp256k1);
+        BN_CTX* bnCtx = BN_CTX_new();
+        BIGNUM* scalar = BN_bin2bn(key32.data(), 32, nullptr);
+        EC_POINT* point = EC_POINT_new(group);
+        run("openssl_ec_point_mul_generator", [&]() {
+            if (EC_POINT_mul(group, point, scalar, nullptr, nullptr, bnCtx)) sink = sink ^ 1;
+        });
+        EC_POINT_free(point);
+        BN_clear_free(scalar);
+        BN_CTX_free(bnCtx);
+        EC_GROUP_free(group);
+
+        // End to end, seed already derived
+        for (const auto& entry : WalletGenerator::networks) {
+            const std::string& network = entry.first;
+            run("generate_wallet_" + network, [&]() { consume(generator.generateWallet(seed, network).address); });
+        }
+
+        // Text encoding of derived keys: one wallet at a time against the
+        // column form the bulk pipeline uses, both keeping all 16 wallets
+        std::vector<std::string> ethereumPaths;
+        for (uint32_t i = 0; i < 16; i++) ethereumPaths.push_back(WalletGenerator::indexedPath("ethereum", i));
+        const std::vector<WalletGenerator::KeyPair> keyPairs = generator.deriveKeyPairs(seed, "ethereum", ethereumPaths);
+        run("encode_wallet_ethereum_x16_per_wallet", [&]() {
+            std::vector<WalletGenerator::WalletInfo> wallets;
+            wallets.reserve(keyPairs.size());
+            for (const WalletGenerator::KeyPair& keys : keyPairs) wallets.push_back(generator.encodeWallet(keys));
+            consume(wallets[15].publicKey);
+        }, 16);
+        run("encode_wallets_ethereum_x16_per_wallet", [&]() {
+            consume(generator.encodeWallets(keyPairs)[15].publicKey);
+        }, 16);
+
+        // End to end from the phrase, as one CLI invocation does it
+        run("mnemonic_to_bitcoin_wallet", [&]() {
+            consume(generator.generateWallet(generator.mnemonicToSeed(mnemonic), "bitcoin").address);
+        });
+        // End to end from --seed-hex (no KDF) and --entropy-hex input
+        run("seed_hex_to_bitcoin_wallet", [&]() {
+            consume(generator.generateWallet(WalletGenerator::seedFromHex(seedHex), "bitcoin").address);
+        });
+        run("entropy_hex_to_bitcoin_wallet", [&]() {
+            const std::string phrase = WalletGenerator::mnemonicFromEntropyHex("00000000000000000000000000000000");
+            consume(generator.generateWallet(generator.mnemonicToSeed(phrase), "bitcoin").address);
+        });
+
+        // Output sinks into /dev/null, per KiB: plaintext against
+        // --encrypt-key's sealed frames (one and four sealing threads)
+        const std::string block(64 * 1024, 'x');
+        std::ofstream devNull("/dev/null", std::ios::binary);
+        run("output_plain_per_KiB", [&]() { devNull.write(block.data(), block.size()); }, 64);
+        const SecureBytes outputKey(32, 0x42);
+        for (unsigned int threads : {1u, 4u}) {
+            EncryptedOutput sink(devNull.rdbuf(), outputKey, threads);
+            std::ostream sealed(&sink);
+            run("output_encrypted_" + std::to_string(threads) + "t_per_KiB", [&]() {
+                sealed.write(block.data(), block.size());
+            }, 64);
+            sink.close();
+        }
+
+        return results;
+    }
+
+private:
+    BenchmarkOptions options;
+    WalletGenerator generator;
+    std::vector<BenchmarkResult> results;
+
+    using Clock = std::chrono::steady_clock;
+
+    static double elapsedNs(Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    // opsPerCall: operations one call of fn performs (for per-op times)
+    void run(const std::string& name, const std::function<void()>& fn, uint64_t opsPerCall = 1) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+
+        // Warm up caches, lazily created contexts and CPU frequency
+        Clock::time_point warmupStart = Clock::now();
+        uint64_t warmupCalls = 0;
+        while (warmupCalls < 3 || elapsedNs(warmupStart) < 50e6) {
+            fn();
+            warmupCalls++;
+        }
+
+        // Calls per sample so a sample is long enough for the clock
+        double perCallNs = elapsedNs(warmupStart) / warmupCalls;
+        uint64_t callsPerSample = std::max<uint64_t>(1, static_cast<uint64_t>(options.minSampleMs * 1e6 / perCallNs));
+
+        std::vector<double> samples;
+        samples.reserve(options.samples);
+        for (size_t s = 0; s < options.samples; s++) {
+            Clock::time_point start = Clock::now();
+            for (uint64_t i = 0; i < callsPerSample; i++) fn();
+            samples.push_back(elapsedNs(start) / (callsPerSample * opsPerCall));
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double q1 = percentile(samples, 0.25);
+        double q3 = percentile(samples, 0.75);
+        double lowFence = q1 - 1.5 * (q3 - q1);
+        double highFence = q3 + 1.5 * (q3 - q1);
+        std::vector<double> kept;
+        for (double v : samples) {
+            if (v >= lowFence && v <= highFence) kept.push_back(v);
+        }
+
+        BenchmarkResult result;
+        result.name = name;
+        result.opsPerSample = callsPerSample * opsPerCall;
+        result.samples = kept.size();
+        result.outliers = samples.size() - kept.size();
+        result.minNs = kept.front();
+        result.medianNs = percentile(kept, 0.5);
+        result.p99Ns = percentile(kept, 0.99);
+        double sum = 0;
+        for (double v : kept) sum += v;
+        result.meanNs = sum / kept.size();
+        results.push_back(result);
+
+        std::cout << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << result.medianNs << std::setw(14) << result.p99Ns
+                  << std::setw(14) << result.meanNs << std::setw(6) << result.outliers << std::endl;
+    }
+};
+
+static std::string toJson(const std::vector<BenchmarkResult>& results) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "{\n  \"schema\": 1,\n  \"unit\": \"ns/op\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"median_ns\": " << r.medianNs
+            << ", \"p99_ns\": " << r.p99Ns << ", \"mean_ns\": " << r.meanNs
+            << ", \"min_ns\": " << r.minNs << ", \"samples\": " << r.samples
+            << ", \"outliers\": " << r.outliers << ", \"ops_per_sample\": " << r.opsPerSample << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+// Reads name -> median_ns from a file written by toJson
+static std::map<std::string, double> loadBaseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot open baseline: " + path);
+
+    std::map<std::string, double> medians;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t median = line.find("\"median_ns\": ");
+        if (name == std::string::npos || median == std::string::npos) continue;
+        name += 9;
+        std::string key = line.substr(name, line.find('"', name) - name);
+        medians[key] = std::stod(line.substr(median + 13));
+    }
+    return medians;
+}
+
+static int compareWithBaseline(const std::vector<BenchmarkResult>& results, const std::string& path, double tolerancePct) {
+    std::map<std::string, double> baseline = loadBaseline(path);
+    int regressions = 0;
+
+    std::cout << "\nComparison with " << path << " (tolerance " << tolerancePct << "%)\n";
+    for (const BenchmarkResult& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end()) {
+            std::cout << "  NEW        " << r.name << std::endl;
+            continue;
+        }
+        double changePct = (r.medianNs / it->second - 1.0) * 100.0;
+        const char* verdict = "ok        ";
+        if (changePct > tolerancePct) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (changePct < -tolerancePct) {
+            verdict = "improved  ";
+        }
+        std::cout << "  " << verdict << " " << std::left << std::setw(34) << r.name << std::right
+                  << std::setprecision(1) << std::showpos << std::setw(8) << changePct << "%" << std::noshowpos
+                  << "  (" << it->second << " -> " << r.medianNs << " ns)" << std::endl;
+    }
+
+    std::cout << (regressions ? "\n" + std::to_string(regressions) + " regression(s) beyond tolerance\n"
+                              : "\nNo regressions beyond tolerance\n");
+    return regressions;
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value" << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--filter") {
+            options.filter = next();
+        } else if (arg == "--samples") {
+            options.samples = std::max<size_t>(5, std::stoul(next()));
+        } else if (arg == "--min-sample-ms") {
+            options.minSampleMs = std::stod(next());
+        } else if (arg == "--json") {
+            options.jsonPath = next();
+        } else if (arg == "--baseline") {
+            options.baselinePath = next();
+        } else if (arg == "--tolerance") {
+            options.tolerancePct = std::stod(next());
+        } else if (arg == "--cpu-features") {
+            std::string list = next();
+            try {
+                selectKernels(parseCpuFeatures(list));
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 2;
+            }
+        } else if (arg == "--ec-backend") {
+            std::string name = next();
+            try {
+                selectEcBackend(name);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 2;
+            }
+        } else if (arg == "--ec-table") {
+            std::string path = next();
+            try {
+                useEcTable(path);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 2;
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter TEXT] [--samples N] [--min-sample-ms N]"
+                      << " [--json FILE] [--baseline FILE] [--tolerance PCT] [--cpu-features LIST]"
+                      << " [--ec-backend NAME] [--ec-table FILE]" << std::endl;
+            return arg == "-h" || arg == "--help" ? 0 : 2;
+        }
+    }
+
+    std::cout << std::left << std::setw(34) << "benchmark (ns/op)" << std::right << std::setw(14) << "median"
+              << std::setw(14) << "p99" << std::setw(14) << "mean" << std::setw(6) << "out" << std::endl;
+
+    try {
+        WalletGeneratorBenchmark benchmark(options);
+        std::vector<BenchmarkResult> results = benchmark.runAll();
+
+        if (!options.jsonPath.empty()) {
+            std::ofstream json(options.jsonPath);
+            json << toJson(results);
+            if (!json) throw std::runtime_error("Cannot write " + options.jsonPath);
+        }
+        if (!options.baselinePath.empty()) {
+            return compareWithBaseline(results, options.baselinePath, options.tolerancePct) ? 1 : 0;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -1,10 +1,20 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <cstdlib>
 #include <sstream>
 #include <fstream>
+#include <chrono>
+#include <thread>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "test_framework.h"
+#include "../shm_ring.h"
 
 class IntegrationTest {
 public:
@@ -18,6 +28,21 @@ public:
         testBatchGeneration();
         testVerboseOutput();
         testAllNetworksFlag();
+        testServeMode();
+        testRingTransport();
+        testBulkInput();
+        testDirectInput();
+        testGenerate();
+        testBip85();
+        testPackedInput();
+        testStatsReport();
+        testCpuFeatures();
+        testEcBackends();
+        testShardedSweep();
+        testSweepResume();
+        testAddressIndex();
+        testSeedCache();
+        testEncryptedOutput();
         
         std::cout << "\n" << TestFramework::getSummary() << std::endl;
     }
@@ -36,6 +61,42 @@ private:
         return result;
     }
 
+    double elapsedMs(std::chrono::steady_clock::time_point start) {
+        auto duration = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / 1000.0;
+    }
+
+    // Sends one NDJSON request (if any) over a connected socket and reads one response line
+    std::string socketRequest(int fd, const std::string& request) {
+        if (!request.empty()) {
+            std::string line = request + "\n";
+            if (write(fd, line.data(), line.size()) != static_cast<ssize_t>(line.size())) return "ERROR";
+        }
+
+        std::string response;
+        char c;
+        while (read(fd, &c, 1) == 1) {
+            if (c == '\n') return response;
+            response += c;
+        }
+        return "ERROR";
+    }
+
+    int connectSocket(const std::string& path) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+
+        // The daemon needs a moment to bind; retry for up to 5 seconds
+        for (int attempt = 0; attempt < 500; attempt++) {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+            close(fd);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return -1;
+    }
+
     void testCommandLineBasic() {
         TEST_GROUP("Command Line Basic Functionality");
         
@@ -105,6 +166,15 @@ private:
         TEST_ASSERT(invalidOptionOutput.find("Usage:") != std::string::npos || 
                    invalidOptionOutput.find("Error") != std::string::npos,
                    "Should show usage or error for invalid option");
+
+        // Malformed numeric values: an error and exit status 1, not an uncaught exception
+        bool numbersChecked = true;
+        for (const char* args : {"--threads abc", "--start x", "--checkpoint-interval z", "--words -1", "-c 1x"}) {
+            std::string out = runCommand(std::string("../wallet_generator ") + args + " \"abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about\" 2>&1; echo \"exit=$?\"");
+            numbersChecked = numbersChecked && out.find("Error: invalid value for --") != std::string::npos &&
+                             out.find("exit=1") != std::string::npos;
+        }
+        TEST_ASSERT(numbersChecked, "Malformed numeric option values should be rejected");
     }
 
     void testBatchGeneration() {
@@ -154,6 +224,838 @@ private:
                        "Should generate wallet for " + network);
         }
     }
+
+    void testServeMode() {
+        TEST_GROUP("Serve Mode");
+
+        const std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        const std::string socketPath = "/tmp/wallet_generator_test_" + std::to_string(getpid()) + ".sock";
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            execl("../wallet_generator", "wallet_generator", "--serve", socketPath.c_str(), "--threads", "2", (char*)nullptr);
+            _exit(127);
+        }
+        TEST_ASSERT(pid > 0, "Should start daemon process");
+
+        int fd = connectSocket(socketPath);
+        TEST_ASSERT(fd >= 0, "Should connect to daemon socket");
+        if (fd < 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+            return;
+        }
+
+        std::string pong = socketRequest(fd, "{\"op\":\"ping\",\"id\":7}");
+        TEST_ASSERT(pong.find("\"id\":7") != std::string::npos, "Ping response should echo id");
+        TEST_ASSERT(pong.find("\"latency_us\":") != std::string::npos, "Response should report latency");
+
+        // Daemon and CLI must agree on the derived address
+        std::string request = "{\"op\":\"generate\",\"mnemonic\":\"" + mnemonic + "\",\"network\":\"ethereum\"}";
+        std::string response = socketRequest(fd, request);
+        std::string cliOutput = runCommand("../wallet_generator -n ethereum \"" + mnemonic + "\"");
+        size_t addressPos = cliOutput.find("Address: ");
+        std::string cliAddress = addressPos == std::string::npos ? "" : cliOutput.substr(addressPos + 9, 42);
+        TEST_ASSERT(!cliAddress.empty() && response.find(cliAddress) != std::string::npos,
+                   "Daemon should derive the same address as the CLI");
+
+        std::string error = socketRequest(fd, "{\"op\":\"generate\",\"mnemonic\":\"" + mnemonic + "\",\"network\":\"invalid\"}");
+        TEST_ASSERT(error.find("\"ok\":false") != std::string::npos, "Invalid network should return an error response");
+
+        std::string wrapped = socketRequest(fd, "{\"mnemonic\":\"" + mnemonic + "\",\"start\":18446744073709551615,\"count\":2}");
+        TEST_ASSERT(wrapped.find("\"ok\":false") != std::string::npos, "Indices past 2^32 should be rejected, not wrapped");
+        std::string badId = socketRequest(fd, "{\"op\":\"ping\",\"id\":1\"x}");
+        TEST_ASSERT(badId.find("\"ok\":false") != std::string::npos && badId.find("1\"x") == std::string::npos,
+                   "Bare literals other than numbers, booleans and null should be rejected");
+
+        // A client that half-closes after its request still gets the reply
+        int halfFd = connectSocket(socketPath);
+        const std::string halfRequest = "{\"op\":\"ping\",\"id\":9}\n";
+        std::string halfReply;
+        if (halfFd >= 0 && write(halfFd, halfRequest.data(), halfRequest.size()) == static_cast<ssize_t>(halfRequest.size()) &&
+            shutdown(halfFd, SHUT_WR) == 0) {
+            halfReply = socketRequest(halfFd, "");
+        }
+        if (halfFd >= 0) close(halfFd);
+        TEST_ASSERT(halfReply.find("\"id\":9") != std::string::npos, "Half-closed connections should be answered");
+
+        // A scrape line after requests is an error, not a takeover of the connection
+        std::string lateGet = socketRequest(fd, "GET /metrics HTTP/1.1");
+        TEST_ASSERT(lateGet.find("\"ok\":false") != std::string::npos, "A late GET should get an error response");
+        std::string lateRing = socketRequest(fd, "{\"op\":\"ring\"}");
+        TEST_ASSERT(lateRing.find("\"ok\":false") != std::string::npos, "A late ring request should get an error response");
+        TEST_ASSERT(socketRequest(fd, "{\"op\":\"ping\",\"id\":10}").find("\"id\":10") != std::string::npos,
+                   "The connection should stay open after a rejected line");
+
+        // More pipelined requests than the per-connection backlog: reading pauses, nothing is lost
+        const int backlog = 3000;
+        std::string flood;
+        for (int i = 0; i < backlog; i++) flood += "{\"op\":\"ping\"}\n";
+        std::thread writer([&] {
+            size_t sent = 0;
+            while (sent < flood.size()) {
+                ssize_t n = write(fd, flood.data() + sent, flood.size() - sent);
+                if (n <= 0) break;
+                sent += static_cast<size_t>(n);
+            }
+        });
+        int answered = 0;
+        for (int i = 0; i < backlog; i++) {
+            if (socketRequest(fd, "").find("\"ok\":true") != std::string::npos) answered++;
+        }
+        writer.join();
+        TEST_ASSERT(answered == backlog, "Every request beyond the backlog limit should still be answered");
+
+        // Pipelined requests arriving together should be coalesced into one lane group
+        std::string pipelined;
+        for (int i = 0; i < 4; i++) {
+            pipelined += "{\"op\":\"seed\",\"id\":" + std::to_string(i) + ",\"mnemonic\":\"" + mnemonic + "\"}\n";
+        }
+        TEST_ASSERT(write(fd, pipelined.data(), pipelined.size()) == static_cast<ssize_t>(pipelined.size()),
+                   "Should send pipelined requests");
+        int coalesced = 0;
+        for (int i = 0; i < 4; i++) {
+            std::string seedResponse = socketRequest(fd, "");
+            if (seedResponse.find("\"batch\":4") != std::string::npos) coalesced++;
+        }
+        TEST_ASSERT(coalesced == 4, "Concurrent requests should share one batch");
+
+        // An HTTP GET on a fresh connection is a Prometheus scrape
+        int scrapeFd = connectSocket(socketPath);
+        std::string scrape;
+        const std::string get = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        if (scrapeFd >= 0 && write(scrapeFd, get.data(), get.size()) == static_cast<ssize_t>(get.size())) {
+            char buffer[4096];
+            ssize_t n;
+            while ((n = read(scrapeFd, buffer, sizeof(buffer))) > 0) {
+                scrape.append(buffer, static_cast<size_t>(n));
+            }
+        }
+        if (scrapeFd >= 0) close(scrapeFd);
+        TEST_ASSERT(scrape.compare(0, 15, "HTTP/1.0 200 OK") == 0, "Metrics scrape should get an HTTP 200 reply");
+        TEST_ASSERT(scrape.find("walletgen_stage_calls_total{stage=\"kdf\"} 5\n") != std::string::npos,
+                   "Metrics should count every KDF call so far");
+        TEST_ASSERT(scrape.find("walletgen_stage_seconds_total{stage=\"public_key\"}") != std::string::npos,
+                   "Metrics should report per-stage time");
+        TEST_ASSERT(scrape.find("walletgen_daemon_queue_depth{class=\"bulk\"} 0\n") != std::string::npos,
+                   "Metrics should report the depth of each priority queue");
+        TEST_ASSERT(scrape.find("walletgen_daemon_request_seconds{class=\"interactive\",quantile=\"0.99\"}") != std::string::npos,
+                   "Metrics should report latency quantiles per priority class");
+
+        // A large request is bulk and yields to an interactive one sent after it
+        std::string mixed = "{\"id\":\"bulk\",\"mnemonic\":\"" + mnemonic + "\",\"count\":3000}\n"
+                            "{\"id\":\"interactive\",\"mnemonic\":\"" + mnemonic + "\",\"start\":2999}\n";
+        TEST_ASSERT(write(fd, mixed.data(), mixed.size()) == static_cast<ssize_t>(mixed.size()),
+                   "Should send bulk and interactive requests");
+        std::string first = socketRequest(fd, "");
+        std::string second = socketRequest(fd, "");
+        TEST_ASSERT(first.find("\"id\":\"interactive\"") != std::string::npos &&
+                   first.find("\"priority\":\"interactive\"") != std::string::npos,
+                   "Interactive request should be answered before the bulk one");
+        size_t lastWallet = second.rfind("\"address\":\"");
+        TEST_ASSERT(second.find("\"priority\":\"bulk\"") != std::string::npos && lastWallet != std::string::npos &&
+                   first.find(second.substr(lastWallet, 40)) != std::string::npos,
+                   "Bulk request should complete across chunks");
+
+        // Latency comparison: warm daemon round trips vs. one process spawn per wallet
+        const int iterations = 10;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            socketRequest(fd, request);
+        }
+        double daemonMs = elapsedMs(start) / iterations;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            runCommand("../wallet_generator -n ethereum \"" + mnemonic + "\"");
+        }
+        double spawnMs = elapsedMs(start) / iterations;
+
+        std::cout << "Per-request latency: daemon " << daemonMs << "ms, spawn " << spawnMs << "ms" << std::endl;
+        TEST_ASSERT(daemonMs < spawnMs, "Daemon requests should be faster than spawning a process");
+
+        close(fd);
+        kill(pid, SIGTERM);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Daemon should exit cleanly on SIGTERM");
+        TEST_ASSERT(access(socketPath.c_str(), F_OK) != 0, "Daemon should remove its socket on exit");
+    }
+    void testRingTransport() {
+        TEST_GROUP("Shared-Memory Ring");
+
+        const std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        const std::string socketPath = "/tmp/wallet_generator_ring_" + std::to_string(getpid()) + ".sock";
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            execl("../wallet_generator", "wallet_generator", "--serve", socketPath.c_str(), "--threads", "2", (char*)nullptr);
+            _exit(127);
+        }
+        int fd = connectSocket(socketPath);
+        TEST_ASSERT(fd >= 0, "Should connect to daemon socket");
+        if (fd < 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+            return;
+        }
+
+        auto hex = [](const uint8_t* data, size_t len) {
+            std::string out;
+            for (size_t i = 0; i < len; i++) out += std::string(1, "0123456789abcdef"[data[i] >> 4]) + "0123456789abcdef"[data[i] & 0x0f];
+            return out;
+        };
+        auto fill = [&](RingRequest* request, uint64_t id, RingOp op, const std::string& network, uint32_t start, uint32_t count) {
+            request->id = id;
+            request->op = op;
+            request->start = start;
+            request->count = count;
+            network.copy(request->network, sizeof(request->network) - 1);
+            mnemonic.copy(request->mnemonic, sizeof(request->mnemonic) - 1);
+        };
+
+        try {
+            RingClient client(socketPath, 64);
+            TEST_ASSERT(client.slots() == 64, "Ring should have the requested slots");
+
+            fill(client.nextRequest(), 1, RingOp::Ping, "", 0, 0);
+            fill(client.nextRequest(), 2, RingOp::Seed, "", 0, 0);
+            fill(client.nextRequest(), 3, RingOp::Generate, "nocoin", 0, 1);
+            // More wallets than slots: the daemon waits for released responses
+            fill(client.nextRequest(), 4, RingOp::Generate, "ethereum", 0, 300);
+            client.publish();
+
+            std::vector<std::string> addresses;
+            std::string seedHex, firstPrivateKey, error;
+            bool pingOk = false, ordered = true;
+            size_t finished = 0;
+            while (finished < 4) {
+                const RingResponse* response = client.nextResponse(10000);
+                if (!response) break;
+                if (response->id == 1) pingOk = response->ok;
+                if (response->id == 2 && response->ok) seedHex = hex(response->seed, sizeof(response->seed));
+                if (response->id == 3 && !response->ok) error = response->error;
+                if (response->id == 4) {
+                    ordered = ordered && response->index == addresses.size();
+                    if (response->index == 0) firstPrivateKey = hex(response->privateKey, sizeof(response->privateKey));
+                    addresses.push_back(response->address);
+                }
+                if (response->last) finished++;
+                if (addresses.size() % 16 == 0) client.release();
+            }
+            client.release();
+            TEST_ASSERT(pingOk, "Ring ping should succeed");
+            TEST_ASSERT(error.find("Unsupported network") != std::string::npos, "Ring errors should be reported per request");
+            TEST_ASSERT(addresses.size() == 300 && ordered, "Every wallet should arrive, in order, through a smaller ring");
+
+            // The same wallets and seed as the JSON protocol
+            std::string json = socketRequest(fd, "{\"op\":\"generate\",\"mnemonic\":\"" + mnemonic +
+                                                 "\",\"network\":\"ethereum\",\"count\":300}");
+            bool same = addresses.size() == 300 && json.find("\"private_key\":\"" + firstPrivateKey + "\"") != std::string::npos;
+            for (size_t i = 0; same && i < addresses.size(); i += 37) {
+                same = json.find("\"address\":\"" + addresses[i] + "\"") != std::string::npos;
+            }
+            TEST_ASSERT(same, "Ring wallets should match the JSON protocol");
+            std::string seed = socketRequest(fd, "{\"op\":\"seed\",\"mnemonic\":\"" + mnemonic + "\"}");
+            TEST_ASSERT(!seedHex.empty() && seed.find(seedHex) != std::string::npos, "Ring seed should match the JSON protocol");
+
+            // Throughput: 2000 bitcoin wallets in 8 requests, ring against JSON
+            const int requests = 8;
+            const uint32_t perRequest = 250;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < requests; i++) fill(client.nextRequest(), 100 + i, RingOp::Generate, "bitcoin", i * perRequest, perRequest);
+            client.publish();
+            size_t received = 0;
+            for (int done = 0; done < requests;) {
+                const RingResponse* response = client.nextResponse(10000);
+                if (!response) break;
+                received++;
+                if (response->last) done++;
+                if (received % 32 == 0) client.release();
+            }
+            client.release();
+            double ringMs = elapsedMs(start);
+
+            std::string pipelined;
+            for (int i = 0; i < requests; i++) {
+                pipelined += "{\"mnemonic\":\"" + mnemonic + "\",\"start\":" + std::to_string(i * perRequest) +
+                             ",\"count\":" + std::to_string(perRequest) + "}\n";
+            }
+            start = std::chrono::steady_clock::now();
+            bool sent = write(fd, pipelined.data(), pipelined.size()) == static_cast<ssize_t>(pipelined.size());
+            size_t jsonWallets = 0;
+            for (int i = 0; sent && i < requests; i++) {
+                std::string response = socketRequest(fd, "");
+                for (size_t pos = 0; (pos = response.find("\"wif\":", pos)) != std::string::npos; pos++) jsonWallets++;
+            }
+            double jsonMs = elapsedMs(start);
+
+            std::cout << "2000 wallets: ring " << ringMs << "ms, JSON socket " << jsonMs << "ms" << std::endl;
+            TEST_ASSERT(received == requests * perRequest && jsonWallets == received, "Both transports should deliver every wallet");
+        } catch (const std::exception& e) {
+            TEST_ASSERT(false, std::string("Ring client failed: ") + e.what());
+        }
+
+        bool refused = false;
+        try {
+            RingClient odd(socketPath, 100);
+        } catch (const std::runtime_error& e) {
+            refused = std::string(e.what()).find("power of two") != std::string::npos;
+        }
+        TEST_ASSERT(refused, "A slot count that is not a power of two should be refused");
+
+        close(fd);
+        kill(pid, SIGTERM);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Daemon should exit cleanly after serving rings");
+    }
+
+    void testBulkInput() {
+        TEST_GROUP("Bulk Input");
+
+        const std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        const std::string inputPath = "/tmp/wallet_generator_bulk_" + std::to_string(getpid()) + ".txt";
+
+        // Distinct passphrases make every record distinct, so order is checkable
+        {
+            std::ofstream input(inputPath);
+            input << "# comment lines and blank lines are skipped\n\n";
+            for (int i = 0; i < 12; i++) {
+                input << mnemonic << "\tpass" << i << "\n";
+            }
+            input << "not a mnemonic\n";
+            input << mnemonic << "\t\tm/44'/0'/0'/0/5\n";
+        }
+
+        std::string text = runCommand("../wallet_generator --input " + inputPath + " -c 2 2>/dev/null");
+        std::string single = runCommand("../wallet_generator -c 2 -P pass0 \"" + mnemonic + "\"");
+        size_t first = text.find("RECORD: line 3\n");
+        size_t second = text.find("\nRECORD: line 4\n");
+        TEST_ASSERT(first != std::string::npos && second != std::string::npos, "Text output should label records by line");
+        if (first != std::string::npos && second != std::string::npos) {
+            size_t body = first + std::string("RECORD: line 3\n").size();
+            TEST_ASSERT(text.substr(body, second - body) == single, "Record output should match a single-mnemonic run");
+        }
+
+        std::string ordered = runCommand("../wallet_generator --input " + inputPath +
+                                         " --format tsv --stage-threads kdf=4,derive=2,encode=3 2>/dev/null");
+        std::string serial = runCommand("../wallet_generator --input - --format tsv --stage-threads kdf=1,derive=1,encode=1 < " +
+                                        inputPath + " 2>/dev/null");
+        TEST_ASSERT(!ordered.empty() && ordered == serial, "Output should be in input order regardless of thread counts");
+
+        std::istringstream rows(ordered);
+        std::string row;
+        int rowCount = 0;
+        std::string lastRow;
+        while (std::getline(rows, row)) {
+            rowCount++;
+            lastRow = row;
+        }
+        TEST_ASSERT(rowCount == 13, "TSV should have one row per valid record");
+        TEST_ASSERT(lastRow.find("\tm/44'/0'/0'/0/5\t") != std::string::npos, "Per-line path should be used");
+
+        std::string errors = runCommand("../wallet_generator --input " + inputPath + " --format tsv 2>&1 >/dev/null");
+        TEST_ASSERT(errors.find("Error: line 15") != std::string::npos, "Invalid lines should be reported with their line number");
+        TEST_ASSERT(errors.find("13 wallets, 1 failed") != std::string::npos, "Summary should count wallets and failures");
+
+        int status = system(("../wallet_generator --input " + inputPath + " -o /dev/null 2>/dev/null").c_str());
+        TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 1, "Invalid lines should give a nonzero exit status");
+
+        unlink(inputPath.c_str());
+    }
+
+    void testDirectInput() {
+        TEST_GROUP("Seed and Entropy Input");
+
+        const std::string mnemonic = "legal winner thank year wave sausage worth useful legal winner thank yellow";
+        const std::string entropy = "7f7f7f7f7f7f7f7f7f7f7f7f7f7f7f7f";
+        // BIP39 reference seed of the phrase with passphrase "TREZOR"
+        const std::string seed = "2e8905819b8723fe2c1d161860e5ee1830318dbf49a83bd451cfb8440c28bd6f"
+                                 "a457fe1296106559a3c80937a1c1069be3a3a5bd381ee6260e8d9739fce1f607";
+        const std::string inputPath = "/tmp/wallet_generator_direct_" + std::to_string(getpid()) + ".txt";
+
+        std::string fromMnemonic = runCommand("../wallet_generator -n dogecoin -c 3 -P TREZOR \"" + mnemonic + "\"");
+        TEST_ASSERT(runCommand("../wallet_generator -n dogecoin -c 3 --seed-hex " + seed) == fromMnemonic,
+                   "--seed-hex should give the wallets of the phrase the seed came from");
+        TEST_ASSERT(runCommand("../wallet_generator -n dogecoin -c 3 -P TREZOR --entropy-hex " + entropy) == fromMnemonic,
+                   "--entropy-hex should give the wallets of its mnemonic");
+        std::string sweep = runCommand("../wallet_generator -n dogecoin --start 0 --end 3 --seed-hex " + seed + " 2>/dev/null");
+        TEST_ASSERT(sweep == runCommand("../wallet_generator -n dogecoin --start 0 --end 3 -P TREZOR \"" + mnemonic + "\" 2>/dev/null"),
+                   "Sweeps should accept a seed");
+
+        const std::string tsv = "-n dogecoin --input " + inputPath + " --format tsv";
+        std::ofstream(inputPath) << mnemonic << "\tTREZOR\n" << mnemonic << "\tTREZOR\tm/44'/3'/0'/0/7\n";
+        std::string expected = runCommand("../wallet_generator " + tsv + " 2>/dev/null");
+        std::ofstream(inputPath) << seed << "\n" << seed << "\tm/44'/3'/0'/0/7\n" << seed.substr(2) << "\n";
+        std::string seeds = runCommand("../wallet_generator " + tsv + " --input-type seed 2>&1");
+        TEST_ASSERT(!expected.empty() && seeds.find(expected) == 0, "Seed lines should match their phrases");
+        TEST_ASSERT(seeds.find("Error: line 3: Seed must be 64 bytes") != std::string::npos, "Short seeds should be rejected");
+        std::ofstream(inputPath) << entropy << "\tTREZOR\n" << entropy << "\tTREZOR\tm/44'/3'/0'/0/7\n";
+        TEST_ASSERT(runCommand("../wallet_generator " + tsv + " --input-type entropy 2>/dev/null") == expected,
+                   "Entropy lines should match their phrases");
+
+        std::string passphrase = runCommand("../wallet_generator -P x --seed-hex " + seed + " 2>&1");
+        TEST_ASSERT(passphrase.find("--passphrase does not apply") != std::string::npos, "A passphrase with a seed should be rejected");
+        std::string badEntropy = runCommand("../wallet_generator --entropy-hex 7f7f7f 2>&1");
+        TEST_ASSERT(badEntropy.find("Entropy must be 16, 20, 24, 28 or 32 bytes") != std::string::npos, "Odd entropy sizes should be rejected");
+        std::string both = runCommand("../wallet_generator --seed-hex " + seed + " \"" + mnemonic + "\" 2>&1");
+        TEST_ASSERT(both.find("replace the mnemonic argument") != std::string::npos, "A seed and a mnemonic together should be rejected");
+
+        unlink(inputPath.c_str());
+    }
+
+    void testGenerate() {
+        TEST_GROUP("Mnemonic Generation");
+
+        const std::string inputPath = "/tmp/wallet_generator_generate_" + std::to_string(getpid()) + ".txt";
+        std::string generated = runCommand("../wallet_generator --generate 40 --words 24 -n litecoin --format tsv --threads 3 2>/dev/null");
+
+        // Every row ends with a fresh phrase; deriving from it again gives the same row
+        std::istringstream rows(generated);
+        std::string row;
+        std::vector<std::string> phrases;
+        std::string expected;
+        bool shapes = true;
+        while (std::getline(rows, row)) {
+            std::string phrase = row.substr(row.rfind('\t') + 1);
+            shapes = shapes && std::count(phrase.begin(), phrase.end(), ' ') == 23;
+            phrases.push_back(phrase);
+            expected += row.substr(0, row.rfind('\t')) + "\n";
+        }
+        TEST_ASSERT(phrases.size() == 40 && shapes, "Each generated record should carry a 24-word mnemonic");
+        std::sort(phrases.begin(), phrases.end());
+        TEST_ASSERT(std::unique(phrases.begin(), phrases.end()) == phrases.end(), "Generated mnemonics should be distinct");
+        {
+            std::ofstream input(inputPath);
+            std::istringstream again(generated);
+            while (std::getline(again, row)) input << row.substr(row.rfind('\t') + 1) << "\n";
+        }
+        TEST_ASSERT(runCommand("../wallet_generator --input " + inputPath + " -n litecoin --format tsv 2>/dev/null") == expected,
+                   "Generated mnemonics should be valid and derive the listed wallets");
+
+        std::string text = runCommand("../wallet_generator --generate 2 -n bitcoin 2>&1");
+        TEST_ASSERT(text.find("RECORD: line 2\nMNEMONIC: ") != std::string::npos &&
+                   text.find("Processed 2 records, 2 wallets, 0 failed") != std::string::npos,
+                   "Text output should show each mnemonic");
+
+        std::string words = runCommand("../wallet_generator --generate 2 --words 13 2>&1");
+        TEST_ASSERT(words.find("12, 15, 18, 21 or 24 words") != std::string::npos, "Unsupported word counts should be rejected");
+        std::string combined = runCommand("../wallet_generator --generate 2 --input " + inputPath + " 2>&1");
+        TEST_ASSERT(combined.find("cannot be combined") != std::string::npos, "--generate should not take other inputs");
+
+        unlink(inputPath.c_str());
+    }
+
+    void testBip85() {
+        TEST_GROUP("BIP85 Children");
+
+        const std::string master = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        const std::string inputPath = "/tmp/wallet_generator_bip85_" + std::to_string(getpid()) + ".txt";
+        std::string children = runCommand("../wallet_generator --bip85 5:9 -n tron -c 2 --format tsv \"" + master + "\" 2>/dev/null");
+
+        // Each child's wallets are those of its mnemonic, numbered by child index
+        std::istringstream rows(children);
+        std::string row;
+        std::string expected;
+        std::vector<std::string> phrases;
+        while (std::getline(rows, row)) {
+            std::string phrase = row.substr(row.rfind('\t') + 1);
+            if (phrases.empty() || phrases.back() != phrase) phrases.push_back(phrase);
+            expected += row.substr(0, row.rfind('\t')) + "\n";
+        }
+        TEST_ASSERT(phrases.size() == 4 && children.find("\n8\ttron\tm/44'/195'/0'/0/1\t") != std::string::npos,
+                   "Each child should have its wallets, numbered by child index");
+        {
+            std::ofstream input(inputPath);
+            for (const std::string& phrase : phrases) input << phrase << "\n";
+        }
+        std::string fromPhrases = runCommand("../wallet_generator --input " + inputPath + " -n tron -c 2 --format tsv 2>/dev/null");
+        std::string renumbered;
+        std::istringstream phraseRows(fromPhrases);
+        while (std::getline(phraseRows, row)) {
+            renumbered += std::to_string(std::stoul(row.substr(0, row.find('\t'))) + 4) + row.substr(row.find('\t')) + "\n";
+        }
+        TEST_ASSERT(!renumbered.empty() && renumbered == expected, "Child wallets should match a run over the child mnemonics");
+
+        std::string single = runCommand("../wallet_generator --bip85 7 -n tron -c 2 --format tsv \"" + master + "\" 2>/dev/null");
+        TEST_ASSERT(!single.empty() && children.find(single) != std::string::npos, "A single index should give that child");
+        std::string seedHex = "5eb00bbddcf069084889a8ab9155568165f5c453ccb85e70811aaed6f6da5fc1"
+                              "9a5ac40b389cd370d086206dec8aa6c43daea6690f20ad3d8d48b2d2ce9e38e4";
+        TEST_ASSERT(runCommand("../wallet_generator --bip85 5:9 -n tron -c 2 --format tsv --seed-hex " + seedHex + " 2>/dev/null") == children,
+                   "The master may be given as a seed");
+        std::string withPassphrase = runCommand("../wallet_generator --bip85 7 -P TREZOR -n tron -c 2 --format tsv \"" + master + "\" 2>/dev/null");
+        TEST_ASSERT(!withPassphrase.empty() && withPassphrase != single, "-P should apply to the master mnemonic");
+
+        std::string text = runCommand("../wallet_generator --bip85 3 --words 24 -n bitcoin \"" + master + "\" 2>&1");
+        size_t label = text.find("RECORD: child 3\nMNEMONIC: ");
+        size_t words = label + std::string("RECORD: child 3\nMNEMONIC: ").size();
+        TEST_ASSERT(label != std::string::npos &&
+                   std::count(text.begin() + words, text.begin() + text.find('\n', words), ' ') == 23,
+                   "Text output should label 24-word children by index");
+        std::string badRange = runCommand("../wallet_generator --bip85 9:5 \"" + master + "\" 2>&1");
+        TEST_ASSERT(badRange.find("Invalid --bip85 range: 9:5") != std::string::npos, "Empty ranges should be rejected");
+        std::string noMaster = runCommand("../wallet_generator --bip85 0:2 2>&1");
+        TEST_ASSERT(noMaster.find("--bip85 needs the master mnemonic") != std::string::npos, "A master should be required");
+
+        unlink(inputPath.c_str());
+    }
+
+    void testPackedInput() {
+        TEST_GROUP("Packed Mnemonic Files");
+
+        const std::string base = "/tmp/wallet_generator_packed_" + std::to_string(getpid());
+        const std::string textPath = base + ".txt";
+        const std::string text =
+            "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about\n"
+            "legal winner thank year wave sausage worth useful legal winner thank yellow\n"
+            "zoo zoo zoo zoo zoo zoo zoo zoo zoo zoo zoo wrong\n";
+        {
+            std::ofstream input(textPath);
+            input << text;
+        }
+
+        for (const std::string encoding : {"indices", "entropy"}) {
+            const std::string packedPath = base + "." + encoding;
+            int status = system(("../wallet_generator --input " + textPath + " --pack " + packedPath +
+                                 " --pack-encoding " + encoding + " 2>/dev/null").c_str());
+            TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Packing with " + encoding + " encoding should succeed");
+
+            std::ifstream packed(packedPath, std::ios::binary | std::ios::ate);
+            size_t recordSize = encoding == "indices" ? 17 : 16;
+            TEST_ASSERT(static_cast<size_t>(packed.tellg()) == 16 + 3 * recordSize,
+                       "Packed " + encoding + " file should hold a header and fixed-size records");
+
+            TEST_ASSERT(runCommand("../wallet_generator --unpack " + packedPath) == text,
+                       "Unpacking " + encoding + " records should restore the text");
+            TEST_ASSERT(runCommand("../wallet_generator --input " + packedPath + " --format tsv 2>/dev/null") ==
+                        runCommand("../wallet_generator --input " + textPath + " --format tsv 2>/dev/null"),
+                       "Packed " + encoding + " input should give the same wallets as text input");
+            unlink(packedPath.c_str());
+        }
+
+        {
+            std::ofstream input(textPath);
+            input << "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon\n";
+        }
+        std::string badChecksum = runCommand("../wallet_generator --input " + textPath + " --pack " + base + ".bad 2>&1");
+        TEST_ASSERT(badChecksum.find("Error: line 1") != std::string::npos, "Packing should reject mnemonics with a bad checksum");
+
+        unlink(textPath.c_str());
+        unlink((base + ".bad").c_str());
+    }
+
+    void testStatsReport() {
+        TEST_GROUP("Stage Statistics Report");
+
+        const std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        std::string plain = runCommand("../wallet_generator -c 2 \"" + mnemonic + "\" 2>/dev/null");
+        std::string withStats = runCommand("../wallet_generator -c 2 --stats \"" + mnemonic + "\" 2>/dev/null");
+        TEST_ASSERT(plain == withStats, "--stats should not change the wallet output");
+
+        std::string report = runCommand("../wallet_generator -c 2 --stats \"" + mnemonic + "\" 2>&1 >/dev/null");
+        TEST_ASSERT(report.find("% wall") != std::string::npos, "--stats should print the breakdown table on stderr");
+        TEST_ASSERT(report.find("\nwallet ") != std::string::npos && report.find("\npublic_key ") != std::string::npos,
+                   "Breakdown should list the wallet and public key stages");
+
+        std::string bulkReport = runCommand("echo \"" + mnemonic + "\" | ../wallet_generator --input - --stats 2>&1 >/dev/null");
+        TEST_ASSERT(bulkReport.find("\noutput ") != std::string::npos, "Bulk mode should report the output stage");
+        TEST_ASSERT(runCommand("../wallet_generator \"" + mnemonic + "\" 2>&1").find("% wall") == std::string::npos,
+                   "No report should be printed without --stats");
+    }
+
+    void testCpuFeatures() {
+        TEST_GROUP("CPU Feature Dispatch");
+
+        std::string version = runCommand("../wallet_generator --version");
+        TEST_ASSERT(version.find("wallet_generator ") == 0, "--version should print the program version");
+        TEST_ASSERT(version.find("Kernels: sha256=") != std::string::npos, "--version should list the selected kernels");
+
+        std::string baseline = runCommand("../wallet_generator --cpu-features none --version");
+        TEST_ASSERT(baseline.find("(enabled: none)") != std::string::npos &&
+                   baseline.find("sha256=generic sha512=generic") != std::string::npos,
+                   "--cpu-features none should bind the baseline kernels");
+
+        const std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        std::string best = runCommand("../wallet_generator -a -c 3 -v \"" + mnemonic + "\"");
+        std::string generic = runCommand("../wallet_generator --cpu-features none -a -c 3 -v \"" + mnemonic + "\"");
+        TEST_ASSERT(!best.empty() && best == generic, "Baseline kernels should produce identical wallets");
+
+        std::string bad = runCommand("../wallet_generator --cpu-features avx3 --version 2>&1; echo \"exit=$?\"");
+        TEST_ASSERT(bad.find("Error: Unknown CPU feature") != std::string::npos && bad.find("exit=1") != std::string::npos,
+                   "Unknown CPU features should be rejected");
+    }
+
+    void testEcBackends() {
+        TEST_GROUP("EC Backend Selection");
+
+        std::string version = runCommand("../wallet_generator --version");
+        TEST_ASSERT(version.find("EC backend: ") != std::string::npos, "--version should name the EC backend");
+
+        const std::string mnemonic = "legal winner thank year wave sausage worth useful legal winner thank yellow";
+        std::string expected = runCommand("../wallet_generator -a -c 4 -v \"" + mnemonic + "\"");
+        for (const std::string backend : {"openssl", "native"}) {
+            if (version.find(backend) == std::string::npos) continue;
+            std::string selected = runCommand("../wallet_generator --ec-backend " + backend + " --version");
+            TEST_ASSERT(selected.find("EC backend: " + backend + " (") != std::string::npos, "--ec-backend should select " + backend);
+            std::string output = runCommand("../wallet_generator --ec-backend " + backend + " -a -c 4 -v \"" + mnemonic + "\"");
+            TEST_ASSERT(!output.empty() && output == expected, "The " + backend + " backend should produce identical wallets");
+        }
+
+        std::string bad = runCommand("../wallet_generator --ec-backend p256 --version 2>&1; echo \"exit=$?\"");
+        TEST_ASSERT(bad.find("Error: Unknown EC backend") != std::string::npos && bad.find("exit=1") != std::string::npos,
+                   "Unknown EC backends should be rejected");
+
+        if (version.find("native") != std::string::npos) {
+            // The first run creates the table file, later ones map it
+            const std::string table = "/tmp/wallet_generator_ec_table_" + std::to_string(getpid());
+            unlink(table.c_str());
+            std::string first = runCommand("../wallet_generator --ec-table " + table + " -a -c 4 -v \"" + mnemonic + "\"");
+            std::string second = runCommand("../wallet_generator --ec-table " + table + " -a -c 4 -v \"" + mnemonic + "\"");
+            TEST_ASSERT(!first.empty() && first == expected && second == expected,
+                       "Wallets from a mapped EC table should be identical");
+            std::string mapped = runCommand("../wallet_generator --ec-table " + table + " --version");
+            TEST_ASSERT(mapped.find("EC table: " + table + " (6-bit windows, mapped)") != std::string::npos,
+                       "--version should report the mapped EC table");
+            std::string conflict = runCommand("../wallet_generator --ec-backend openssl --ec-table " + table +
+                                              " --version 2>&1; echo \"exit=$?\"");
+            TEST_ASSERT(conflict.find("needs --ec-backend native") != std::string::npos && conflict.find("exit=1") != std::string::npos,
+                       "--ec-table should only be accepted for the native backend");
+            unlink(table.c_str());
+        }
+    }
+
+    void testAddressIndex() {
+        TEST_GROUP("Address Index");
+
+        const std::string first = "legal winner thank year wave sausage worth useful legal winner thank yellow";
+        const std::string second = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        const std::string base = "/tmp/wallet_generator_index_" + std::to_string(getpid());
+        system(("../wallet_generator -a --start 0 --end 40 -o " + base + ".a \"" + first + "\" 2>/dev/null").c_str());
+        system(("../wallet_generator -n bitcoin --start 30 --end 60 -o " + base + ".b \"" + second + "\" 2>/dev/null").c_str());
+
+        std::string built = runCommand("../wallet_generator --index-build " + base + ".idx " + base + ".a 2>&1");
+        TEST_ASSERT(built.find("Indexed 400 addresses from 1 inputs") != std::string::npos, "Every chunk record should be indexed");
+
+        // Addresses from the chunk, looked up by address
+        std::string chunk = runCommand("cat " + base + ".a");
+        std::string bitcoinRecord = chunk.substr(chunk.find("\n33\tbitcoin\t") + 1);
+        bitcoinRecord = bitcoinRecord.substr(0, bitcoinRecord.find('\n'));
+        std::string bitcoinAddress = bitcoinRecord.substr(bitcoinRecord.find("\t1") + 1);
+        bitcoinAddress = bitcoinAddress.substr(0, bitcoinAddress.find('\t'));
+        std::string seed = chunk.substr(chunk.find("seed=") + 5, 8);
+        std::string found = runCommand("../wallet_generator --lookup " + base + ".idx " + bitcoinAddress);
+        TEST_ASSERT(found == bitcoinAddress + "\tbitcoin\t" + seed + "\tm/44'/0'/0'/0/33\n",
+                   "A lookup should return the wallet and path of a Base58 address");
+        std::string ethereumAddress = chunk.substr(chunk.find("\n12\tpolygon\t"));
+        ethereumAddress = ethereumAddress.substr(ethereumAddress.find("0x"), 42);
+        std::string shared = runCommand("../wallet_generator --lookup " + base + ".idx " + ethereumAddress);
+        TEST_ASSERT(shared.find("\tavalanche\t" + seed + "\tm/44'/60'/0'/0/12\n") != std::string::npos &&
+                   shared.find("\tpolygon\t") != std::string::npos && shared.find("\tethereum\t") != std::string::npos,
+                   "Ethereum-style addresses should match every network sharing them");
+
+        // Adding a batch to an existing index gives the same file as building at once
+        runCommand("../wallet_generator --index-build " + base + ".idx " + base + ".idx " + base + ".b 2>&1");
+        runCommand("../wallet_generator --index-build " + base + ".all " + base + ".b " + base + ".a " + base + ".a 2>&1");
+        TEST_ASSERT(system(("cmp -s " + base + ".idx " + base + ".all").c_str()) == 0,
+                   "Merging a batch into an index should equal a full rebuild, without duplicates");
+        std::string both = runCommand("../wallet_generator --lookup " + base + ".idx " + bitcoinAddress +
+                                      " 0x0000000000000000000000000000000000000001 2>&1; echo \"exit=$?\"");
+        TEST_ASSERT(both.find("\tm/44'/0'/0'/0/33\n") != std::string::npos &&
+                   both.find("Not found: 0x0000000000000000000000000000000000000001") != std::string::npos &&
+                   both.find("exit=1") != std::string::npos, "Unknown addresses should be reported with exit status 1");
+
+        std::string malformed = runCommand("../wallet_generator --lookup " + base + ".idx 1BoatSLRHtKNngkdXEeobR76b53LETtpyU 2>&1");
+        TEST_ASSERT(malformed.find("Error: Not an address of a supported network") != std::string::npos,
+                   "Malformed addresses should be rejected");
+
+        // Chunks whose address does not belong to the public key, and damaged indexes
+        std::string tampered = chunk;
+        tampered.replace(tampered.find(bitcoinAddress), bitcoinAddress.size(), "1" + bitcoinAddress.substr(1, bitcoinAddress.size() - 2) + "z");
+        std::ofstream(base + ".bad") << tampered;
+        std::string rejected = runCommand("../wallet_generator --index-build " + base + ".x " + base + ".bad 2>&1");
+        TEST_ASSERT(rejected.find("address does not match its public key at index 33") != std::string::npos,
+                   "Records whose address does not match the public key should be rejected");
+        system(("head -c 5000 " + base + ".idx > " + base + ".cut").c_str());
+        std::string truncated = runCommand("../wallet_generator --lookup " + base + ".cut " + bitcoinAddress + " 2>&1");
+        TEST_ASSERT(truncated.find("Error: Address index is truncated") != std::string::npos, "Truncated indexes should be rejected");
+
+        for (const std::string suffix : {".a", ".b", ".idx", ".all", ".bad", ".cut"}) unlink((base + suffix).c_str());
+    }
+
+    void testSeedCache() {
+        TEST_GROUP("Seed Cache");
+
+        const std::string base = "/tmp/wallet_generator_seed_cache_" + std::to_string(getpid());
+        const std::string cache = "--seed-cache " + base + ".wgsc --seed-cache-key " + base + ".key";
+        std::ofstream(base + ".txt") << "legal winner thank year wave sausage worth useful legal winner thank yellow\n"
+                                     << "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about\n";
+        const std::string bulk = "-n litecoin -c 2 --format tsv --input " + base + ".txt";
+        std::string plain = runCommand("../wallet_generator " + bulk + " 2>/dev/null");
+
+        std::string cold = runCommand("../wallet_generator " + cache + " " + bulk + " -o " + base + ".cold 2>&1");
+        std::string warm = runCommand("../wallet_generator " + cache + " " + bulk + " -o " + base + ".warm 2>&1");
+        TEST_ASSERT(cold.find("Seed cache: 0 hits, 2 misses") != std::string::npos &&
+                   warm.find("Seed cache: 2 hits, 0 misses") != std::string::npos,
+                   "A repeat run should take its seeds from the cache");
+        TEST_ASSERT(runCommand("cat " + base + ".warm") == plain && runCommand("cat " + base + ".cold") == plain,
+                   "Cached seeds should give identical output");
+
+        // The single-phrase path shares the cache; a new passphrase misses
+        std::string single = runCommand("../wallet_generator " + cache + " -n litecoin -c 2 \"abandon abandon abandon abandon "
+                                        "abandon abandon abandon abandon abandon abandon abandon about\" 2>&1");
+        std::string withPassphrase = runCommand("../wallet_generator " + cache + " -P extra -n litecoin \"abandon abandon "
+                                                "abandon abandon abandon abandon abandon abandon abandon abandon abandon about\" 2>&1");
+        TEST_ASSERT(single.find("Seed cache: 1 hit, 0 misses") != std::string::npos &&
+                   withPassphrase.find("Seed cache: 0 hits, 1 miss") != std::string::npos,
+                   "Cache entries should be keyed by phrase and passphrase");
+
+        chmod((base + ".key").c_str(), 0644);
+        std::string refused = runCommand("../wallet_generator " + cache + " " + bulk + " 2>&1");
+        TEST_ASSERT(refused.find("must not be accessible by other users") != std::string::npos,
+                   "A host key readable by others should be refused");
+
+        for (const std::string suffix : {".wgsc", ".wgsc.lock", ".key", ".txt", ".cold", ".warm"}) unlink((base + suffix).c_str());
+    }
+
+    void testEncryptedOutput() {
+        TEST_GROUP("Encrypted Output");
+
+        const std::string mnemonic = "legal winner thank year wave sausage worth useful legal winner thank yellow";
+        const std::string base = "/tmp/wallet_generator_encrypted_" + std::to_string(getpid());
+        const std::string key = "--encrypt-key " + base + ".key";
+
+        std::string plain = runCommand("../wallet_generator -a -c 2 -v \"" + mnemonic + "\"");
+        system(("../wallet_generator " + key + " -a -c 2 -v \"" + mnemonic + "\" > " + base + ".enc").c_str());
+        std::string sealed = runCommand("cat " + base + ".enc");
+        TEST_ASSERT(sealed.compare(0, 4, "WGEO") == 0 && sealed.find("Private Key") == std::string::npos,
+                   "stdout should carry only sealed frames");
+        struct stat keyStat;
+        TEST_ASSERT(stat((base + ".key").c_str(), &keyStat) == 0 && (keyStat.st_mode & 0777) == 0600,
+                   "A missing key should be created with mode 0600");
+        TEST_ASSERT(runCommand("../wallet_generator " + key + " --decrypt " + base + ".enc 2>/dev/null") == plain,
+                   "Decrypting should give the plaintext output");
+
+        // Bulk output to -o, decrypted to a file
+        std::ofstream(base + ".txt") << mnemonic << "\n" << mnemonic << "\tTREZOR\n";
+        std::string tsv = runCommand("../wallet_generator -n ethereum -c 3 --format tsv --input " + base + ".txt 2>/dev/null");
+        std::string bulk = runCommand("../wallet_generator " + key + " -n ethereum -c 3 --format tsv --input " + base +
+                                      ".txt -o " + base + ".tsv.enc 2>&1");
+        std::string decrypted = runCommand("../wallet_generator " + key + " --decrypt " + base + ".tsv.enc -o " + base + ".tsv 2>&1");
+        TEST_ASSERT(bulk.find("Processed 2 records") != std::string::npos &&
+                   decrypted.find("Decrypted and verified " + std::to_string(tsv.size()) + " bytes") != std::string::npos &&
+                   runCommand("cat " + base + ".tsv") == tsv, "Bulk output to a file should be encrypted");
+
+        system(("head -c 100 " + base + ".enc > " + base + ".cut").c_str());
+        std::string truncated = runCommand("../wallet_generator " + key + " --decrypt " + base + ".cut 2>&1; echo \"exit=$?\"");
+        TEST_ASSERT(truncated.find("Error: Encrypted output is truncated") != std::string::npos &&
+                   truncated.find("exit=1") != std::string::npos, "Truncated files should fail with exit status 1");
+        std::string missingKey = runCommand("../wallet_generator --encrypt-key " + base + ".other --decrypt " + base + ".enc 2>&1");
+        TEST_ASSERT(missingKey.find("Cannot open Output key") != std::string::npos, "Decrypting should not create a key");
+        std::string checkpoint = runCommand("../wallet_generator " + key + " --start 0 --end 5 --checkpoint " + base +
+                                            ".ckpt -o " + base + ".chunk \"" + mnemonic + "\" 2>&1");
+        TEST_ASSERT(checkpoint.find("cannot be combined with --checkpoint") != std::string::npos,
+                   "Checkpointed sweeps should not be encrypted");
+
+        for (const std::string suffix : {".key", ".enc", ".txt", ".tsv.enc", ".tsv", ".cut"}) unlink((base + suffix).c_str());
+    }
+
+    void testShardedSweep() {
+        TEST_GROUP("Sharded Index Sweeps");
+
+        const std::string mnemonic = "legal winner thank year wave sausage worth useful legal winner thank yellow";
+        const std::string base = "/tmp/wallet_generator_shard_" + std::to_string(getpid());
+        const std::string job = "-n ethereum --start 7 --end 47 --threads 3 \"" + mnemonic + "\"";
+        std::string single = runCommand("../wallet_generator " + job + " 2>/dev/null");
+        TEST_ASSERT(single.find("#walletgen-chunk 1\n#job networks=ethereum start=7 end=47 seed=") == 0,
+                   "A sweep should write a self-describing chunk header");
+        TEST_ASSERT(single.find("\n7\tethereum\tm/44'/60'/0'/0/7\t0x") != std::string::npos &&
+                   single.find("\n#end records=40\n") != std::string::npos, "The chunk should hold one record per index");
+
+        std::string plain = runCommand("../wallet_generator -n ethereum -c 8 \"" + mnemonic + "\"");
+        std::string lastAddress = single.substr(single.find("\n7\tethereum\t"));
+        lastAddress = lastAddress.substr(lastAddress.find("0x"), 42);
+        TEST_ASSERT(plain.find(lastAddress) != std::string::npos, "Sweep records should match the regular output for the same index");
+
+        // Run the shards as separate processes at once, then merge out of order
+        for (const std::string mode : {"contiguous", "strided"}) {
+            std::string shards;
+            for (int k = 0; k < 3; k++) {
+                shards += "../wallet_generator --shard " + std::to_string(k) + "/3 --shard-mode " + mode + " -o " +
+                          base + "." + std::to_string(k) + " " + job + " 2>/dev/null & ";
+            }
+            system((shards + "wait").c_str());
+            std::string merged = runCommand("../wallet_generator --merge " + base + ".2 " + base + ".0 " + base + ".1 2>/dev/null");
+            TEST_ASSERT(merged == single, "Merged " + mode + " shards should equal the single-process sweep");
+        }
+
+        std::string missing = runCommand("../wallet_generator --merge " + base + ".0 " + base + ".1 2>&1");
+        TEST_ASSERT(missing.find("Error: Missing chunks") != std::string::npos, "Merging should detect a missing shard");
+        std::string twice = runCommand("../wallet_generator --merge " + base + ".0 " + base + ".1 " + base + ".1 2>&1");
+        TEST_ASSERT(twice.find("given twice") != std::string::npos, "Merging should detect a repeated shard");
+        system(("head -n 8 " + base + ".1 > " + base + ".cut").c_str());
+        std::string truncated = runCommand("../wallet_generator --merge " + base + ".0 " + base + ".cut " + base + ".2 2>&1");
+        TEST_ASSERT(truncated.find("truncated chunk") != std::string::npos, "Merging should detect a truncated chunk");
+
+        std::string conflict = runCommand("../wallet_generator --shard 0/2 -p \"m/0\" \"" + mnemonic + "\" 2>&1");
+        TEST_ASSERT(conflict.find("Error:") != std::string::npos, "Sweeps should reject a custom path");
+        std::string badShard = runCommand("../wallet_generator --shard 3/3 \"" + mnemonic + "\" 2>&1");
+        TEST_ASSERT(badShard.find("Error: Invalid shard") != std::string::npos, "Shard index must be below the shard count");
+
+        for (const std::string suffix : {".0", ".1", ".2", ".cut"}) unlink((base + suffix).c_str());
+    }
+
+    void testSweepResume() {
+        TEST_GROUP("Sweep Checkpoint and Resume");
+
+        const std::string mnemonic = "legal winner thank year wave sausage worth useful legal winner thank yellow";
+        const std::string base = "/tmp/wallet_generator_resume_" + std::to_string(getpid());
+        const std::string output = base + ".tsv";
+        const std::string checkpoint = base + ".ckpt";
+        const std::string job = "-a --end 400 --threads 2 -o " + output + " --checkpoint " + checkpoint;
+        system(("../wallet_generator -a --end 400 --threads 2 -o " + base + ".full \"" + mnemonic + "\" 2>/dev/null").c_str());
+        std::string full = runCommand("cat " + base + ".full");
+
+        // Kill the sweep once it has checkpointed, as a crash would
+        pid_t pid = fork();
+        if (pid == 0) {
+            execl("../wallet_generator", "wallet_generator", "-a", "--end", "400", "--threads", "2", "-o", output.c_str(),
+                  "--checkpoint", checkpoint.c_str(), "--checkpoint-interval", "0", mnemonic.c_str(), (char*)nullptr);
+            _exit(127);
+        }
+        TEST_ASSERT(pid > 0, "Should start the sweep");
+        for (int i = 0; i < 1000 && access(checkpoint.c_str(), F_OK) != 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+
+        std::string saved = runCommand("cat " + checkpoint);
+        TEST_ASSERT(saved.find("#walletgen-checkpoint 1\njob networks=bitcoin,") == 0 &&
+                   saved.find("\nlast bitcoin ") != std::string::npos, "The checkpoint should record the job and the last index per network");
+        system(("cp " + output + " " + base + ".partial && cp " + checkpoint + " " + base + ".saved").c_str());
+
+        std::string other = runCommand("../wallet_generator " + job + " --resume \"abandon abandon abandon abandon abandon "
+                                       "abandon abandon abandon abandon abandon abandon about\" 2>&1");
+        TEST_ASSERT(other.find("Error:") != std::string::npos && other.find("different job") != std::string::npos,
+                   "Resuming with another mnemonic should be rejected");
+
+        std::string resumed = runCommand("../wallet_generator " + job + " --resume \"" + mnemonic + "\" 2>&1");
+        TEST_ASSERT(resumed.find("Wrote 4000 records") != std::string::npos, "The resumed sweep should complete");
+        TEST_ASSERT(runCommand("cat " + output) == full, "The resumed output should equal an uninterrupted sweep");
+        TEST_ASSERT(access(checkpoint.c_str(), F_OK) != 0, "The checkpoint should be removed once the sweep completes");
+
+        // An output that no longer matches its checkpoint must not be extended
+        system(("cp " + base + ".saved " + checkpoint + " && sed '5s/^/x/' " + base + ".partial > " + output).c_str());
+        std::string corrupt = runCommand("../wallet_generator " + job + " --resume \"" + mnemonic + "\" 2>&1");
+        TEST_ASSERT(corrupt.find("does not match its checkpoint") != std::string::npos, "Resuming should detect a modified output file");
+
+        std::string noOutput = runCommand("../wallet_generator --end 4 --checkpoint " + checkpoint + " \"" + mnemonic + "\" 2>&1");
+        TEST_ASSERT(noOutput.find("Error:") != std::string::npos, "Checkpoints should require an output file");
+
+        for (const std::string suffix : {".tsv", ".ckpt", ".full", ".partial", ".saved"}) unlink((base + suffix).c_str());
+    }
 };
 
 int main() {
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <cctype>
 #include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <functional>
 #include <string>
 #include <vector>
@@ -20,6 +23,7 @@ public:
         testBatchGenerationPerformance();
         testMemoryUsageTest();
         testScalabilityTest();
+        testStartupLatency();
         
         std::cout << "\n" << TestFramework::getSummary() << std::endl;
     }
@@ -157,6 +161,50 @@ private:
         TEST_ASSERT(ratio10to100 < 15, "10 to 100 wallet scaling should be reasonable");
         TEST_ASSERT(times[2] < 5000, "100 wallets should generate in under 5 seconds");
     }
+
+    void testStartupLatency() {
+        TEST_GROUP("Startup Latency");
+        
+        std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        
+        // Constructing a generator no longer builds crypto state of its own
+        const int constructions = 100;
+        double constructTime = measureExecutionTime([&]() {
+            for (int i = 0; i < constructions; i++) {
+                WalletGenerator fresh;
+            }
+        });
+        std::cout << "Generator construction: " << (constructTime / constructions) << "ms average" << std::endl;
+        TEST_ASSERT(constructTime / constructions < 1, "Generator construction should take less than 1ms");
+        
+        double firstWalletTime = measureExecutionTime([&]() {
+            WalletGenerator fresh;
+            std::vector<uint8_t> seed = fresh.mnemonicToSeed(mnemonic);
+            fresh.generateWallet(seed, "ethereum");
+        });
+        std::cout << "In-process time to first wallet: " << firstWalletTime << "ms" << std::endl;
+        TEST_ASSERT(firstWalletTime < 100, "Fresh generator should produce its first wallet quickly");
+        
+        // End-to-end cold start of the CLI, when it has been built
+        if (!std::ifstream("../wallet_generator").good()) {
+            std::cout << "wallet_generator binary not built; skipping process startup measurement" << std::endl;
+            return;
+        }
+        
+        for (const std::string network : {"ethereum", "bitcoin"}) {
+            std::string command = "../wallet_generator -n " + network + " \"" + mnemonic + "\" > /dev/null";
+            std::vector<double> samples;
+            for (int i = 0; i < 5; i++) {
+                samples.push_back(measureExecutionTime([&]() {
+                    int status = std::system(command.c_str());
+                    (void)status;
+                }));
+            }
+            std::sort(samples.begin(), samples.end());
+            std::cout << "Process time to first wallet (" << network << "): " << samples[2] << "ms median" << std::endl;
+            TEST_ASSERT(samples[2] < 1000, "Process startup for " + network + " should take less than 1 second");
+        }
+    }
 };
 
 int main() {
@@ -3,6 +3,9 @@
 #include <vector>
 #include <set>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <sys/resource.h>
 #include "test_framework.h"
 #include "../wallet_generator.h"
 
@@ -42,7 +45,7 @@ private:
         for (const std::string& mnemonic : mnemonics) {
             std::vector<uint8_t> seed = generator.mnemonicToSeed(mnemonic);
             WalletGenerator::WalletInfo wallet = generator.generateWallet(seed, "bitcoin");
-            privateKeys.insert(wallet.privateKey);
+            privateKeys.insert(std::string(wallet.privateKey));
         }
         
         TEST_ASSERT(privateKeys.size() == mnemonics.size(), 
@@ -94,7 +97,7 @@ private:
             WalletGenerator::WalletInfo wallet = generator.generateWallet(seed, "bitcoin");
             
             addresses.insert(wallet.address);
-            privateKeys.insert(wallet.privateKey);
+            privateKeys.insert(std::string(wallet.privateKey));
         }
         
         TEST_ASSERT(addresses.size() == passphrases.size(), 
@@ -123,7 +126,7 @@ private:
         for (const std::string& path : paths) {
             WalletGenerator::WalletInfo wallet = generator.generateWallet(seed, "bitcoin", path);
             addresses.insert(wallet.address);
-            privateKeys.insert(wallet.privateKey);
+            privateKeys.insert(std::string(wallet.privateKey));
             TEST_ASSERT(wallet.derivationPath == path, "Derivation path should be correctly set");
         }
         
@@ -175,7 +178,7 @@ private:
         TEST_ASSERT(wallet.publicKey.substr(0, 2) == "04", "Uncompressed public key should start with 04");
         
         // Test that private key is not zero
-        std::string zeroKey(64, '0');
+        SecureString zeroKey(64, '0');
         TEST_ASSERT(wallet.privateKey != zeroKey, "Private key should not be zero");
         
         // Test that private key is less than secp256k1 curve order
@@ -212,23 +215,69 @@ private:
     void testMemoryClearing() {
         TEST_GROUP("Memory Clearing Test");
         
-        // This is a basic test - in production you'd want more sophisticated memory analysis
-        // Fixed: reduced variable scope as suggested by cppcheck
+        std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        secureArenaReset();
+        
+        const volatile uint8_t* keyBytes = nullptr;
+        bool keyNonZero = false;
         {
-            std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
-            
-            // Create wallet in a scope that will be destroyed
-            std::vector<uint8_t> seed = generator.mnemonicToSeed(mnemonic);
-            WalletGenerator::WalletInfo wallet = generator.generateWallet(seed, "bitcoin");
+            SecureBytes seed = generator.mnemonicToSecureSeed(mnemonic);
+            WalletGenerator::KeyPair keys = generator.deriveKeyPair(seed, "bitcoin");
+            WalletGenerator::WalletInfo wallet = generator.encodeWallet(keys);
             
             TEST_ASSERT(!wallet.privateKey.empty(), "Private key should be generated");
             TEST_ASSERT(!wallet.address.empty(), "Address should be generated");
+            TEST_ASSERT(secureArenaOwns(seed.data()), "Seed should live in the secure arena");
+            TEST_ASSERT(secureArenaOwns(keys.privateKey.data()), "Private key should live in the secure arena");
+            TEST_ASSERT(secureArenaOwns(wallet.privateKey.data()) && secureArenaOwns(wallet.wif.data()),
+                       "Encoded private key and WIF should live in the secure arena");
+            
+            keyBytes = keys.privateKey.data();
+            for (uint8_t b : keys.privateKey) keyNonZero = keyNonZero || b != 0;
         }
-        
-        // After scope destruction, sensitive data should ideally be cleared
-        // This is more of a design test than a functional test
-        TEST_ASSERT(true, "Memory clearing scope test completed");
+        TEST_ASSERT(keyNonZero, "Private key bytes should be non-zero while in use");
+        TEST_ASSERT(secureArenaStats().liveBlocks == 0, "Every secret buffer should be released at scope exit");
+        
+        // The arena keeps its chunks mapped, so the old key location can be inspected
+        TEST_ASSERT(secureArenaReset(), "Reset should succeed once nothing is live");
+        bool zeroed = true;
+        for (size_t i = 0; i < 32; i++) zeroed = zeroed && keyBytes[i] == 0;
+        TEST_ASSERT(zeroed, "Released private key should be zeroed by the arena reset");
+        TEST_ASSERT(secureArenaStats().usedBytes == 0, "Reset should rewind the arena");
+        
+#ifdef __linux__
+        // The kernel reports the arena's pages as locked ("lo") and excluded from core dumps ("dd")
+        SecureArenaStats stats = secureArenaStats();
+        std::string flags = mappingFlags(reinterpret_cast<uintptr_t>(keyBytes));
+        TEST_ASSERT(flags.find(" dd") != std::string::npos, "Arena pages should be excluded from core dumps");
+        rlimit limit{};
+        getrlimit(RLIMIT_MEMLOCK, &limit);
+        if (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur >= stats.reservedBytes) {
+            TEST_ASSERT(flags.find(" lo") != std::string::npos && stats.lockedBytes == stats.reservedBytes,
+                       "Arena pages should be locked in memory");
+        }
+#endif
+    }
+    
+#ifdef __linux__
+    // VmFlags of the /proc/self/smaps mapping that contains address
+    std::string mappingFlags(uintptr_t address) {
+        std::ifstream smaps("/proc/self/smaps");
+        std::string line;
+        bool inMapping = false;
+        while (std::getline(smaps, line)) {
+            unsigned long start, end;
+            char dash;
+            std::istringstream header(line);
+            if ((header >> std::hex >> start >> dash >> end) && dash == '-') {
+                inMapping = address >= start && address < end;
+            } else if (inMapping && line.compare(0, 8, "VmFlags:") == 0) {
+                return line.substr(8) + " ";
+            }
+        }
+        return "";
     }
+#endif
 };
 
 int main() {
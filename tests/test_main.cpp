@@ -3,8 +3,31 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <cctype>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <functional>
+#include <unistd.h>
 #include "test_framework.h"
 #include "../wallet_generator.h"
+#include "../bounded_queue.h"
+#include "../crypto_kernels.h"
+#include "../cpu_features.h"
+#include "../bip39.h"
+#include "../walletgen.h"
+#include "../wallet_stats.h"
+#include "../windows/minimal_secp256k1.h"
+#include "../ec_backend.h"
+#include "../seed_cache.h"
+#include "../bip85.h"
+#include "../encrypted_output.h"
+#include <sstream>
+#include <sys/stat.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/provider.h>
+#endif
 
 class WalletGeneratorTest {
 private:
@@ -27,6 +50,20 @@ public:
         testKnownTestVectors();
         testMemoryManagement();
         testCryptographicFunctions();
+        testSeedBatch();
+        testSiblingDerivation();
+        testMinimalSecp256k1();
+        testEcBackends();
+        testEcTableFiles();
+        testSeedCache();
+        testBip85();
+        testEncryptedOutput();
+        testKernelDispatch();
+        testBoundedQueue();
+        testBip39Conversions();
+        testCApi();
+        testStageStats();
+        testSecureArena();
         
         std::cout << "\n" << TestFramework::getSummary() << std::endl;
     }
@@ -236,6 +273,974 @@ private:
         TEST_ASSERT(wallet1.privateKey == wallet1_repeat.privateKey, "Same seed should produce same private key");
         TEST_ASSERT(wallet1.address == wallet1_repeat.address, "Same seed should produce same address");
     }
+    
+    void testSeedBatch() {
+        TEST_GROUP("Batched Seed Derivation");
+        
+        // Six inputs: one full lane group plus a partial one, including a
+        // 24-word mnemonic longer than the 128-byte HMAC block
+        std::vector<std::string> mnemonics = {
+            "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about",
+            "legal winner thank year wave sausage worth useful legal winner thank yellow",
+            "letter advice cage absurd amount doctor acoustic avoid letter advice cage above",
+            "zoo zoo zoo zoo zoo zoo zoo zoo zoo zoo zoo wrong",
+            "letter advice cage absurd amount doctor acoustic avoid letter advice cage absurd amount doctor acoustic avoid letter advice cage absurd amount doctor acoustic bless",
+            "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about"
+        };
+        std::vector<std::string> passphrases = {"", "TREZOR", "", "passphrase123", "TREZOR", "different_passphrase"};
+        
+        std::vector<std::vector<uint8_t>> seeds = generator.mnemonicToSeedBatch(mnemonics, passphrases);
+        TEST_ASSERT(seeds.size() == mnemonics.size(), "Batch should return one seed per mnemonic");
+        for (size_t i = 0; i < mnemonics.size(); i++) {
+            TEST_ASSERT(seeds[i] == generator.mnemonicToSeed(mnemonics[i], passphrases[i]),
+                       "Batched seed " + std::to_string(i) + " should match single derivation");
+        }
+        
+        std::vector<std::vector<uint8_t>> noPassphrase = generator.mnemonicToSeedBatch({mnemonics[0]});
+        TEST_ASSERT(noPassphrase.size() == 1 && noPassphrase[0] == generator.mnemonicToSeed(mnemonics[0]),
+                   "Batch without passphrases should match single derivation");
+        TEST_ASSERT(generator.mnemonicToSeedBatch({}).empty(), "Empty batch should return no seeds");
+    }
+    
+    void testSiblingDerivation() {
+        TEST_GROUP("Sibling Key Derivation");
+        
+        // Lane kernel against OpenSSL HMAC, around the single-block limit
+        const uint8_t key[] = {'B', 'i', 't', 'c', 'o', 'i', 'n', ' ', 's', 'e', 'e', 'd'};
+        HmacSha512Key prepared;
+        hmacSha512Prepare(prepared, key, sizeof(key));
+        const size_t lengths[] = {0, 1, 64, 79, 110, 111, 112, 127, 200};
+        const size_t count = sizeof(lengths) / sizeof(lengths[0]);
+        std::vector<std::vector<uint8_t>> messages(count);
+        std::vector<std::vector<uint8_t>> digests(count, std::vector<uint8_t>(64));
+        const uint8_t* data[count];
+        uint8_t* out[count];
+        for (size_t i = 0; i < count; i++) {
+            for (size_t j = 0; j < lengths[i]; j++) messages[i].push_back(static_cast<uint8_t>(i * 31 + j));
+            data[i] = messages[i].data();
+            out[i] = digests[i].data();
+        }
+        hmacSha512Siblings(prepared, data, lengths, count, out);
+        bool allMatch = true;
+        for (size_t i = 0; i < count; i++) {
+            uint8_t expected[64];
+            unsigned int len = 0;
+            HMAC(EVP_sha512(), key, sizeof(key), messages[i].data(), messages[i].size(), expected, &len);
+            allMatch = allMatch && std::equal(expected, expected + 64, digests[i].begin());
+        }
+        TEST_ASSERT(allMatch, "Lane HMAC should match OpenSSL for every message length");
+        
+        // Batched wallets match one-at-a-time wallets for every lane fill,
+        // including a path too long for the single-block lane path
+        std::vector<uint8_t> seed = generator.mnemonicToSeed("legal winner thank year wave sausage worth useful legal winner thank yellow");
+        for (const std::string network : {"bitcoin", "ethereum"}) {
+            for (uint32_t n = 1; n <= 9; n++) {
+                std::vector<std::string> paths;
+                for (uint32_t i = 0; i < n; i++) paths.push_back(WalletGenerator::indexedPath(network, i));
+                if (n == 9) {
+                    paths[2] = "m/44'/60'/0'/0/0/this/path/is/long/enough/to/need/two/inner/blocks";
+                    paths[5] = "";
+                }
+                std::vector<WalletGenerator::WalletInfo> wallets = generator.generateWallets(seed, network, paths);
+                bool same = wallets.size() == n;
+                for (uint32_t i = 0; same && i < n; i++) {
+                    WalletGenerator::WalletInfo single = generator.generateWallet(seed, network, paths[i]);
+                    same = single.privateKey == wallets[i].privateKey && single.address == wallets[i].address &&
+                           single.derivationPath == wallets[i].derivationPath;
+                }
+                TEST_ASSERT(same, network + ": " + std::to_string(n) + " batched wallets should match single derivations");
+            }
+        }
+        TEST_ASSERT(generator.generateWallets(seed, "bitcoin", {}).empty(), "No paths should give no wallets");
+    }
+    
+    void testMinimalSecp256k1() {
+        TEST_GROUP("Minimal secp256k1 Backend");
+        
+        MinimalSecp256k1Context ctx;
+        std::vector<uint8_t> one(32, 0);
+        one[31] = 1;
+        std::vector<uint8_t> g = minimal_secp256k1_get_public_key(&ctx, one);
+        std::string gHex(130, '\0');
+        kernels().hexEncode(g.data(), g.size(), &gHex[0]);
+        TEST_ASSERT(gHex ==
+                   "0479be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798"
+                   "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8",
+                   "1 * G should be the generator");
+        
+        const uint8_t orderBytes[32] = {
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+            0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B, 0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41
+        };
+        std::vector<uint8_t> order(orderBytes, orderBytes + 32);
+        std::vector<uint8_t> orderMinusOne(order);
+        orderMinusOne[31]--;
+        std::vector<uint8_t> negG = minimal_secp256k1_get_public_key(&ctx, orderMinusOne);
+        TEST_ASSERT(std::equal(g.begin(), g.begin() + 33, negG.begin()) && (g[64] & 1) != (negG[64] & 1),
+                   "(n - 1) * G should be -G");
+        uint8_t out[65];
+        TEST_ASSERT(!minimal_secp256k1_create_public_key(&ctx, std::vector<uint8_t>(32, 0).data(), out),
+                   "A zero key should be rejected");
+        TEST_ASSERT(!minimal_secp256k1_create_public_key(&ctx, order.data(), out), "The curve order should be rejected");
+        TEST_ASSERT(!minimal_secp256k1_create_public_key(&ctx, std::vector<uint8_t>(32, 0xFF).data(), out),
+                   "Keys above the curve order should be rejected");
+        
+        // Against OpenSSL's generic multiplication, for keys with zero and
+        // full digits in every window
+        EC_GROUP* group = EC_GROUP_new_by_curve_name(NID_secp256k1);
+        EC_POINT* point = EC_POINT_new(group);
+        bool allMatch = true;
+        for (int i = 0; i < 40; i++) {
+            std::vector<uint8_t> key(32);
+            uint8_t label = static_cast<uint8_t>(i);
+            kernels().sha256(&label, 1, key.data());
+            if (i % 4 == 1) key.assign(32, 0);
+            if (i % 4 == 1) key[i % 32] = 0x0F;
+            if (i % 4 == 2) std::fill(key.begin(), key.begin() + i % 16, 0);
+            BIGNUM* scalar = BN_bin2bn(key.data(), 32, nullptr);
+            uint8_t expected[65];
+            bool ok = EC_POINT_mul(group, point, scalar, nullptr, nullptr, nullptr) &&
+                      EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, expected, 65, nullptr) == 65;
+            BN_free(scalar);
+            allMatch = allMatch && ok && minimal_secp256k1_create_public_key(&ctx, key.data(), out) &&
+                       std::equal(out, out + 65, expected);
+        }
+        EC_POINT_free(point);
+        EC_GROUP_free(group);
+        TEST_ASSERT(allMatch, "Comb results should match OpenSSL's scalar multiplication");
+        
+        std::vector<uint8_t> compressed = minimal_secp256k1_compress_public_key(g);
+        TEST_ASSERT(compressed.size() == 33 && compressed[0] == 0x02, "Compressed G should have an even prefix");
+    }
+    
+    void testEcBackends() {
+        TEST_GROUP("EC Backends");
+        
+        std::vector<std::string> names = ecBackendNames();
+        TEST_ASSERT(names.size() >= 2, "At least two EC backends should be built in");
+        TEST_ASSERT(selectedEcBackend() == names.front(), "The first backend should be the default");
+        std::vector<std::unique_ptr<EcBackend>> backends;
+        for (const std::string& name : names) backends.push_back(createEcBackend(name));
+        
+        // Random keys plus edge cases: tiny, n - 1, zero, n and above, and
+        // keys with runs of zero digits
+        const uint8_t orderBytes[32] = {
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+            0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B, 0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41
+        };
+        std::vector<std::vector<uint8_t>> keys;
+        for (int i = 0; i < 200; i++) {
+            std::vector<uint8_t> key(32);
+            uint8_t label[2] = {0xEC, static_cast<uint8_t>(i)};
+            kernels().sha256(label, sizeof(label), key.data());
+            if (i % 5 == 1) std::fill(key.begin(), key.begin() + i % 31, 0);
+            if (i % 5 == 2) std::fill(key.begin() + i % 29, key.end() - 1, 0);
+            keys.push_back(key);
+        }
+        std::vector<uint8_t> edge(32, 0);
+        edge[31] = 1;
+        keys.push_back(edge);
+        keys.push_back(std::vector<uint8_t>(32, 0));
+        keys.push_back(std::vector<uint8_t>(orderBytes, orderBytes + 32));
+        edge.assign(orderBytes, orderBytes + 32);
+        edge[31]--;
+        keys.push_back(edge);
+        keys.push_back(std::vector<uint8_t>(32, 0xFF));
+        
+        bool createMatch = true, tweakMatch = true, batchMatch = true, rejectMatch = true;
+        std::vector<const uint8_t*> keyPointers;
+        for (const auto& key : keys) keyPointers.push_back(key.data());
+        std::vector<EcPubkey> reference(keys.size());
+        std::unique_ptr<bool[]> referenceOk(new bool[keys.size()]);
+        for (size_t k = 0; k < keys.size(); k++) referenceOk[k] = backends[0]->pubkeyCreate(keys[k].data(), reference[k]);
+        
+        for (size_t b = 1; b < backends.size(); b++) {
+            for (size_t k = 0; k < keys.size(); k++) {
+                EcPubkey pubkey;
+                bool ok = backends[b]->pubkeyCreate(keys[k].data(), pubkey);
+                if (ok != referenceOk[k]) rejectMatch = false;
+                if (ok && referenceOk[k] && !std::equal(pubkey.xy, pubkey.xy + 64, reference[k].xy)) createMatch = false;
+                if (!referenceOk[k]) continue;
+                
+                // Tweak by the next key (including zero and out-of-range tweaks)
+                const std::vector<uint8_t>& tweak = keys[(k + 1) % keys.size()];
+                EcPubkey expected = reference[k], actual = reference[k];
+                bool expectedOk = backends[0]->pubkeyTweakAdd(expected, tweak.data());
+                bool actualOk = backends[b]->pubkeyTweakAdd(actual, tweak.data());
+                if (expectedOk != actualOk || (expectedOk && !std::equal(actual.xy, actual.xy + 64, expected.xy))) {
+                    tweakMatch = false;
+                }
+            }
+            
+            std::vector<EcPubkey> batch(keys.size());
+            std::unique_ptr<bool[]> batchOk(new bool[keys.size()]);
+            backends[b]->pubkeyCreateBatch(keyPointers.data(), keys.size(), batch.data(), batchOk.get());
+            for (size_t k = 0; k < keys.size(); k++) {
+                if (batchOk[k] != referenceOk[k] ||
+                    (batchOk[k] && !std::equal(batch[k].xy, batch[k].xy + 64, reference[k].xy))) {
+                    batchMatch = false;
+                }
+            }
+        }
+        TEST_ASSERT(createMatch, "All backends should compute the same public keys");
+        TEST_ASSERT(rejectMatch, "All backends should reject the same private keys");
+        TEST_ASSERT(tweakMatch, "All backends should agree on tweak additions");
+        TEST_ASSERT(batchMatch, "Batched creation should match single keys");
+        
+        // P + (n - 1) * G with P = G is the point at infinity
+        EcPubkey g = reference[200];
+        bool infinityRejected = true;
+        for (auto& backend : backends) {
+            EcPubkey p = g;
+            if (backend->pubkeyTweakAdd(p, keys[203].data())) infinityRejected = false;
+        }
+        TEST_ASSERT(infinityRejected, "A tweak summing to infinity should fail");
+        EcPubkey offCurve = g;
+        offCurve.xy[63] ^= 1;
+        bool offCurveRejected = true;
+        for (auto& backend : backends) {
+            if (backend->pubkeyTweakAdd(offCurve, keys[0].data())) offCurveRejected = false;
+        }
+        TEST_ASSERT(offCurveRejected, "Points off the curve should be rejected");
+        
+        uint8_t encoded[65];
+        TEST_ASSERT(EcBackend::serialize(g, encoded, true) == 33 && encoded[0] == 0x02, "Compressed serialization");
+        TEST_ASSERT(EcBackend::serialize(g, encoded, false) == 65 && encoded[0] == 0x04, "Uncompressed serialization");
+        
+        // Every backend generates the same wallets
+        std::vector<uint8_t> seed = generator.mnemonicToSeed(
+            "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about");
+        std::vector<std::string> paths = {"", "m/44'/0'/0'/0/1", "m/44'/0'/0'/0/2"};
+        std::vector<std::string> expected;
+        for (const auto& wallet : generator.generateWallets(seed, "bitcoin", paths)) expected.push_back(wallet.address);
+        std::string expectedEthereum = generator.generateWallet(seed, "ethereum").address;
+        bool walletsMatch = true;
+        for (const std::string& name : names) {
+            selectEcBackend(name);
+            std::vector<WalletGenerator::WalletInfo> wallets = generator.generateWallets(seed, "bitcoin", paths);
+            for (size_t i = 0; i < wallets.size(); i++) walletsMatch = walletsMatch && wallets[i].address == expected[i];
+            walletsMatch = walletsMatch && generator.generateWallet(seed, "ethereum").address == expectedEthereum;
+        }
+        selectEcBackend(names.front());
+        TEST_ASSERT(walletsMatch, "Wallets should not depend on the EC backend");
+        
+        bool threw = false;
+        try {
+            selectEcBackend("p256");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        TEST_ASSERT(threw && selectedEcBackend() == names.front(), "Unknown backends should be rejected");
+    }
+    
+    void testEcTableFiles() {
+        TEST_GROUP("EC Table Files");
+        
+        std::vector<std::string> names = ecBackendNames();
+        if (std::find(names.begin(), names.end(), "native") == names.end()) {
+            TEST_ASSERT(true, "Native EC backend not built; table files skipped");
+            return;
+        }
+        
+        // Keys computed with the built-in table, to compare mapped tables against
+        std::vector<std::vector<uint8_t>> keys;
+        std::vector<EcPubkey> expected;
+        std::unique_ptr<EcBackend> builtin = createEcBackend("native");
+        for (int i = 0; i < 64; i++) {
+            std::vector<uint8_t> key(32);
+            uint8_t label[2] = {0x7B, static_cast<uint8_t>(i)};
+            kernels().sha256(label, sizeof(label), key.data());
+            EcPubkey pubkey;
+            builtin->pubkeyCreate(key.data(), pubkey);
+            keys.push_back(key);
+            expected.push_back(pubkey);
+        }
+        TEST_ASSERT(ecTableDescription() == "built-in (4-bit windows)", "The built-in table should be in use by default");
+        
+        const std::string base = "/tmp/wallet_generator_ec_table_" + std::to_string(getpid());
+        bool allMatch = true;
+        for (int bits : {8, 5, 6}) {
+            const std::string path = base + "_" + std::to_string(bits);
+            writeEcTable(path, bits);
+            mapEcTable(path);
+            std::unique_ptr<EcBackend> mapped = createEcBackend("native");
+            for (size_t k = 0; k < keys.size(); k++) {
+                EcPubkey pubkey;
+                allMatch = allMatch && mapped->pubkeyCreate(keys[k].data(), pubkey) &&
+                           std::equal(pubkey.xy, pubkey.xy + 64, expected[k].xy);
+            }
+        }
+        TEST_ASSERT(allMatch, "Mapped tables of any window size should give the built-in table's keys");
+        TEST_ASSERT(ecTableDescription() == base + "_6 (6-bit windows, mapped)", "The mapped table should be reported");
+        
+        // A missing file is created first
+        const std::string created = base + "_created";
+        useEcTable(created);
+        std::ifstream createdFile(created, std::ios::binary | std::ios::ate);
+        TEST_ASSERT(createdFile && createdFile.tellg() == 64 + 43 * 64 * 64, "useEcTable should write a 6-bit table");
+        
+        // Damaged files are rejected when mapped
+        auto rejected = [](const std::string& path, const std::string& message) {
+            try {
+                mapEcTable(path);
+            } catch (const std::runtime_error& e) {
+                return std::string(e.what()).find(message) != std::string::npos;
+            }
+            return false;
+        };
+        const std::string damaged = base + "_damaged";
+        std::string contents((std::istreambuf_iterator<char>(createdFile.seekg(0))), std::istreambuf_iterator<char>());
+        contents[5000] ^= 1;
+        std::ofstream(damaged, std::ios::binary) << contents;
+        TEST_ASSERT(rejected(damaged, "checksum mismatch"), "A flipped bit should fail the checksum");
+        std::ofstream(damaged, std::ios::binary) << contents.substr(0, 4096);
+        TEST_ASSERT(rejected(damaged, "truncated"), "A truncated table should be rejected");
+        contents[4] = 2;
+        std::ofstream(damaged, std::ios::binary) << contents;
+        TEST_ASSERT(rejected(damaged, "Unsupported EC table version"), "Unknown format versions should be rejected");
+        std::ofstream(damaged, std::ios::binary) << std::string(4096, '#');
+        TEST_ASSERT(rejected(damaged, "Not an EC table file"), "Other files should be rejected");
+        TEST_ASSERT(ecTableDescription() == base + "_created (6-bit windows, mapped)",
+                   "A rejected file should leave the mapped table in place");
+        
+        bool threw = false;
+        try {
+            writeEcTable(base + "_9", 9);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        TEST_ASSERT(threw, "Windows wider than 8 bits should be rejected");
+        
+        for (const char* suffix : {"_8", "_5", "_6", "_created", "_damaged"}) unlink((base + suffix).c_str());
+    }
+    
+    void testSeedCache() {
+        TEST_GROUP("Seed Cache");
+        
+        const std::string base = "/tmp/wallet_generator_seed_cache_" + std::to_string(getpid());
+        const std::string path = base + ".wgsc";
+        const std::string keyPath = base + "_keys/host.key";
+        const std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        SecureBytes expected = generator.mnemonicToSecureSeed(mnemonic, "TREZOR");
+        
+        {
+            SeedCache cache(path, keyPath);
+            SecureBytes seed;
+            TEST_ASSERT(!cache.lookup(mnemonic, "TREZOR", seed), "An empty cache should miss");
+            cache.insert(mnemonic, "TREZOR", expected);
+            cache.save();
+            TEST_ASSERT(cache.report() == "0 hits, 1 miss", "Misses should be counted");
+        }
+        struct stat keyStat;
+        TEST_ASSERT(stat(keyPath.c_str(), &keyStat) == 0 && (keyStat.st_mode & 0777) == 0600 && keyStat.st_size == 32,
+                   "The host key should be created with mode 0600");
+        
+        {
+            SeedCache cache(path, keyPath);
+            SecureBytes seed;
+            bool hit = cache.lookup(mnemonic, "TREZOR", seed);
+            TEST_ASSERT(hit && seed.size() == 64 && std::equal(seed.begin(), seed.end(), expected.begin()),
+                       "A saved seed should be read back");
+            TEST_ASSERT(!cache.lookup(mnemonic, "", seed), "Other passphrases should miss");
+            TEST_ASSERT(cache.hits() == 1 && cache.misses() == 1, "Hits and misses should be counted");
+        }
+        
+        // Another process's entries are merged on save, not overwritten
+        {
+            SeedCache first(path, keyPath);
+            SeedCache second(path, keyPath);
+            first.insert(mnemonic, "first", generator.mnemonicToSecureSeed(mnemonic, "first"));
+            second.insert(mnemonic, "second", generator.mnemonicToSecureSeed(mnemonic, "second"));
+            first.save();
+            second.save();
+        }
+        {
+            SeedCache cache(path, keyPath);
+            SecureBytes seed;
+            bool all = cache.lookup(mnemonic, "TREZOR", seed) && cache.lookup(mnemonic, "first", seed) &&
+                       cache.lookup(mnemonic, "second", seed);
+            TEST_ASSERT(all, "Concurrent saves should merge");
+        }
+        std::ifstream cacheFile(path, std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(cacheFile)), std::istreambuf_iterator<char>());
+        TEST_ASSERT(contents.size() == 16 + 3 * 108 && contents.compare(0, 4, "WGSC") == 0, "The file should hold three entries");
+        TEST_ASSERT(contents.find("abandon") == std::string::npos && contents.find("TREZOR") == std::string::npos,
+                   "Neither phrases nor passphrases should be stored");
+        
+        // Entries under another host key, or tampered with, are misses
+        {
+            SeedCache cache(path, base + "_keys/other.key");
+            SecureBytes seed;
+            TEST_ASSERT(!cache.lookup(mnemonic, "TREZOR", seed), "Another host key should miss");
+        }
+        std::string tampered = contents;
+        for (size_t i = 16 + 16 + 12; i < tampered.size(); i += 108) tampered[i] ^= 1;
+        std::ofstream(path, std::ios::binary) << tampered;
+        {
+            SeedCache cache(path, keyPath);
+            SecureBytes seed;
+            TEST_ASSERT(!cache.lookup(mnemonic, "TREZOR", seed), "A tampered entry should fail authentication");
+        }
+        
+        auto rejected = [&](const std::string& file, const std::string& key, const std::string& message) {
+            try {
+                SeedCache cache(file, key);
+            } catch (const std::runtime_error& e) {
+                return std::string(e.what()).find(message) != std::string::npos;
+            }
+            return false;
+        };
+        std::ofstream(path, std::ios::binary) << contents.substr(0, 100);
+        TEST_ASSERT(rejected(path, keyPath, "truncated"), "A truncated cache should be rejected");
+        std::ofstream(path, std::ios::binary) << std::string(64, '#');
+        TEST_ASSERT(rejected(path, keyPath, "Not a seed cache"), "Other files should be rejected");
+        chmod(keyPath.c_str(), 0644);
+        TEST_ASSERT(rejected(base + ".missing", keyPath, "must not be accessible"), "A readable host key should be refused");
+        
+        for (const std::string& file : {path, keyPath, base + "_keys/other.key", path + ".lock"}) unlink(file.c_str());
+        rmdir((base + "_keys").c_str());
+    }
+    
+    void testBip85() {
+        TEST_GROUP("BIP85 Child Mnemonics");
+        
+        auto fromHex = [](const std::string& hex) {
+            std::vector<uint8_t> bytes;
+            for (size_t i = 0; i < hex.size(); i += 2) {
+                bytes.push_back(static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+            }
+            return bytes;
+        };
+        auto toHex = [](const SecureBytes& bytes) {
+            std::string hex;
+            for (uint8_t byte : bytes) {
+                hex += "0123456789abcdef"[byte >> 4];
+                hex += "0123456789abcdef"[byte & 15];
+            }
+            return hex;
+        };
+        
+        // BIP85 specification vectors; the master key is
+        // xprv9s21ZrQH143K2LBWUUQRFXhucrQqBpKdRRxNVq2zBqsx8HVqFk2uYo8kmbaLLHRdqtQpUm98uKfu3vca1LqdGhUtyoFnCNkfmXRyPXLjbKb
+        std::vector<uint8_t> key = fromHex("3f15e5d852dc2e9ba5e9fe189a8dd2e1547badef5b563bbe6579fc6807d80ed9");
+        std::vector<uint8_t> chainCode = fromHex("1b67969d1ec69bdfeeae43213da8460ba34b92d0788c8f7bfcfa44906e8a589c");
+        Bip85Mnemonics twelve(key.data(), chainCode.data(), 12);
+        TEST_ASSERT(toHex(twelve.entropy(0)) == "6250b68daf746d12a24d58b4787a714b", "12-word child entropy should match the specification");
+        TEST_ASSERT(twelve.mnemonic(0) == "girl mad pet galaxy egg matter matrix prison refuse sense ordinary nose",
+                   "12-word child mnemonic should match the specification");
+        Bip85Mnemonics twentyFour(key.data(), chainCode.data(), 24);
+        TEST_ASSERT(toHex(twentyFour.entropy(0)) == "ae131e2312cdc61331542efe0d1077bac5ea803adf24b313a4f0e48e9c51f37f",
+                   "24-word child entropy should match the specification");
+        
+        // Children of a BIP39 seed, checked against an independent implementation
+        std::vector<uint8_t> seed = generator.mnemonicToSeed(
+            "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about");
+        Bip85Mnemonics children(seed, 12);
+        TEST_ASSERT(toHex(children.entropy(0)) == "ac98dac5d4f4ebad6056682ac95eb9ad" &&
+                   toHex(children.entropy(1)) == "c9597c49b37609a2edcadf849ea23a1d" &&
+                   toHex(children.entropy(2)) == "2e33583e201eeb2444904ac2b4e69d56",
+                   "Children of a seed should use its BIP32 master key");
+        TEST_ASSERT(children.mnemonic(1) == WalletGenerator::mnemonicFromEntropyHex("c9597c49b37609a2edcadf849ea23a1d"),
+                   "Child mnemonics should encode the child entropy");
+        
+        auto rejected = [&](const std::function<void()>& fn) {
+            try {
+                fn();
+            } catch (const std::runtime_error&) {
+                return true;
+            }
+            return false;
+        };
+        TEST_ASSERT(rejected([&]() { Bip85Mnemonics(seed, 13); }), "Unsupported word counts should be rejected");
+        TEST_ASSERT(rejected([&]() { children.entropy(0x80000000u); }), "Hardened-range child indices should be rejected");
+    }
+    
+    void testEncryptedOutput() {
+        TEST_GROUP("Encrypted Output");
+        
+        const SecureBytes key(32, 0x11);
+        std::string plaintext;
+        for (int i = 0; i < 3000; i++) plaintext += "record " + std::to_string(i) + "\tprivate key material\n";
+        
+        // Small frames so the text spans many, sealed by several threads
+        auto encrypt = [&](const std::string& text, size_t frameSize) {
+            std::stringstream out;
+            EncryptedOutput sink(out.rdbuf(), key, 3, frameSize);
+            std::ostream stream(&sink);
+            for (size_t i = 0; i < text.size(); i += 777) stream << text.substr(i, 777);
+            sink.close();
+            TEST_ASSERT(sink.plaintextBytes() == text.size(), "The sink should count plaintext bytes");
+            return out.str();
+        };
+        auto decrypt = [](const std::string& sealed, const SecureBytes& withKey, std::string& error) {
+            std::istringstream in(sealed);
+            std::ostringstream out;
+            try {
+                decryptOutput(in, out, withKey);
+            } catch (const std::runtime_error& e) {
+                error = e.what();
+            }
+            return out.str();
+        };
+        
+        const size_t frameSize = 4096;
+        std::string sealed = encrypt(plaintext, frameSize);
+        size_t frames = plaintext.size() / frameSize + 1;
+        TEST_ASSERT(sealed.size() == 48 + plaintext.size() + frames * 20 && sealed.compare(0, 4, "WGEO") == 0,
+                   "Frames should add a length and a tag each");
+        TEST_ASSERT(sealed.find("private key material") == std::string::npos, "Plaintext should not appear in the output");
+        std::string error;
+        TEST_ASSERT(decrypt(sealed, key, error) == plaintext && error.empty(), "Output should decrypt to the written text");
+        TEST_ASSERT(encrypt(plaintext, frameSize) != sealed, "Each file should be sealed under its own salt");
+        std::string empty = encrypt("", frameSize);
+        TEST_ASSERT(empty.size() == 48 + 20 && decrypt(empty, key, error).empty() && error.empty(),
+                   "Empty output should still carry a last frame");
+        
+        auto rejected = [&](const std::string& damaged, const SecureBytes& withKey, const std::string& message) {
+            std::string failure;
+            decrypt(damaged, withKey, failure);
+            return failure.find(message) != std::string::npos;
+        };
+        TEST_ASSERT(rejected(sealed, SecureBytes(32, 0x12), "frame 0 failed authentication"), "A wrong key should be detected");
+        std::string flipped = sealed;
+        flipped[48 + 3 * (4 + frameSize + 16) + 100] ^= 1;
+        TEST_ASSERT(rejected(flipped, key, "frame 3 failed authentication"), "A flipped bit should be detected");
+        std::string swapped = sealed;
+        const size_t sealedFrame = 4 + frameSize + 16;
+        std::swap_ranges(swapped.begin() + 48, swapped.begin() + 48 + sealedFrame, swapped.begin() + 48 + sealedFrame);
+        TEST_ASSERT(rejected(swapped, key, "frame 0 failed authentication"), "Reordered frames should be detected");
+        TEST_ASSERT(rejected(sealed.substr(0, 48 + 2 * sealedFrame), key, "truncated after frame 2"),
+                   "A file cut at a frame boundary should be detected");
+        std::string marked = sealed.substr(0, 48 + 2 * sealedFrame);
+        marked[48 + sealedFrame + 3] |= 0x80;
+        TEST_ASSERT(rejected(marked, key, "frame 1 failed authentication"), "A forged last-frame flag should be detected");
+        TEST_ASSERT(rejected(sealed + "x", key, "data after its last frame"), "Trailing data should be rejected");
+        TEST_ASSERT(rejected("plain text, not sealed", key, "Not an encrypted output file"), "Other files should be rejected");
+    }
+    
+    void testKernelDispatch() {
+        TEST_GROUP("Kernel Dispatch");
+        
+        // OpenSSL 3.x only has RIPEMD160 in the legacy provider
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        OSSL_PROVIDER_load(nullptr, "legacy");
+        OSSL_PROVIDER_load(nullptr, "default");
+#endif
+        auto digest = [](const EVP_MD* md, const std::vector<uint8_t>& data) {
+            std::vector<uint8_t> out(EVP_MAX_MD_SIZE);
+            unsigned int len = 0;
+            if (!md || EVP_Digest(data.data(), data.size(), out.data(), &len, md, nullptr) != 1) return std::vector<uint8_t>();
+            out.resize(len);
+            return out;
+        };
+        
+        std::vector<std::vector<uint8_t>> inputs;
+        for (size_t len : {0, 1, 3, 20, 32, 33, 55, 56, 63, 64, 65, 119, 120, 135, 136, 137, 200, 300}) {
+            std::vector<uint8_t> data(len);
+            for (size_t i = 0; i < len; i++) data[i] = static_cast<uint8_t>(len * 7 + i * 13);
+            inputs.push_back(data);
+        }
+        
+        // Every subset of this CPU's features must give identical results
+        const uint32_t detected = detectCpuFeatures();
+        for (uint32_t subset = 0; subset <= kCpuAllFeatures; subset++) {
+            if (subset & ~detected) continue;
+            selectKernels(subset);
+            const KernelTable& table = kernels();
+            const std::string label = "[" + cpuFeatureNames(subset) + "] ";
+            TEST_ASSERT(table.features == subset, label + "Table should be bound for the selected features");
+            
+            bool sha256Ok = true, ripemdOk = true, sha3Ok = true;
+            for (const std::vector<uint8_t>& data : inputs) {
+                std::vector<uint8_t> out(32);
+                table.sha256(data.data(), data.size(), out.data());
+                sha256Ok = sha256Ok && out == digest(EVP_sha256(), data);
+                table.sha3_256(data.data(), data.size(), out.data());
+                sha3Ok = sha3Ok && out == digest(EVP_sha3_256(), data);
+                out.resize(20);
+                table.ripemd160(data.data(), data.size(), out.data());
+                std::vector<uint8_t> expected = digest(EVP_ripemd160(), data);
+                ripemdOk = ripemdOk && (expected.empty() || out == expected);
+            }
+            TEST_ASSERT(sha256Ok, label + "SHA-256 should match OpenSSL");
+            TEST_ASSERT(ripemdOk, label + "RIPEMD-160 should match OpenSSL");
+            TEST_ASSERT(sha3Ok, label + "SHA3-256 should match OpenSSL");
+            
+            uint8_t rmd[20];
+            char rmdHex[40];
+            table.ripemd160(reinterpret_cast<const uint8_t*>("abc"), 3, rmd);
+            table.hexEncode(rmd, sizeof(rmd), rmdHex);
+            TEST_ASSERT(std::string(rmdHex, 40) == "8eb208f7e05d987a9b044a8e98c6b087f15a0bfc",
+                        label + "RIPEMD-160 of 'abc' should match the reference vector");
+            
+            const uint8_t key[] = {'k', 'e', 'y'};
+            HmacSha512Key prepared;
+            hmacSha512Prepare(prepared, key, sizeof(key));
+            const uint8_t* data[3] = {inputs[4].data(), inputs[5].data(), inputs[6].data()};
+            const size_t lens[3] = {inputs[4].size(), inputs[5].size(), inputs[6].size()};
+            std::vector<std::vector<uint8_t>> macs(3, std::vector<uint8_t>(64));
+            uint8_t* out[3] = {macs[0].data(), macs[1].data(), macs[2].data()};
+            hmacSha512Siblings(prepared, data, lens, 3, out);
+            bool lanesOk = true;
+            for (int i = 0; i < 3; i++) {
+                uint8_t expected[64];
+                unsigned int len = 0;
+                HMAC(EVP_sha512(), key, sizeof(key), data[i], lens[i], expected, &len);
+                lanesOk = lanesOk && std::equal(expected, expected + 64, macs[i].begin());
+            }
+            TEST_ASSERT(lanesOk, label + "SHA-512 lanes should match OpenSSL HMAC");
+            
+            const uint8_t bytes[] = {0x00, 0x00, 0x01, 0xab, 0xff};
+            char hex[10];
+            table.hexEncode(bytes, sizeof(bytes), hex);
+            TEST_ASSERT(std::string(hex, 10) == "000001abff", label + "Hex encoding should be lowercase, two digits per byte");
+            
+            // Lengths around the 16- and 32-byte vector widths, against a byte-at-a-time encoding
+            bool encodeOk = true, decodeOk = true, mixedCaseOk = true;
+            for (size_t len : {0, 1, 15, 16, 17, 31, 32, 33, 65, 100}) {
+                std::vector<uint8_t> bytes(len);
+                for (size_t i = 0; i < len; i++) bytes[i] = static_cast<uint8_t>(i * 29 + len);
+                std::string expected;
+                for (uint8_t b : bytes) expected += std::string(1, "0123456789abcdef"[b >> 4]) + "0123456789abcdef"[b & 0x0f];
+                std::string encoded(2 * len, '\0');
+                table.hexEncode(bytes.data(), len, &encoded[0]);
+                encodeOk = encodeOk && encoded == expected;
+                std::vector<uint8_t> decoded(len);
+                decodeOk = decodeOk && table.hexDecode(encoded.data(), len, decoded.data()) && decoded == bytes;
+                std::string upper(encoded);
+                for (size_t i = 0; i < upper.size(); i += 3) upper[i] = static_cast<char>(std::toupper(upper[i]));
+                std::fill(decoded.begin(), decoded.end(), 0);
+                mixedCaseOk = mixedCaseOk && table.hexDecode(upper.data(), len, decoded.data()) && decoded == bytes;
+            }
+            TEST_ASSERT(encodeOk, label + "Hex encoding should match at every length");
+            TEST_ASSERT(decodeOk, label + "Hex decoding should invert encoding");
+            TEST_ASSERT(mixedCaseOk, label + "Hex decoding should accept either case");
+            
+            // Characters next to the digit ranges, at every position of a 100-byte input
+            bool rejectOk = true;
+            std::string valid(200, 'a');
+            std::vector<uint8_t> scratch(100);
+            for (char bad : {'/', ':', '@', 'G', '`', 'g', ' ', '\0', '\x80', '\xe1'}) {
+                for (size_t pos = 0; pos < valid.size(); pos += 7) {
+                    std::string text(valid);
+                    text[pos] = bad;
+                    rejectOk = rejectOk && !table.hexDecode(text.data(), 100, scratch.data());
+                }
+            }
+            TEST_ASSERT(rejectOk, label + "Hex decoding should reject non-hex characters anywhere");
+            // The last byte is the most significant: 0xffab010000
+            TEST_ASSERT(table.base58Encode(bytes, sizeof(bytes)) == "11Vr14t4F", label + "Base58 should add a '1' per leading zero byte");
+        }
+        selectKernels(detected);
+        
+        const uint8_t first[] = {0x01, 0x23}, second[] = {0xab, 0xcd};
+        const uint8_t* const column[] = {first, second};
+        char columnHex[8];
+        hexEncodeColumn(column, 2, 2, columnHex);
+        TEST_ASSERT(std::string(columnHex, 8) == "0123abcd", "Column hex should encode each field in turn");
+
+        // 65-byte fields: more than one gather block, with a partial last one
+        std::vector<std::vector<uint8_t>> keys(200, std::vector<uint8_t>(65));
+        std::vector<const uint8_t*> keyFields;
+        std::string expectedHex;
+        for (size_t i = 0; i < keys.size(); i++) {
+            for (size_t j = 0; j < 65; j++) keys[i][j] = static_cast<uint8_t>(i * 7 + j);
+            keyFields.push_back(keys[i].data());
+            char fieldHex[130];
+            kernels().hexEncode(keys[i].data(), 65, fieldHex);
+            expectedHex.append(fieldHex, sizeof(fieldHex));
+        }
+        std::string gatheredHex(keys.size() * 130, '\0');
+        hexEncodeColumn(keyFields.data(), keyFields.size(), 65, &gatheredHex[0]);
+        TEST_ASSERT(gatheredHex == expectedHex, "Column hex should match per-field hex across gather blocks");
+        
+        TEST_ASSERT(parseCpuFeatures("none") == 0, "'none' should select the baseline kernels");
+        TEST_ASSERT(parseCpuFeatures("all") == detected, "'all' should select every detected feature");
+        auto rejected = [](const std::string& list) {
+            try {
+                parseCpuFeatures(list);
+            } catch (const std::runtime_error&) {
+                return true;
+            }
+            return false;
+        };
+        TEST_ASSERT(rejected("avx3"), "Unknown CPU feature names should be rejected");
+        for (uint32_t feature : {kCpuAvx2, kCpuAvx512, kCpuShaNi, kCpuSsse3}) {
+            const std::string name = cpuFeatureNames(feature);
+            if (detected & feature) {
+                TEST_ASSERT(parseCpuFeatures(name) == feature, "Detected feature should parse: " + name);
+            } else {
+                TEST_ASSERT(rejected(name), "Missing feature should be rejected: " + name);
+            }
+        }
+        TEST_ASSERT(kernelReport().find("sha256=") == 0, "Kernel report should list the selected variants");
+    }
+    
+    void testBoundedQueue() {
+        TEST_GROUP("Bounded Queue");
+        
+        BoundedQueue<int> small(3);
+        int value = 1;
+        TEST_ASSERT(small.tryPush(value), "Push into empty queue should succeed");
+        value = 2;
+        small.tryPush(value);
+        value = 3;
+        small.tryPush(value);
+        value = 4;
+        small.tryPush(value);
+        value = 5;
+        TEST_ASSERT(!small.tryPush(value), "Push into full queue should fail");
+        int out = 0;
+        TEST_ASSERT(small.tryPop(out) && out == 1, "Pop should return items in FIFO order");
+        
+        // Several producers and consumers; every item must arrive exactly once
+        const int producers = 3;
+        const int perProducer = 20000;
+        BoundedQueue<int> queue(64);
+        std::atomic<long long> sum(0);
+        std::atomic<int> received(0);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&queue, p]() {
+                for (int i = 1; i <= perProducer; i++) queue.push(p * perProducer + i);
+            });
+        }
+        std::vector<std::thread> consumers;
+        for (int c = 0; c < 2; c++) {
+            consumers.emplace_back([&]() {
+                int item;
+                while (queue.pop(item)) {
+                    sum += item;
+                    received++;
+                }
+            });
+        }
+        for (std::thread& t : threads) t.join();
+        queue.close();
+        for (std::thread& t : consumers) t.join();
+        
+        long long n = static_cast<long long>(producers) * perProducer;
+        TEST_ASSERT(received == n, "Every pushed item should be popped");
+        TEST_ASSERT(sum == n * (n + 1) / 2, "No item should be lost or duplicated");
+    }
+    
+    void testBip39Conversions() {
+        TEST_GROUP("BIP39 Entropy Conversions");
+        
+        // Reference vectors from the BIP39 specification
+        const std::vector<std::pair<std::string, std::string>> vectors = {
+            {"00000000000000000000000000000000",
+             "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about"},
+            {"7f7f7f7f7f7f7f7f7f7f7f7f7f7f7f7f",
+             "legal winner thank year wave sausage worth useful legal winner thank yellow"},
+            {"ffffffffffffffffffffffffffffffff",
+             "zoo zoo zoo zoo zoo zoo zoo zoo zoo zoo zoo wrong"},
+            {"9e885d952ad362caeb4efe34a8e91bd2",
+             "ozone drill grab fiber curtain grace pudding thank cruise elder eight picnic"},
+            {"f585c11aec520db57dd353c69554b21a89b20fb0650966fa0a9d6f74fd989d8f",
+             "void come effort suffer camp survey warrior heavy shoot primary clutch crush open amazing screen "
+             "patrol group space point ten exist slush involve unfold"}
+        };
+        
+        for (const auto& vector : vectors) {
+            std::vector<uint8_t> entropy;
+            for (size_t i = 0; i < vector.first.size(); i += 2) {
+                entropy.push_back(static_cast<uint8_t>(std::stoul(vector.first.substr(i, 2), nullptr, 16)));
+            }
+            std::vector<uint16_t> indices = entropyToIndices(entropy.data(), entropy.size());
+            std::string mnemonic;
+            indicesToMnemonic(indices.data(), indices.size(), mnemonic);
+            TEST_ASSERT(mnemonic == vector.second, "Entropy " + vector.first.substr(0, 8) + "... should give the reference mnemonic");
+            TEST_ASSERT(WalletGenerator::mnemonicFromEntropyHex(vector.first) == vector.second,
+                       "Hex entropy " + vector.first.substr(0, 8) + "... should give the reference mnemonic");
+            
+            std::vector<uint16_t> parsed = mnemonicToIndices(vector.second);
+            TEST_ASSERT(parsed == indices, "Mnemonic should parse back to the same indices");
+            TEST_ASSERT(indicesToEntropy(parsed.data(), parsed.size()) == entropy, "Mnemonic should convert back to its entropy");
+            
+            uint8_t packed[33];
+            uint16_t unpacked[24];
+            packIndices(parsed.data(), parsed.size(), packed);
+            unpackIndices(packed, parsed.size(), unpacked);
+            TEST_ASSERT(std::vector<uint16_t>(unpacked, unpacked + parsed.size()) == parsed, "Packed indices should round-trip");
+        }
+        
+        TEST_ASSERT(packedIndexBytes(12) == 17 && packedIndexBytes(24) == 33, "Packed records should be 17 and 33 bytes");
+        TEST_ASSERT(bip39WordIndex("abandon") == 0 && bip39WordIndex("zoo") == 2047, "Word lookup should cover the whole list");
+        TEST_ASSERT(bip39WordIndex("bitcoin") == -1, "Unknown words should not be found");
+        
+        std::vector<uint16_t> badChecksum = mnemonicToIndices(
+            "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon");
+        TEST_ASSERT(!indicesChecksumValid(badChecksum.data(), badChecksum.size()), "Wrong checksum word should be detected");
+        
+        bool threw = false;
+        try {
+            mnemonicToIndices("abandon abandon abandon");
+        } catch (const std::exception&) {
+            threw = true;
+        }
+        TEST_ASSERT(threw, "Unsupported word counts should be rejected");
+        
+        // Hex seeds (--seed-hex) decode in either case and must be 64 bytes
+        std::vector<uint8_t> seed = generator.mnemonicToSeed(vectors[0].second, "TREZOR");
+        std::string seedHex;
+        for (uint8_t byte : seed) {
+            seedHex += "0123456789ABCDEF"[byte >> 4];
+            seedHex += "0123456789abcdef"[byte & 15];
+        }
+        SecureBytes decoded = WalletGenerator::seedFromHex(seedHex);
+        TEST_ASSERT(std::vector<uint8_t>(decoded.begin(), decoded.end()) == seed, "Hex seeds should decode in either case");
+        auto rejected = [](const std::string& hex, const std::string& message) {
+            try {
+                WalletGenerator::seedFromHex(hex);
+            } catch (const std::runtime_error& e) {
+                return std::string(e.what()).find(message) != std::string::npos;
+            }
+            return false;
+        };
+        TEST_ASSERT(rejected(seedHex.substr(2), "must be 64 bytes"), "Short seeds should be rejected");
+        TEST_ASSERT(rejected(seedHex.substr(1), "even number of hex digits"), "Odd digit counts should be rejected");
+        TEST_ASSERT(rejected("0x" + seedHex.substr(2), "not hex"), "Non-hex digits should be rejected");
+    }
+    
+    void testCApi() {
+        TEST_GROUP("C ABI");
+        
+        TEST_ASSERT(wg_abi_version() == WG_ABI_VERSION, "ABI version should match the header");
+        TEST_ASSERT(wg_network_count() == WalletGenerator::networks.size(), "All networks should be listed");
+        TEST_ASSERT(wg_network_name(wg_network_count()) == nullptr, "Network list should end with NULL");
+        
+        std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        std::vector<uint8_t> expectedSeed = generator.mnemonicToSeed(mnemonic, "TREZOR");
+        uint8_t seed[WG_SEED_SIZE];
+        TEST_ASSERT(wg_mnemonic_to_seed(mnemonic.c_str(), "TREZOR", seed) == WG_OK, "Seed call should succeed");
+        TEST_ASSERT(std::vector<uint8_t>(seed, seed + WG_SEED_SIZE) == expectedSeed, "Seed should match the C++ API");
+        
+        const char* mnemonics[] = {mnemonic.c_str(), mnemonic.c_str(), mnemonic.c_str()};
+        const char* passphrases[] = {"TREZOR", nullptr, "x"};
+        uint8_t seeds[3 * WG_SEED_SIZE];
+        TEST_ASSERT(wg_mnemonic_to_seed_batch(mnemonics, passphrases, 3, seeds) == WG_OK, "Batch seed call should succeed");
+        TEST_ASSERT(std::vector<uint8_t>(seeds, seeds + WG_SEED_SIZE) == expectedSeed, "Batch seed should match single seed");
+        TEST_ASSERT(std::vector<uint8_t>(seeds + WG_SEED_SIZE, seeds + 2 * WG_SEED_SIZE) == generator.mnemonicToSeed(mnemonic),
+                   "NULL passphrase entry should mean no passphrase");
+        
+        // Default paths: same wallets as the C++ API and the CLI
+        wg_wallet wallets[5];
+        TEST_ASSERT(wg_derive_addresses(seed, "ethereum", nullptr, 3, 5, wallets) == WG_OK, "Derive call should succeed");
+        bool allMatch = true;
+        for (uint32_t i = 0; i < 5; i++) {
+            WalletGenerator::WalletInfo expected = generator.generateWallet(expectedSeed, "ethereum", WalletGenerator::indexedPath("ethereum", 3 + i));
+            allMatch = allMatch && expected.address == wallets[i].address && expected.wif == wallets[i].wif &&
+                       expected.derivationPath == wallets[i].path;
+        }
+        TEST_ASSERT(allMatch, "Derived wallets should match generateWallet");
+        
+        TEST_ASSERT(wg_derive_addresses(seed, "bitcoin", "m/84'/0'/*'/0/*", 7, 1, wallets) == WG_OK, "Template call should succeed");
+        TEST_ASSERT(std::string(wallets[0].path) == "m/84'/0'/7'/0/7", "Every '*' should be replaced by the index");
+        wg_wipe(wallets, 5);
+        TEST_ASSERT(wallets[0].address[0] == 0 && wallets[4].private_key[0] == 0, "Wipe should clear wallets");
+        
+        TEST_ASSERT(wg_derive_addresses(seed, "nosuchcoin", nullptr, 0, 1, wallets) == WG_ERR_UNSUPPORTED_NETWORK,
+                   "Unknown network should be reported");
+        TEST_ASSERT(std::string(wg_last_error()).find("nosuchcoin") != std::string::npos, "Last error should describe the failure");
+        TEST_ASSERT(wg_derive_addresses(seed, "bitcoin", nullptr, 0xFFFFFFFF, 2, wallets) == WG_ERR_INVALID_ARGUMENT,
+                   "Index overflow should be rejected");
+        TEST_ASSERT(wg_mnemonic_to_seed(nullptr, nullptr, seed) == WG_ERR_INVALID_ARGUMENT, "NULL mnemonic should be rejected");
+    }
+    
+    void testSecureArena() {
+        TEST_GROUP("Secure Arena");
+        
+        secureArenaReset();
+        SecureBytes a(100, 0xAA);
+        SecureBytes b(1000, 0xBB);
+        TEST_ASSERT(reinterpret_cast<uintptr_t>(a.data()) % 16 == 0, "Blocks should be 16-byte aligned");
+        TEST_ASSERT(secureArenaStats().liveBlocks == 2, "Live blocks should be counted");
+        TEST_ASSERT(!secureArenaReset(), "Reset should report live blocks");
+        TEST_ASSERT(a[99] == 0xAA && b[999] == 0xBB, "Reset should not touch live blocks");
+        SecureBytes().swap(a);
+        SecureBytes().swap(b);
+        TEST_ASSERT(secureArenaReset() && secureArenaStats().usedBytes == 0, "Reset should rewind an empty arena");
+        
+        // Pipeline pattern: one thread allocates, another frees, a bounded
+        // number in flight. Emptied chunks must be reused, not leaked.
+        BoundedQueue<SecureBytes*> handoff(64);
+        SecureArenaStats producerStats;
+        SecureBytes* survivor = nullptr;
+        std::thread producer([&]() {
+            for (int i = 0; i < 20000; i++) {
+                SecureBytes* block = new SecureBytes(64, static_cast<uint8_t>(i));
+                handoff.push(block);
+            }
+            producerStats = secureArenaStats();
+            survivor = new SecureBytes(32, 0x5A);
+            handoff.close();
+        });
+        bool intact = true;
+        int received = 0;
+        SecureBytes* block;
+        while (handoff.pop(block)) {
+            intact = intact && (*block)[0] == static_cast<uint8_t>(received) && (*block)[63] == static_cast<uint8_t>(received);
+            received++;
+            delete block;
+        }
+        producer.join();
+        TEST_ASSERT(received == 20000 && intact, "Blocks should cross threads intact");
+        TEST_ASSERT(producerStats.chunks <= 2, "Emptied chunks should be reused (" + std::to_string(producerStats.chunks) + " chunks)");
+        // The producer has exited; its arena stays alive until this block goes
+        TEST_ASSERT(survivor && (*survivor)[31] == 0x5A, "Blocks should outlive the thread that allocated them");
+        delete survivor;
+    }
+    
+    void testStageStats() {
+        TEST_GROUP("Stage Statistics");
+        
+#if WALLETGEN_STATS
+        auto stage = [](StatStage s) { return statsSnapshot()[static_cast<size_t>(s)]; };
+        std::string mnemonic = "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about";
+        
+        statsEnable(false);
+        StageStats kdfBefore = stage(StatStage::Kdf);
+        std::vector<uint8_t> seed = generator.mnemonicToSeed(mnemonic);
+        TEST_ASSERT(stage(StatStage::Kdf).calls == kdfBefore.calls, "Disabled stats should not record");
+        
+        statsEnable(true);
+        StageStats walletBefore = stage(StatStage::Wallet);
+        StageStats hashBefore = stage(StatStage::Hash);
+        generator.mnemonicToSeed(mnemonic);
+        generator.generateWallet(seed, "bitcoin");
+        generator.generateWallet(seed, "ethereum");
+        TEST_ASSERT(stage(StatStage::Kdf).calls == kdfBefore.calls + 1, "KDF calls should be counted");
+        TEST_ASSERT(stage(StatStage::Kdf).bytes == kdfBefore.bytes + mnemonic.size(), "KDF bytes should be the mnemonic length");
+        TEST_ASSERT(stage(StatStage::Wallet).calls == walletBefore.calls + 2, "Wallet calls should be counted");
+        TEST_ASSERT(stage(StatStage::Wallet).nanoseconds > walletBefore.nanoseconds, "Wallet time should be accumulated");
+        TEST_ASSERT(stage(StatStage::Hash).bytes > hashBefore.bytes, "Hashed bytes should be accumulated");
+        
+        // Counters of finished threads are kept
+        StageStats derivedBefore = stage(StatStage::DeriveKey);
+        std::thread worker([&seed]() {
+            WalletGenerator threadGenerator;
+            for (int i = 0; i < 3; i++) {
+                threadGenerator.generateWallet(seed, "litecoin", WalletGenerator::indexedPath("litecoin", i));
+            }
+        });
+        worker.join();
+        TEST_ASSERT(stage(StatStage::DeriveKey).calls == derivedBefore.calls + 3, "Exited thread counters should be merged");
+        statsEnable(false);
+        
+        std::string table = statsTable(1.0);
+        TEST_ASSERT(table.find("derive_key") != std::string::npos && table.find("% wall") != std::string::npos,
+                   "Table should list recorded stages");
+        std::string metrics = statsPrometheus();
+        TEST_ASSERT(metrics.find("# TYPE walletgen_stage_seconds_total counter") != std::string::npos,
+                   "Prometheus output should declare counter types");
+        TEST_ASSERT(metrics.find("walletgen_stage_calls_total{stage=\"wallet\"} " +
+                                 std::to_string(stage(StatStage::Wallet).calls) + "\n") != std::string::npos,
+                   "Prometheus output should carry the current counts");
+#else
+        TEST_ASSERT(statsSnapshot()[0].calls == 0, "Compiled-out stats should stay empty");
+#endif
+    }
 };
 
 int main() {
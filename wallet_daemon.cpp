@@ -0,0 +1,1091 @@
+#include "wallet_daemon.h"
+#include "crypto_kernels.h"
+#include "wallet_stats.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <openssl/crypto.h>
+
+namespace {
+
+const size_t kMaxLineLength = 64 * 1024;
+const size_t kMaxPendingJobs = 1024;          // per connection; reading pauses beyond this
+const size_t kMaxBufferedOutput = 16 << 20;   // unsent response bytes before reading pauses
+const int kMaxEvents = 64;
+const unsigned int kMaxRings = 64;
+const int kRingPollMs = 100;       // how often an idle ring thread checks for shutdown
+const uint64_t kRingChunk = 256;   // wallets derived per response batch
+const size_t kLatencyWindow = 1024; // recent requests per class behind the latency quantiles
+const char* const kPriorityNames[] = {"interactive", "bulk"};
+
+// NUL-terminated copy into a fixed ring field, truncated to fit
+template <size_t N>
+void copyText(char (&field)[N], std::string_view text) {
+    size_t len = std::min(text.size(), N - 1);
+    std::memcpy(field, text.data(), len);
+    field[len] = '\0';
+}
+
+// A ring text field the client may have left unterminated
+template <size_t N>
+std::string fieldText(const char (&field)[N]) {
+    return std::string(field, strnlen(field, N));
+}
+
+// Minimal JSON reader for flat request objects. Values may be strings,
+// numbers, booleans or null; nested objects and arrays are rejected.
+class JsonObject {
+public:
+    explicit JsonObject(const std::string& text) : src(text), pos(0) {
+        skipSpace();
+        expect('{');
+        skipSpace();
+        if (peek() == '}') {
+            pos++;
+        } else {
+            for (;;) {
+                skipSpace();
+                std::string key = parseString();
+                skipSpace();
+                expect(':');
+                skipSpace();
+                Field field;
+                if (peek() == '"') {
+                    field.isString = true;
+                    field.value = parseString();
+                } else {
+                    field.isString = false;
+                    field.value = parseLiteral();
+                }
+                fields[key] = field;
+                skipSpace();
+                if (peek() == ',') {
+                    pos++;
+                    continue;
+                }
+                expect('}');
+                break;
+            }
+        }
+        skipSpace();
+        if (pos != src.size()) {
+            throw std::runtime_error("Trailing data after JSON object");
+        }
+    }
+
+    bool has(const std::string& key) const {
+        return fields.count(key) != 0;
+    }
+
+    std::string getString(const std::string& key, const std::string& fallback = "") const {
+        auto it = fields.find(key);
+        if (it == fields.end()) return fallback;
+        if (!it->second.isString) {
+            throw std::runtime_error("Field '" + key + "' must be a string");
+        }
+        return it->second.value;
+    }
+
+    uint64_t getUnsigned(const std::string& key, uint64_t fallback) const {
+        auto it = fields.find(key);
+        if (it == fields.end()) return fallback;
+        const std::string& v = it->second.value;
+        if (it->second.isString || v.empty() || v.find_first_not_of("0123456789") != std::string::npos) {
+            throw std::runtime_error("Field '" + key + "' must be a non-negative integer");
+        }
+        return std::stoull(v);
+    }
+
+    // Raw JSON text of a value, suitable for echoing back (e.g. "id").
+    std::string raw(const std::string& key) const {
+        auto it = fields.find(key);
+        if (it == fields.end()) return "";
+        return it->second.isString ? quote(it->second.value) : it->second.value;
+    }
+
+    static std::string quote(const std::string& s) {
+        static const char* hex = "0123456789abcdef";
+        std::string out = "\"";
+        for (unsigned char c : s) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        out += "\\u00";
+                        out += hex[c >> 4];
+                        out += hex[c & 0x0f];
+                    } else {
+                        out += static_cast<char>(c);
+                    }
+            }
+        }
+        out += '"';
+        return out;
+    }
+
+private:
+    struct Field {
+        bool isString;
+        std::string value;
+    };
+
+    const std::string& src;
+    size_t pos;
+    std::map<std::string, Field> fields;
+
+    char peek() const {
+        return pos < src.size() ? src[pos] : '\0';
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            throw std::runtime_error(std::string("Malformed JSON: expected '") + c + "'");
+        }
+        pos++;
+    }
+
+    void skipSpace() {
+        while (pos < src.size() && (src[pos] == ' ' || src[pos] == '\t' || src[pos] == '\r' || src[pos] == '\n')) {
+            pos++;
+        }
+    }
+
+    std::string parseString() {
+        expect('"');
+        std::string out;
+        while (pos < src.size() && src[pos] != '"') {
+            char c = src[pos++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= src.size()) break;
+            char e = src[pos++];
+            switch (e) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    if (pos + 4 > src.size()) throw std::runtime_error("Malformed JSON: bad \\u escape");
+                    unsigned int cp = std::stoul(src.substr(pos, 4), nullptr, 16);
+                    pos += 4;
+                    // UTF-8 encode (BMP only; surrogate pairs are not combined)
+                    if (cp < 0x80) {
+                        out += static_cast<char>(cp);
+                    } else if (cp < 0x800) {
+                        out += static_cast<char>(0xC0 | (cp >> 6));
+                        out += static_cast<char>(0x80 | (cp & 0x3F));
+                    } else {
+                        out += static_cast<char>(0xE0 | (cp >> 12));
+                        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                        out += static_cast<char>(0x80 | (cp & 0x3F));
+                    }
+                    break;
+                }
+                default:
+                    throw std::runtime_error("Malformed JSON: bad escape");
+            }
+        }
+        expect('"');
+        return out;
+    }
+
+    std::string parseLiteral() {
+        size_t start = pos;
+        while (pos < src.size() && src[pos] != ',' && src[pos] != '}' &&
+               src[pos] != ' ' && src[pos] != '\t' && src[pos] != '\r' && src[pos] != '\n') {
+            if (src[pos] == '{' || src[pos] == '[') {
+                throw std::runtime_error("Nested JSON values are not supported");
+            }
+            pos++;
+        }
+        if (start == pos) {
+            throw std::runtime_error("Malformed JSON: missing value");
+        }
+        std::string literal = src.substr(start, pos - start);
+        if (literal != "true" && literal != "false" && literal != "null" && !isNumber(literal)) {
+            throw std::runtime_error("Malformed JSON: bad value '" + literal + "'");
+        }
+        return literal;
+    }
+
+    // JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    static bool isNumber(const std::string& s) {
+        size_t i = 0;
+        auto digits = [&]() {
+            size_t from = i;
+            while (i < s.size() && s[i] >= '0' && s[i] <= '9') i++;
+            return i > from;
+        };
+        if (i < s.size() && s[i] == '-') i++;
+        if (i < s.size() && s[i] == '0') {
+            i++;
+        } else if (!digits()) {
+            return false;
+        }
+        if (i < s.size() && s[i] == '.') {
+            i++;
+            if (!digits()) return false;
+        }
+        if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+            i++;
+            if (i < s.size() && (s[i] == '+' || s[i] == '-')) i++;
+            if (!digits()) return false;
+        }
+        return i == s.size();
+    }
+};
+
+std::string formatSeconds(double seconds) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.6f", seconds);
+    return buffer;
+}
+
+WalletDaemon* activeDaemon = nullptr;
+
+void handleStopSignal(int) {
+    if (activeDaemon) {
+        activeDaemon->stop();
+    }
+}
+
+} // namespace
+
+WalletDaemon::SharedRing::~SharedRing() {
+    for (int fd : {socketFd, requestEvent, responseEvent}) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+WalletDaemon::WalletDaemon(const DaemonOptions& opts)
+    : options(opts), listenFd(-1), epollFd(-1), wakeFd(-1), stopping(false), nextConnectionId(1), activeRings(0) {
+    if (options.socketPath.empty()) {
+        throw std::runtime_error("Socket path required");
+    }
+    if (options.workers == 0) {
+        options.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options.bulkChunk == 0) {
+        throw std::runtime_error("Bulk chunk must be at least 1");
+    }
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (wakeFd < 0 || epollFd < 0) {
+        throw std::runtime_error(std::string("Failed to create epoll/eventfd: ") + strerror(errno));
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0;  // id 0 is the wake fd
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+WalletDaemon::~WalletDaemon() {
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobReady.notify_all();
+    }
+    for (std::thread& t : workerThreads) {
+        if (t.joinable()) t.join();
+    }
+    {
+        std::unique_lock<std::mutex> lock(ringMutex);
+        ringsDone.wait(lock, [this] { return activeRings == 0; });
+    }
+    for (auto& entry : connections) {
+        close(entry.second.fd);
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(options.socketPath.c_str());
+    }
+    if (epollFd >= 0) close(epollFd);
+    if (wakeFd >= 0) close(wakeFd);
+}
+
+void WalletDaemon::stop() {
+    stopping.store(true);
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void WalletDaemon::openSocket() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (options.socketPath.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + options.socketPath);
+    }
+    std::strncpy(addr.sun_path, options.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        throw std::runtime_error(std::string("socket failed: ") + strerror(errno));
+    }
+
+    // Remove a stale socket left behind by a previous run
+    unlink(options.socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listenFd, SOMAXCONN) < 0) {
+        throw std::runtime_error("Failed to listen on " + options.socketPath + ": " + strerror(errno));
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = UINT64_MAX;  // listening socket
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+}
+
+void WalletDaemon::run() {
+    openSocket();
+    statsEnable(true);  // served on GET /metrics
+
+    for (unsigned int i = 0; i < options.workers; i++) {
+        workerThreads.emplace_back(&WalletDaemon::workerLoop, this);
+    }
+
+    std::cerr << "Serving on " << options.socketPath << " with " << options.workers << " worker(s)" << std::endl;
+
+    epoll_event events[kMaxEvents];
+    while (!stopping.load()) {
+        int n = epoll_wait(epollFd, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("epoll_wait failed: ") + strerror(errno));
+        }
+
+        for (int i = 0; i < n; i++) {
+            uint64_t id = events[i].data.u64;
+            if (id == 0) {
+                uint64_t counter;
+                ssize_t ignored = read(wakeFd, &counter, sizeof(counter));
+                (void)ignored;
+                drainCompletions();
+            } else if (id == UINT64_MAX) {
+                acceptConnections();
+            } else {
+                auto it = connections.find(id);
+                if (it != connections.end() && !wantsInput(it->second) &&
+                    (events[i].events & (EPOLLHUP | EPOLLERR))) {
+                    closeConnection(id);  // gone both ways; nothing can be delivered
+                    continue;
+                }
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    readConnection(id);
+                }
+                if (connections.count(id) && (events[i].events & EPOLLOUT)) {
+                    flushConnection(id);
+                }
+            }
+        }
+    }
+}
+
+void WalletDaemon::acceptConnections() {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;  // EAGAIN or transient error
+        }
+
+        uint64_t id = nextConnectionId++;
+        connections[id] = Connection{fd, std::string(), std::string(), false};
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = id;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void WalletDaemon::readConnection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    Connection& conn = it->second;
+
+    auto now = std::chrono::steady_clock::now();
+    std::vector<Job> parsed;
+    char buffer[4096];
+    bool eof = false;
+    // Stop at the backlog limit and leave the rest in the socket; EPOLLIN is
+    // re-armed as responses complete
+    while (conn.pending + parsed.size() < kMaxPendingJobs) {
+        ssize_t n = read(conn.fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0) {
+            closeConnection(id);
+            return;
+        }
+        if (n == 0) {
+            eof = true;
+            break;
+        }
+        conn.in.append(buffer, static_cast<size_t>(n));
+
+        // Take complete lines as they arrive, so only a partial line is held
+        size_t start = 0;
+        size_t newline;
+        while ((newline = conn.in.find('\n', start)) != std::string::npos) {
+            std::string line = conn.in.substr(start, newline - start);
+            start = newline + 1;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            // A scrape or a ring takes over the connection, so only its first line may ask for one
+            bool fresh = conn.requests == 0;
+            if (fresh && line.compare(0, 4, "GET ") == 0) {
+                // Metrics scrape: the headers that follow are irrelevant
+                conn.out += httpReply(line);
+                conn.closeAfterFlush = true;
+                conn.in.clear();
+                flushConnection(id);
+                return;
+            }
+            if (fresh && line.find("\"ring\"") != std::string::npos && attachRing(id, line)) {
+                return;
+            }
+            conn.requests++;
+            Job job;
+            job.connectionId = id;
+            job.received = now;
+            if (line.compare(0, 4, "GET ") == 0) {
+                job.request.error = "Metrics are only served on a fresh connection";
+            } else {
+                job.request = parseRequest(line);
+            }
+            parsed.push_back(std::move(job));
+        }
+        conn.in.erase(0, start);
+
+        if (conn.in.size() > kMaxLineLength) {
+            closeConnection(id);
+            return;
+        }
+    }
+
+    if (!parsed.empty()) {
+        conn.pending += parsed.size();
+        std::lock_guard<std::mutex> lock(jobMutex);
+        for (Job& job : parsed) {
+            jobs[static_cast<size_t>(job.request.priority)].push_back(std::move(job));
+        }
+        jobReady.notify_all();
+    }
+
+    if (eof) {
+        // Half-close: answer what was sent, then close once it is written
+        conn.readClosed = true;
+        conn.in.clear();
+    }
+    flushConnection(id);
+}
+
+void WalletDaemon::flushConnection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    Connection& conn = it->second;
+
+    WG_STAT_SCOPE(StatStage::Output, conn.out.size());
+    while (!conn.out.empty()) {
+        ssize_t n = send(conn.fd, conn.out.data(), conn.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.out.erase(0, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closeConnection(id);
+        return;
+    }
+    if (conn.out.empty() && (conn.closeAfterFlush || (conn.readClosed && conn.pending == 0))) {
+        closeConnection(id);
+        return;
+    }
+    updateInterest(id);
+}
+
+void WalletDaemon::updateInterest(uint64_t id) {
+    Connection& conn = connections.at(id);
+    epoll_event ev{};
+    if (wantsInput(conn)) ev.events |= EPOLLIN;
+    if (!conn.out.empty()) ev.events |= EPOLLOUT;
+    ev.data.u64 = id;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+bool WalletDaemon::wantsInput(const Connection& conn) {
+    return !conn.readClosed && conn.pending < kMaxPendingJobs && conn.out.size() < kMaxBufferedOutput;
+}
+
+void WalletDaemon::closeConnection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    connections.erase(it);
+}
+
+std::string WalletDaemon::httpReply(const std::string& requestLine) {
+    size_t pathEnd = requestLine.find(' ', 4);
+    std::string path = requestLine.substr(4, pathEnd == std::string::npos ? std::string::npos : pathEnd - 4);
+
+    std::string status = "200 OK";
+    std::string body;
+    if (path == "/metrics") {
+        body = statsPrometheus() + schedulerMetrics();
+    } else {
+        status = "404 Not Found";
+        body = "Not found; metrics are served on /metrics\n";
+    }
+    return "HTTP/1.0 " + status + "\r\n"
+           "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+           "Connection: close\r\n\r\n" + body;
+}
+
+bool WalletDaemon::attachRing(uint64_t id, const std::string& line) {
+    try {
+        if (JsonObject(line).getString("op") != "ring") return false;
+    } catch (const std::exception&) {
+        return false;  // the workers report malformed lines
+    }
+
+    Connection& conn = connections.at(id);
+    std::unique_ptr<SharedRing> ring;
+    try {
+        JsonObject json(line);
+        uint64_t slots = json.getUnsigned("slots", kRingDefaultSlots);
+        if (slots > kRingMaxSlots) throw std::runtime_error("Ring slots must be at most " + std::to_string(kRingMaxSlots));
+        {
+            std::lock_guard<std::mutex> lock(ringMutex);
+            if (activeRings >= kMaxRings) throw std::runtime_error("Too many rings");
+        }
+        ring.reset(new SharedRing(RingMapping::create(static_cast<uint32_t>(slots))));
+        ring->requestEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ring->responseEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (ring->requestEvent < 0 || ring->responseEvent < 0) {
+            throw std::runtime_error(std::string("Failed to create ring eventfds: ") + strerror(errno));
+        }
+        const int fds[3] = {ring->mapping.fd(), ring->requestEvent, ring->responseEvent};
+        if (!sendRingDescriptors(conn.fd, "{\"ok\":true,\"slots\":" + std::to_string(slots) + "}\n", fds)) {
+            closeConnection(id);
+            return true;
+        }
+    } catch (const std::exception& e) {
+        conn.out += "{\"ok\":false,\"error\":" + JsonObject::quote(e.what()) + "}\n";
+        conn.closeAfterFlush = true;
+        conn.in.clear();
+        flushConnection(id);
+        return true;
+    }
+
+    // The socket now belongs to the ring thread
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, conn.fd, nullptr);
+    ring->socketFd = conn.fd;
+    connections.erase(id);
+    {
+        std::lock_guard<std::mutex> lock(ringMutex);
+        activeRings++;
+    }
+    std::thread(&WalletDaemon::ringLoop, this, std::move(ring)).detach();
+    return true;
+}
+
+void WalletDaemon::drainCompletions() {
+    std::vector<Completion> ready;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        ready.swap(completions);
+    }
+
+    for (Completion& c : ready) {
+        auto it = connections.find(c.connectionId);
+        if (it == connections.end()) continue;  // client went away
+        it->second.pending--;
+        it->second.out += c.response;
+        flushConnection(c.connectionId);
+    }
+}
+
+std::string WalletDaemon::schedulerMetrics() {
+    const size_t classes = static_cast<size_t>(Priority::Count);
+    size_t depth[classes];
+    ClassStats stats[classes];
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        for (size_t c = 0; c < classes; c++) {
+            depth[c] = jobs[c].size();
+            stats[c] = classStats[c];
+        }
+    }
+
+    std::string out;
+    out += "# HELP walletgen_daemon_queue_depth Requests waiting in each priority class.\n";
+    out += "# TYPE walletgen_daemon_queue_depth gauge\n";
+    for (size_t c = 0; c < classes; c++) {
+        out += std::string("walletgen_daemon_queue_depth{class=\"") + kPriorityNames[c] + "\"} " +
+               std::to_string(depth[c]) + "\n";
+    }
+
+    out += "# HELP walletgen_daemon_request_seconds Latency of each priority class; quantiles cover its recent requests.\n";
+    out += "# TYPE walletgen_daemon_request_seconds summary\n";
+    for (size_t c = 0; c < classes; c++) {
+        std::vector<double>& recent = stats[c].recent;
+        std::sort(recent.begin(), recent.end());
+        std::string label = std::string("class=\"") + kPriorityNames[c] + "\"";
+        for (const char* quantile : {"0.5", "0.9", "0.99"}) {
+            std::string value = "NaN";
+            if (!recent.empty()) {
+                size_t rank = static_cast<size_t>(std::atof(quantile) * recent.size());
+                value = formatSeconds(recent[std::min(recent.size() - 1, rank)]);
+            }
+            out += "walletgen_daemon_request_seconds{" + label + ",quantile=\"" + quantile + "\"} " + value + "\n";
+        }
+        out += "walletgen_daemon_request_seconds_sum{" + label + "} " + formatSeconds(stats[c].seconds) + "\n";
+        out += "walletgen_daemon_request_seconds_count{" + label + "} " + std::to_string(stats[c].completed) + "\n";
+    }
+    return out;
+}
+
+void WalletDaemon::workerLoop() {
+    // Each worker keeps its own warm generator for the lifetime of the daemon
+    WalletGenerator generator;
+    const size_t laneGroup = kSha512Lanes;
+    const auto window = std::chrono::microseconds(options.batchWindowUs);
+    std::deque<Job>& interactive = jobs[static_cast<size_t>(Priority::Interactive)];
+    std::deque<Job>& bulk = jobs[static_cast<size_t>(Priority::Bulk)];
+
+    for (;;) {
+        std::vector<Job> batch;
+        bool bulkTurn;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [&] { return stopping.load() || !interactive.empty() || !bulk.empty(); });
+
+            // Coalesce: hold the oldest interactive job until the lane group
+            // fills or its deadline passes, so concurrent requests share one
+            // KDF pass
+            if (!interactive.empty()) {
+                auto deadline = interactive.front().received + window;
+                while (!stopping.load() && !interactive.empty() && interactive.size() < laneGroup &&
+                       std::chrono::steady_clock::now() < deadline) {
+                    jobReady.wait_until(lock, deadline);
+                }
+            }
+            if (stopping.load()) return;
+
+            // Jobs still waiting for a seed are grouped for the KDF pass; a
+            // started bulk job is taken alone
+            bulkTurn = interactive.empty();
+            std::deque<Job>& queue = bulkTurn ? bulk : interactive;
+            while (!queue.empty() && batch.size() < laneGroup &&
+                   (batch.empty() || (!batch.front().started && !queue.front().started))) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+        if (batch.empty()) continue;  // another worker took them
+
+        std::vector<Request> fresh;
+        for (Job& job : batch) {
+            if (!job.started) fresh.push_back(std::move(job.request));
+        }
+        if (!fresh.empty()) {
+            deriveSeeds(generator, fresh);
+            size_t k = 0;
+            for (Job& job : batch) {
+                if (job.started) continue;
+                job.request = std::move(fresh[k++]);
+                job.started = true;
+                job.batch = batch.size();
+            }
+        }
+
+        // A bulk turn runs one chunk of one job; the rest of its lane group
+        // goes back to the front of the bulk queue, seeds and all
+        size_t turns = bulkTurn ? 1 : batch.size();
+        std::vector<Completion> done;
+        std::vector<Job> requeue;
+        std::vector<std::pair<Priority, double>> latencies;
+        for (size_t i = 0; i < turns; i++) {
+            Job& job = batch[i];
+            if (!runJob(generator, job)) {
+                requeue.push_back(std::move(job));
+                continue;
+            }
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - job.received);
+            latencies.emplace_back(job.request.priority, latency.count() / 1e6);
+            // bodies are objects without their closing brace; append latency last
+            done.push_back(Completion{job.connectionId,
+                                      job.body + ",\"priority\":\"" +
+                                      kPriorityNames[static_cast<size_t>(job.request.priority)] +
+                                      "\",\"batch\":" + std::to_string(job.batch) +
+                                      ",\"latency_us\":" + std::to_string(latency.count()) + "}\n"});
+        }
+        batch.erase(batch.begin(), batch.begin() + static_cast<std::ptrdiff_t>(turns));
+        secureArenaReset();  // finished jobs' seeds and keys are gone by now
+
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+                bulk.push_front(std::move(*it));
+            }
+            for (Job& job : requeue) {
+                bulk.push_back(std::move(job));
+            }
+            for (const auto& entry : latencies) {
+                ClassStats& stats = classStats[static_cast<size_t>(entry.first)];
+                stats.completed++;
+                stats.seconds += entry.second;
+                if (stats.recent.size() < kLatencyWindow) {
+                    stats.recent.push_back(entry.second);
+                } else {
+                    stats.recent[stats.next] = entry.second;
+                }
+                stats.next = (stats.next + 1) % kLatencyWindow;
+            }
+            if (!batch.empty() || !requeue.empty()) jobReady.notify_all();
+        }
+
+        if (done.empty()) continue;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            for (Completion& c : done) {
+                completions.push_back(std::move(c));
+            }
+        }
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+bool WalletDaemon::runJob(WalletGenerator& generator, Job& job) {
+    const Request& request = job.request;
+    try {
+        if (!request.error.empty()) {
+            throw std::runtime_error(request.error);
+        }
+
+        if (request.op == "ping") {
+            job.body = "{" + request.idField + "\"ok\":true";
+            return true;
+        }
+
+        if (request.op == "seed") {
+            static const char* hex = "0123456789abcdef";
+            std::string seedHex;
+            for (uint8_t b : request.seed) {
+                seedHex += hex[b >> 4];
+                seedHex += hex[b & 0x0f];
+            }
+            job.body = "{" + request.idField + "\"ok\":true,\"seed\":\"" + seedHex + "\"";
+            return true;
+        }
+
+        if (job.done == 0) {
+            job.body = "{" + request.idField + "\"ok\":true,\"wallets\":[";
+        }
+        uint64_t end = std::min(request.count, job.done + options.bulkChunk);
+        std::vector<std::string> paths;
+        paths.reserve(end - job.done);
+        for (uint64_t i = job.done; i < end; i++) {
+            uint32_t index = static_cast<uint32_t>(request.start + i);
+            paths.push_back(request.path.empty() ? WalletGenerator::indexedPath(request.network, index) : request.path);
+        }
+        std::vector<WalletGenerator::WalletInfo> wallets = generator.generateWallets(request.seed, request.network, paths);
+
+        for (size_t i = 0; i < wallets.size(); i++) {
+            const WalletGenerator::WalletInfo& wallet = wallets[i];
+            if (job.done + i > 0) job.body += ",";
+            job.body += "{\"network\":" + JsonObject::quote(wallet.network) +
+                        ",\"path\":" + JsonObject::quote(wallet.derivationPath) + ",\"private_key\":\"";
+            job.body += wallet.privateKey;
+            job.body += "\",\"public_key\":\"" + wallet.publicKey + "\",\"wif\":\"";
+            job.body += wallet.wif;
+            job.body += "\",\"address\":\"" + wallet.address + "\"}";
+        }
+        job.done = end;
+        if (job.done < request.count) return false;
+        job.body += "]";
+        return true;
+    } catch (const std::exception& e) {
+        // Wallets of earlier chunks are dropped with the rest of the body
+        job.body = "{" + request.idField + "\"ok\":false,\"error\":" + JsonObject::quote(e.what());
+        return true;
+    }
+}
+
+void WalletDaemon::deriveSeeds(WalletGenerator& generator, std::vector<Request>& requests) {
+    std::vector<std::string> mnemonics, passphrases;
+    std::vector<size_t> owners;
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requests[i].error.empty() && requests[i].op != "ping") {
+            mnemonics.push_back(requests[i].mnemonic);
+            passphrases.push_back(requests[i].passphrase);
+            owners.push_back(i);
+        }
+    }
+    if (!mnemonics.empty()) {
+        std::vector<SecureBytes> seeds = generator.mnemonicToSecureSeedBatch(mnemonics, passphrases);
+        for (size_t k = 0; k < owners.size(); k++) {
+            requests[owners[k]].seed = std::move(seeds[k]);
+            Request& request = requests[owners[k]];
+            // The phrase is not needed once the seed exists
+            OPENSSL_cleanse(&mnemonics[k][0], mnemonics[k].size());
+            OPENSSL_cleanse(&passphrases[k][0], passphrases[k].size());
+            OPENSSL_cleanse(&request.mnemonic[0], request.mnemonic.size());
+            OPENSSL_cleanse(&request.passphrase[0], request.passphrase.size());
+        }
+    }
+}
+
+WalletDaemon::Request WalletDaemon::parseRequest(const std::string& line) {
+    Request request;
+    try {
+        JsonObject json(line);
+        if (json.has("id")) {
+            request.idField = "\"id\":" + json.raw("id") + ",";
+        }
+
+        request.op = json.getString("op", "generate");
+        if (request.op != "ping" && request.op != "seed" && request.op != "generate") {
+            throw std::runtime_error(request.op == "ring" ? "A ring can only be requested on a fresh connection"
+                                                          : "Unknown op: " + request.op);
+        }
+        std::string priority = json.getString("priority", "interactive");
+        if (priority == "bulk") {
+            request.priority = Priority::Bulk;
+        } else if (priority != "interactive") {
+            throw std::runtime_error("Unknown priority: " + priority);
+        }
+        if (request.op == "ping") {
+            return request;
+        }
+
+        request.mnemonic = json.getString("mnemonic");
+        request.passphrase = json.getString("passphrase");
+        request.network = json.getString("network", "bitcoin");
+        request.path = json.getString("path");
+        request.start = json.getUnsigned("start", 0);
+        request.count = json.getUnsigned("count", 1);
+        checkRequest(request);
+        if (request.op == "generate" && request.count > options.bulkChunk) {
+            request.priority = Priority::Bulk;
+        }
+    } catch (const std::exception& e) {
+        request.error = e.what();
+    }
+    return request;
+}
+
+void WalletDaemon::checkRequest(const Request& request) const {
+    if (request.mnemonic.empty()) {
+        throw std::runtime_error("Mnemonic phrase required");
+    }
+    if (request.count == 0 || request.count > options.maxCount) {
+        throw std::runtime_error("Invalid count");
+    }
+    // Written so that it cannot overflow: count is at most maxCount here
+    if (request.start > UINT32_MAX - request.count) {
+        throw std::runtime_error("Invalid start: indices must stay below 2^32 - 1");
+    }
+    if (WalletGenerator::networks.count(request.network) == 0) {
+        throw std::runtime_error("Unsupported network: " + request.network);
+    }
+}
+
+WalletDaemon::Request WalletDaemon::ringRequest(const RingRequest& slot) {
+    Request request;
+    try {
+        switch (slot.op) {
+            case RingOp::Ping: request.op = "ping"; return request;
+            case RingOp::Seed: request.op = "seed"; break;
+            case RingOp::Generate: request.op = "generate"; break;
+            default: throw std::runtime_error("Unknown op: " + std::to_string(static_cast<int>(slot.op)));
+        }
+        request.mnemonic = fieldText(slot.mnemonic);
+        request.passphrase = fieldText(slot.passphrase);
+        request.network = fieldText(slot.network);
+        if (request.network.empty()) request.network = "bitcoin";
+        request.path = fieldText(slot.path);
+        request.start = slot.start;
+        request.count = request.op == "generate" ? slot.count : 1;
+        checkRequest(request);
+    } catch (const std::exception& e) {
+        request.error = e.what();
+    }
+    return request;
+}
+
+void WalletDaemon::ringLoop(std::unique_ptr<SharedRing> ring) {
+    WalletGenerator generator;
+    RingMapping& mapping = ring->mapping;
+    RingHeader& header = mapping.header();
+    const uint64_t slots = mapping.slots();
+    // Our own indices are kept here; the shared copies are only written
+    uint64_t requestTail = 0;
+    uint64_t responseHead = 0;
+
+    // Sleeps until the client signals; false once the ring should close
+    auto wait = [&]() {
+        pollfd fds[2] = {{ring->requestEvent, POLLIN, 0}, {ring->socketFd, POLLIN, 0}};
+        int n = poll(fds, 2, kRingPollMs);
+        return !stopping.load() && !(n > 0 && fds[1].revents);  // hangup, or data the protocol does not allow
+    };
+    auto publish = [&]() {
+        header.responseHead.store(responseHead, std::memory_order_release);
+        ringSignal(ring->responseEvent);
+    };
+    // A cleared response slot, once the client has released one; nullptr
+    // once the ring should close
+    auto nextResponse = [&]() -> RingResponse* {
+        for (;;) {
+            uint64_t tail = header.responseTail.load(std::memory_order_acquire);
+            if (responseHead - tail > slots) return nullptr;  // not an index we handed out
+            if (responseHead - tail < slots) {
+                RingResponse* response = &mapping.response(responseHead++);
+                std::memset(response, 0, sizeof(*response));
+                return response;
+            }
+            publish();
+            ringReset(ring->requestEvent);
+            if (header.responseTail.load(std::memory_order_acquire) == tail && !wait()) return nullptr;
+        }
+    };
+
+    bool open = true;
+    while (open && !stopping.load()) {
+        ringReset(ring->requestEvent);
+        uint64_t head = header.requestHead.load(std::memory_order_acquire);
+        if (head - requestTail > slots) break;
+        if (head == requestTail) {
+            open = wait();
+            continue;
+        }
+
+        // Copy out before checking, so the client cannot change a request
+        // under us, and wipe the slot
+        std::vector<Request> requests;
+        std::vector<uint64_t> ids;
+        while (requestTail != head && requests.size() < kSha512Lanes) {
+            RingRequest& slot = mapping.request(requestTail++);
+            RingRequest copy;
+            std::memcpy(&copy, &slot, sizeof(copy));
+            OPENSSL_cleanse(&slot, sizeof(slot));
+            ids.push_back(copy.id);
+            requests.push_back(ringRequest(copy));
+            OPENSSL_cleanse(&copy, sizeof(copy));
+        }
+        header.requestTail.store(requestTail, std::memory_order_release);
+        deriveSeeds(generator, requests);
+
+        for (size_t i = 0; open && i < requests.size(); i++) {
+            const Request& request = requests[i];
+            std::string error = request.error;
+            if (error.empty() && request.op == "generate") {
+                try {
+                    for (uint64_t done = 0; open && done < request.count; done += kRingChunk) {
+                        std::vector<std::string> paths;
+                        for (uint64_t k = done; k < std::min(request.count, done + kRingChunk); k++) {
+                            uint32_t index = static_cast<uint32_t>(request.start + k);
+                            paths.push_back(request.path.empty() ? WalletGenerator::indexedPath(request.network, index)
+                                                                 : request.path);
+                        }
+                        std::vector<WalletGenerator::KeyPair> keys = generator.deriveKeyPairs(request.seed, request.network, paths);
+                        std::vector<WalletGenerator::WalletInfo> wallets = generator.encodeWallets(keys);
+                        for (size_t k = 0; open && k < wallets.size(); k++) {
+                            RingResponse* response = nextResponse();
+                            if (!response) {
+                                open = false;
+                                break;
+                            }
+                            response->id = ids[i];
+                            response->index = static_cast<uint32_t>(done + k);
+                            response->ok = 1;
+                            response->last = done + k + 1 == request.count;
+                            std::memcpy(response->privateKey, keys[k].privateKey.data(), sizeof(response->privateKey));
+                            std::memcpy(response->publicKey, keys[k].publicKey.data(), sizeof(response->publicKey));
+                            copyText(response->address, wallets[k].address);
+                            copyText(response->wif, wallets[k].wif);
+                            copyText(response->path, wallets[k].derivationPath);
+                        }
+                        publish();
+                    }
+                    continue;
+                } catch (const std::exception& e) {
+                    error = e.what();  // answered below; the request's earlier wallets stand
+                }
+            }
+
+            RingResponse* response = nextResponse();
+            if (!response) {
+                open = false;
+                break;
+            }
+            response->id = ids[i];
+            response->ok = error.empty();
+            response->last = 1;
+            if (!error.empty()) {
+                copyText(response->error, error);
+            } else if (request.op == "seed") {
+                std::memcpy(response->seed, request.seed.data(), sizeof(response->seed));
+            }
+        }
+        publish();
+        requests.clear();
+        secureArenaReset();
+    }
+
+    ring.reset();
+    std::unique_lock<std::mutex> lock(ringMutex);
+    activeRings--;
+    std::notify_all_at_thread_exit(ringsDone, std::move(lock));
+}
+
+int runDaemon(const DaemonOptions& options) {
+    try {
+        WalletDaemon daemon(options);
+        activeDaemon = &daemon;
+
+        struct sigaction sa{};
+        sa.sa_handler = handleStopSignal;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+        signal(SIGPIPE, SIG_IGN);
+
+        daemon.run();
+        activeDaemon = nullptr;
+    } catch (const std::exception& e) {
+        activeDaemon = nullptr;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
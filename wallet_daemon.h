@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "shm_ring.h"
+#include "wallet_generator.h"
+
+/**
+ * Long-lived generator service (--serve).
+ *
+ * Listens on a Unix domain socket and speaks newline-delimited JSON: one
+ * request object per line, one response object per line. A single epoll
+ * thread owns all sockets; a fixed pool of workers, each holding a warm
+ * WalletGenerator, does the cryptographic work. Responses carry the request
+ * "id" (if any) and may arrive out of order on a pipelined connection.
+ *
+ * Requests:
+ *   {"op":"ping"}
+ *   {"op":"seed","mnemonic":"...","passphrase":"..."}
+ *   {"op":"generate","mnemonic":"...","passphrase":"...","network":"bitcoin",
+ *    "path":"m/...","start":0,"count":1}
+ * Any of them may add "priority":"bulk" (see below).
+ *
+ * Every response has "ok", "priority" and "latency_us" (time from the
+ * request line being read to the response being queued for writing).
+ *
+ * Requests are queued in two priority classes. A generate request for more
+ * than bulkChunk wallets, or one marked "priority":"bulk", is bulk; the rest
+ * are interactive. Workers take interactive requests first, and derive at
+ * most bulkChunk wallets of a request before going back to the queues: an
+ * unfinished bulk request rejoins the back of the bulk queue with its seed
+ * and output so far. An interactive request therefore waits for at most one
+ * chunk per worker, however large the bulk backlog. /metrics reports each
+ * class's queue depth and latency quantiles over its recent requests.
+ *
+ * Workers coalesce concurrent interactive requests: a request waits up to
+ * batchWindowUs for others to fill a SHA-512 lane group, then the whole group
+ * runs through one multi-lane PBKDF2 pass. "batch" in the response reports
+ * the group size.
+ *
+ * A connection whose first line is an HTTP request ("GET /metrics HTTP/1.1")
+ * gets the per-stage counters in Prometheus text format instead, answered
+ * directly on the epoll thread, and is closed once the reply is written.
+ *
+ * A connection whose first line is {"op":"ring","slots":N} becomes a
+ * shared-memory ring (shm_ring.h) served by a thread of its own, for
+ * clients on the same host that need more than JSON round trips carry.
+ */
+
+struct DaemonOptions {
+    std::string socketPath;
+    unsigned int workers = 0;       // 0 = hardware concurrency
+    unsigned int maxCount = 100000; // upper bound on "count" per request
+    unsigned int batchWindowUs = 200; // how long a request may wait for lane-mates
+    unsigned int bulkChunk = 256;     // wallets derived per turn before yielding
+};
+
+class WalletDaemon {
+public:
+    explicit WalletDaemon(const DaemonOptions& options);
+    ~WalletDaemon();
+
+    WalletDaemon(const WalletDaemon&) = delete;
+    WalletDaemon& operator=(const WalletDaemon&) = delete;
+
+    // Binds the socket and serves until stop() is called.
+    void run();
+
+    // Thread-safe and async-signal-safe.
+    void stop();
+
+private:
+    struct Connection {
+        int fd;
+        std::string in;
+        std::string out;
+        bool closeAfterFlush;  // HTTP scrape: one reply, then close
+        bool readClosed = false;  // client half-closed; close once answered
+        size_t pending = 0;       // jobs queued and not yet completed
+        uint64_t requests = 0;    // request lines taken so far
+    };
+
+    enum class Priority { Interactive, Bulk, Count };
+
+    struct Request {
+        std::string idField;  // "\"id\":<raw>," or empty
+        std::string op;
+        std::string mnemonic;
+        std::string passphrase;
+        std::string network;
+        std::string path;
+        uint64_t start = 0;
+        uint64_t count = 1;
+        std::string error;    // set when the request line was rejected
+        Priority priority = Priority::Interactive;
+        SecureBytes seed;
+    };
+
+    // A request and, once started, its progress
+    struct Job {
+        uint64_t connectionId;
+        std::chrono::steady_clock::time_point received;
+        Request request;
+        bool started = false;  // seed derived, body begun
+        uint64_t done = 0;     // wallets derived so far
+        size_t batch = 0;      // size of the lane group its seed came from
+        std::string body;      // response so far, without its closing parts
+    };
+
+    // Latencies of the recent requests of one class
+    struct ClassStats {
+        uint64_t completed = 0;
+        double seconds = 0;
+        std::vector<double> recent;  // ring of the last kLatencyWindow
+        size_t next = 0;
+    };
+
+    struct Completion {
+        uint64_t connectionId;
+        std::string response;
+    };
+
+    struct SharedRing {
+        int socketFd = -1;  // watched for the client going away
+        int requestEvent = -1;
+        int responseEvent = -1;
+        RingMapping mapping;
+
+        explicit SharedRing(RingMapping mapping) : mapping(std::move(mapping)) {}
+        ~SharedRing();
+    };
+
+    DaemonOptions options;
+    int listenFd;
+    int epollFd;
+    int wakeFd;  // eventfd: completions ready or stop requested
+    std::atomic<bool> stopping;
+
+    std::map<uint64_t, Connection> connections;
+    uint64_t nextConnectionId;
+
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs[static_cast<size_t>(Priority::Count)];
+    ClassStats classStats[static_cast<size_t>(Priority::Count)];
+
+    std::mutex completionMutex;
+    std::vector<Completion> completions;
+
+    std::vector<std::thread> workerThreads;
+
+    // Ring threads are detached; the destructor waits for the count to drop
+    std::mutex ringMutex;
+    std::condition_variable ringsDone;
+    unsigned int activeRings;
+
+    void openSocket();
+    void acceptConnections();
+    void readConnection(uint64_t id);
+    void flushConnection(uint64_t id);
+    void closeConnection(uint64_t id);
+    void drainCompletions();
+    void updateInterest(uint64_t id);
+    // False while the connection's backlog is full or it has half-closed
+    static bool wantsInput(const Connection& conn);
+    std::string httpReply(const std::string& requestLine);
+    std::string schedulerMetrics();
+    // False if the line is not a ring request after all
+    bool attachRing(uint64_t id, const std::string& line);
+
+    void workerLoop();
+    // Derives the next chunk of a job; true once its body is complete
+    bool runJob(WalletGenerator& generator, Job& job);
+    Request parseRequest(const std::string& line);
+    void checkRequest(const Request& request) const;
+    // One multi-lane PBKDF2 pass for every request that needs a seed
+    void deriveSeeds(WalletGenerator& generator, std::vector<Request>& requests);
+
+    void ringLoop(std::unique_ptr<SharedRing> ring);
+    Request ringRequest(const RingRequest& slot);
+};
+
+// Installs SIGINT/SIGTERM handlers that stop the daemon, then runs it.
+int runDaemon(const DaemonOptions& options);
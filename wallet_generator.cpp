@@ -1,13 +1,130 @@
 #include "wallet_generator.h"
+#include "wallet_daemon.h"
+#include "bulk_pipeline.h"
+#include "index_sweep.h"
+#include "address_index.h"
+#include "wallet_stats.h"
+#include "crypto_kernels.h"
+#include "cpu_features.h"
+#include "ec_backend.h"
+#include "seed_cache.h"
+#include "key_file.h"
+#include "encrypted_output.h"
+#include <chrono>
+#include <climits>
+#include <fstream>
 #include <getopt.h>
+#include <memory>
 
-int main(int argc, char* argv[]) {
+// Wallets derived and printed per step of a single-mnemonic run: enough to
+// fill the sibling SHA-512 lanes, while memory stays flat for any -c
+static const int kPrintChunk = 256;
+
+// Numeric option values: digits only and at most max. std::stoul would
+// throw on text and wrap "-1" to a huge value.
+static bool parseUnsigned(const std::string& text, uint64_t max, uint64_t& value) {
+    if (text.empty() || text.size() > 19 || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    value = std::stoull(text);
+    return value <= max;
+}
+
+static int invalidValue(const char* option) {
+    std::cerr << "Error: invalid value for --" << option << std::endl;
+    return 1;
+}
+
+// Long-only options
+enum {
+    OPT_SERVE = 1000,
+    OPT_THREADS,
+    OPT_BATCH_WINDOW,
+    OPT_BULK_CHUNK,
+    OPT_INPUT,
+    OPT_FORMAT,
+    OPT_STAGE_THREADS,
+    OPT_PACK,
+    OPT_PACK_ENCODING,
+    OPT_UNPACK,
+    OPT_STATS,
+    OPT_CPU_FEATURES,
+    OPT_EC_BACKEND,
+    OPT_EC_TABLE,
+    OPT_VERSION,
+    OPT_START,
+    OPT_END,
+    OPT_SHARD,
+    OPT_SHARD_MODE,
+    OPT_MERGE,
+    OPT_CHECKPOINT,
+    OPT_CHECKPOINT_INTERVAL,
+    OPT_RESUME,
+    OPT_INDEX_BUILD,
+    OPT_LOOKUP,
+    OPT_SEED_CACHE,
+    OPT_SEED_CACHE_KEY,
+    OPT_SEED_HEX,
+    OPT_ENTROPY_HEX,
+    OPT_INPUT_TYPE,
+    OPT_GENERATE,
+    OPT_WORDS,
+    OPT_BIP85,
+    OPT_ENCRYPT_KEY,
+    OPT_DECRYPT
+};
+
+// With --encrypt-key, std::cout writes through an EncryptedOutput into the
+// -o file or the real stdout; main() seals the last frame after every mode
+struct EncryptedStdout {
+    std::ofstream file;
+    std::unique_ptr<EncryptedOutput> sink;
+    std::streambuf* original = nullptr;
+};
+
+static int run(int argc, char* argv[], EncryptedStdout& encrypted) {
     std::string network = "bitcoin";
     int count = 1;
     std::string customPath = "";
     std::string passphrase = "";
     bool allNetworks = false;
     bool verbose = false;
+    std::string servePath = "";
+    unsigned int threads = 0;
+    unsigned int batchWindowUs = 200;
+    unsigned int bulkChunk = 256;
+    std::string inputPath = "";
+    std::string outputPath = "";
+    std::string format = "text";
+    std::string stageThreads = "";
+    std::string packPath = "";
+    std::string packEncoding = "indices";
+    std::string unpackPath = "";
+    bool showStats = false;
+    std::string cpuFeatures = "";
+    std::string ecBackendName = "";
+    std::string ecTablePath = "";
+    bool showVersion = false;
+    uint64_t startIndex = 0;
+    uint64_t endIndex = 0;
+    bool endSet = false;
+    std::string shardSpec = "";
+    std::string shardMode = "contiguous";
+    bool sweep = false;
+    bool merge = false;
+    std::string checkpointPath = "";
+    unsigned int checkpointSeconds = 30;
+    bool resume = false;
+    std::string indexBuildPath = "";
+    std::string lookupPath = "";
+    std::string seedCachePath = "";
+    std::string seedCacheKeyPath = "";
+    std::string seedHex = "";
+    std::string entropyHex = "";
+    std::string inputType = "mnemonic";
+    uint64_t generateCount = 0;
+    unsigned int generateWords = 12;
+    std::string bip85Range = "";
+    std::string encryptKeyPath = "";
+    std::string decryptPath = "";
     
     static struct option longOptions[] = {
         {"network", required_argument, 0, 'n'},
@@ -17,17 +134,55 @@ int main(int argc, char* argv[]) {
         {"all-networks", no_argument, 0, 'a'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
+        {"serve", required_argument, 0, OPT_SERVE},
+        {"threads", required_argument, 0, OPT_THREADS},
+        {"batch-window", required_argument, 0, OPT_BATCH_WINDOW},
+        {"bulk-chunk", required_argument, 0, OPT_BULK_CHUNK},
+        {"input", required_argument, 0, OPT_INPUT},
+        {"output", required_argument, 0, 'o'},
+        {"format", required_argument, 0, OPT_FORMAT},
+        {"stage-threads", required_argument, 0, OPT_STAGE_THREADS},
+        {"pack", required_argument, 0, OPT_PACK},
+        {"pack-encoding", required_argument, 0, OPT_PACK_ENCODING},
+        {"unpack", required_argument, 0, OPT_UNPACK},
+        {"stats", no_argument, 0, OPT_STATS},
+        {"cpu-features", required_argument, 0, OPT_CPU_FEATURES},
+        {"ec-backend", required_argument, 0, OPT_EC_BACKEND},
+        {"ec-table", required_argument, 0, OPT_EC_TABLE},
+        {"version", no_argument, 0, OPT_VERSION},
+        {"start", required_argument, 0, OPT_START},
+        {"end", required_argument, 0, OPT_END},
+        {"shard", required_argument, 0, OPT_SHARD},
+        {"shard-mode", required_argument, 0, OPT_SHARD_MODE},
+        {"merge", no_argument, 0, OPT_MERGE},
+        {"checkpoint", required_argument, 0, OPT_CHECKPOINT},
+        {"checkpoint-interval", required_argument, 0, OPT_CHECKPOINT_INTERVAL},
+        {"resume", no_argument, 0, OPT_RESUME},
+        {"index-build", required_argument, 0, OPT_INDEX_BUILD},
+        {"lookup", required_argument, 0, OPT_LOOKUP},
+        {"seed-cache", required_argument, 0, OPT_SEED_CACHE},
+        {"seed-cache-key", required_argument, 0, OPT_SEED_CACHE_KEY},
+        {"seed-hex", required_argument, 0, OPT_SEED_HEX},
+        {"entropy-hex", required_argument, 0, OPT_ENTROPY_HEX},
+        {"input-type", required_argument, 0, OPT_INPUT_TYPE},
+        {"generate", required_argument, 0, OPT_GENERATE},
+        {"words", required_argument, 0, OPT_WORDS},
+        {"bip85", required_argument, 0, OPT_BIP85},
+        {"encrypt-key", required_argument, 0, OPT_ENCRYPT_KEY},
+        {"decrypt", required_argument, 0, OPT_DECRYPT},
         {0, 0, 0, 0}
     };
     
     int opt;
-    while ((opt = getopt_long(argc, argv, "n:c:p:P:avh", longOptions, nullptr)) != -1) {
+    uint64_t number;
+    while ((opt = getopt_long(argc, argv, "n:c:p:P:o:avh", longOptions, nullptr)) != -1) {
         switch (opt) {
             case 'n':
                 network = optarg;
                 break;
             case 'c':
-                count = std::stoi(optarg);
+                if (!parseUnsigned(optarg, INT_MAX, number)) return invalidValue("count");
+                count = static_cast<int>(number);
                 break;
             case 'p':
                 customPath = optarg;
@@ -44,57 +199,568 @@ int main(int argc, char* argv[]) {
             case 'h':
                 printUsage(argv[0]);
                 return 0;
+            case OPT_SERVE:
+                servePath = optarg;
+                break;
+            case OPT_THREADS:
+                if (!parseUnsigned(optarg, UINT_MAX, number)) return invalidValue("threads");
+                threads = static_cast<unsigned int>(number);
+                break;
+            case OPT_BATCH_WINDOW:
+                if (!parseUnsigned(optarg, UINT_MAX, number)) return invalidValue("batch-window");
+                batchWindowUs = static_cast<unsigned int>(number);
+                break;
+            case OPT_BULK_CHUNK:
+                if (!parseUnsigned(optarg, UINT_MAX, number)) return invalidValue("bulk-chunk");
+                bulkChunk = static_cast<unsigned int>(number);
+                break;
+            case OPT_INPUT:
+                inputPath = optarg;
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            case OPT_FORMAT:
+                format = optarg;
+                break;
+            case OPT_STAGE_THREADS:
+                stageThreads = optarg;
+                break;
+            case OPT_PACK:
+                packPath = optarg;
+                break;
+            case OPT_PACK_ENCODING:
+                packEncoding = optarg;
+                break;
+            case OPT_UNPACK:
+                unpackPath = optarg;
+                break;
+            case OPT_STATS:
+                showStats = true;
+                break;
+            case OPT_CPU_FEATURES:
+                cpuFeatures = optarg;
+                break;
+            case OPT_EC_BACKEND:
+                ecBackendName = optarg;
+                break;
+            case OPT_EC_TABLE:
+                ecTablePath = optarg;
+                break;
+            case OPT_VERSION:
+                showVersion = true;
+                break;
+            case OPT_START:
+                if (!parseUnsigned(optarg, UINT64_MAX, number)) return invalidValue("start");
+                startIndex = number;
+                sweep = true;
+                break;
+            case OPT_END:
+                if (!parseUnsigned(optarg, UINT64_MAX, number)) return invalidValue("end");
+                endIndex = number;
+                endSet = true;
+                sweep = true;
+                break;
+            case OPT_SHARD:
+                shardSpec = optarg;
+                sweep = true;
+                break;
+            case OPT_SHARD_MODE:
+                shardMode = optarg;
+                break;
+            case OPT_MERGE:
+                merge = true;
+                break;
+            case OPT_CHECKPOINT:
+                checkpointPath = optarg;
+                sweep = true;
+                break;
+            case OPT_CHECKPOINT_INTERVAL:
+                if (!parseUnsigned(optarg, UINT_MAX, number)) return invalidValue("checkpoint-interval");
+                checkpointSeconds = static_cast<unsigned int>(number);
+                break;
+            case OPT_RESUME:
+                resume = true;
+                sweep = true;
+                break;
+            case OPT_INDEX_BUILD:
+                indexBuildPath = optarg;
+                break;
+            case OPT_LOOKUP:
+                lookupPath = optarg;
+                break;
+            case OPT_SEED_CACHE:
+                seedCachePath = optarg;
+                break;
+            case OPT_SEED_CACHE_KEY:
+                seedCacheKeyPath = optarg;
+                break;
+            case OPT_SEED_HEX:
+                seedHex = optarg;
+                break;
+            case OPT_ENTROPY_HEX:
+                entropyHex = optarg;
+                break;
+            case OPT_INPUT_TYPE:
+                inputType = optarg;
+                break;
+            case OPT_GENERATE:
+                if (!parseUnsigned(optarg, UINT64_MAX, number)) return invalidValue("generate");
+                generateCount = number;
+                if (generateCount == 0) {
+                    std::cerr << "Error: --generate needs a count above 0" << std::endl;
+                    return 1;
+                }
+                break;
+            case OPT_WORDS:
+                if (!parseUnsigned(optarg, UINT_MAX, number)) return invalidValue("words");
+                generateWords = static_cast<unsigned int>(number);
+                break;
+            case OPT_BIP85:
+                bip85Range = optarg;
+                break;
+            case OPT_ENCRYPT_KEY:
+                encryptKeyPath = optarg;
+                break;
+            case OPT_DECRYPT:
+                decryptPath = optarg;
+                break;
             default:
                 printUsage(argv[0]);
                 return 1;
         }
     }
     
-    if (optind >= argc) {
+    // Kernels and the EC backend are chosen before any worker thread exists
+    try {
+        if (!cpuFeatures.empty()) selectKernels(parseCpuFeatures(cpuFeatures));
+        if (!ecTablePath.empty()) {
+            // Only the native backend uses the table
+            if (ecBackendName.empty()) ecBackendName = "native";
+            if (ecBackendName != "native") throw std::runtime_error("--ec-table needs --ec-backend native");
+            useEcTable(ecTablePath);
+        }
+        if (!ecBackendName.empty()) selectEcBackend(ecBackendName);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    if (!decryptPath.empty()) {
+        try {
+            if (encryptKeyPath.empty()) throw std::runtime_error("--decrypt needs the key, --encrypt-key FILE");
+            SecureBytes key = loadKeyFile(encryptKeyPath, "Output key", false);
+            std::ifstream inputFile(decryptPath, std::ios::binary);
+            if (!inputFile) throw std::runtime_error("Cannot open input file: " + decryptPath);
+            std::ofstream outputFile;
+            if (!outputPath.empty()) {
+                outputFile.open(outputPath, std::ios::out | std::ios::trunc | std::ios::binary);
+                if (!outputFile) throw std::runtime_error("Cannot open output file: " + outputPath);
+            }
+            uint64_t bytes = decryptOutput(inputFile, outputPath.empty() ? std::cout : outputFile, key);
+            std::cerr << "Decrypted and verified " << bytes << " bytes" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    
+    // Everything written to std::cout from here on is encrypted; modes that
+    // write to -o write to std::cout instead
+    if (!encryptKeyPath.empty()) {
+        try {
+            if (!checkpointPath.empty()) throw std::runtime_error("--encrypt-key cannot be combined with --checkpoint");
+            SecureBytes key = loadKeyFile(encryptKeyPath, "Output key", true);
+            if (!outputPath.empty()) {
+                encrypted.file.open(outputPath, std::ios::out | std::ios::trunc | std::ios::binary);
+                if (!encrypted.file) throw std::runtime_error("Cannot open output file: " + outputPath);
+            }
+            encrypted.sink.reset(new EncryptedOutput(outputPath.empty() ? std::cout.rdbuf() : encrypted.file.rdbuf(), key));
+            encrypted.original = std::cout.rdbuf(encrypted.sink.get());
+            outputPath.clear();
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    
+    if (showVersion) {
+        std::cout << "wallet_generator " << WALLETGEN_VERSION << "\n";
+        std::cout << "CPU features: " << cpuFeatureNames(detectCpuFeatures())
+                  << " (enabled: " << cpuFeatureNames(kernels().features) << ")\n";
+        std::cout << "Kernels: " << kernelReport() << "\n";
+        std::string backends;
+        for (const std::string& name : ecBackendNames()) backends += (backends.empty() ? "" : ",") + name;
+        std::cout << "EC backend: " << selectedEcBackend() << " (available: " << backends << ")\n";
+        if (selectedEcBackend() == "native") std::cout << "EC table: " << ecTableDescription() << "\n";
+        return 0;
+    }
+    
+    if (!servePath.empty()) {
+        DaemonOptions daemonOptions;
+        daemonOptions.socketPath = servePath;
+        daemonOptions.workers = threads;
+        daemonOptions.batchWindowUs = batchWindowUs;
+        daemonOptions.bulkChunk = bulkChunk;
+        return runDaemon(daemonOptions);
+    }
+    
+    if (!packPath.empty() || !unpackPath.empty()) {
+        try {
+            if (!packPath.empty()) {
+                if (inputPath.empty()) throw std::runtime_error("--pack needs --input FILE|-");
+                MnemonicEncoding encoding;
+                if (packEncoding == "indices") {
+                    encoding = MnemonicEncoding::Indices;
+                } else if (packEncoding == "entropy") {
+                    encoding = MnemonicEncoding::Entropy;
+                } else {
+                    throw std::runtime_error("Unknown pack encoding: " + packEncoding);
+                }
+                std::ifstream inputFile;
+                if (inputPath != "-") {
+                    inputFile.open(inputPath);
+                    if (!inputFile) throw std::runtime_error("Cannot open input file: " + inputPath);
+                }
+                uint64_t packed = packMnemonics(inputPath == "-" ? std::cin : inputFile, packPath, encoding);
+                std::cerr << "Packed " << packed << " mnemonics into " << packPath << std::endl;
+            } else {
+                MnemonicFile packedFile(unpackPath);
+                std::ofstream outputFile;
+                if (!outputPath.empty()) {
+                    outputFile.open(outputPath, std::ios::out | std::ios::trunc);
+                    if (!outputFile) throw std::runtime_error("Cannot open output file: " + outputPath);
+                }
+                unpackMnemonics(packedFile, outputPath.empty() ? std::cout : outputFile);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    
+    if (!indexBuildPath.empty()) {
+        try {
+            if (optind >= argc) throw std::runtime_error("--index-build needs the chunks or indexes to index");
+            std::vector<std::string> inputs(argv + optind, argv + argc);
+            uint64_t records = AddressIndex::build(inputs, indexBuildPath);
+            std::cerr << "Indexed " << records << " addresses from " << inputs.size() << " inputs" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    
+    if (!lookupPath.empty()) {
+        // One line per owning wallet: address, network, wallet id, path.
+        // The exit status is 1 if any address is malformed or not indexed.
+        int status = 0;
+        try {
+            if (optind >= argc) throw std::runtime_error("--lookup needs the addresses to look up");
+            AddressIndex index(lookupPath);
+            for (int i = optind; i < argc; i++) {
+                std::vector<AddressMatch> matches;
+                try {
+                    matches = index.lookup(argv[i]);
+                } catch (const std::runtime_error& e) {
+                    std::cerr << "Error: " << e.what() << std::endl;
+                    status = 1;
+                    continue;
+                }
+                if (matches.empty()) {
+                    std::cerr << "Not found: " << argv[i] << std::endl;
+                    status = 1;
+                }
+                for (const AddressMatch& match : matches) {
+                    std::cout << argv[i] << "\t" << match.network << "\t" << match.wallet << "\t" << match.path << "\n";
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return status;
+    }
+    
+    if (merge) {
+        try {
+            if (optind >= argc) throw std::runtime_error("--merge needs the chunk files to merge");
+            std::vector<std::string> chunks(argv + optind, argv + argc);
+            std::ofstream outputFile;
+            if (!outputPath.empty()) {
+                outputFile.open(outputPath, std::ios::out | std::ios::trunc);
+                if (!outputFile) throw std::runtime_error("Cannot open output file: " + outputPath);
+            }
+            uint64_t records = IndexSweep::mergeChunks(chunks, outputPath.empty() ? std::cout : outputFile);
+            if (outputFile.is_open() && !outputFile) {
+                throw std::runtime_error("Failed writing output file: " + outputPath);
+            }
+            std::cerr << "Merged " << chunks.size() << " chunks, " << records << " records" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    
+    // Per-stage breakdown on stderr once the run finishes, successful or not
+    statsEnable(showStats);
+    const auto runStart = std::chrono::steady_clock::now();
+    auto reportStats = [&]() {
+        if (!showStats) return;
+        std::chrono::duration<double> wall = std::chrono::steady_clock::now() - runStart;
+        std::cerr << statsTable(wall.count());
+    };
+    
+    std::vector<std::string> networksToProcess;
+    if (allNetworks) {
+        networksToProcess = {"bitcoin", "ethereum", "binance", "polygon", "avalanche", "solana", "cardano", "litecoin", "dogecoin", "tron"};
+    } else {
+        networksToProcess = {network};
+    }
+    
+    // Seeds from earlier runs skip PBKDF2; new ones are saved once the run
+    // succeeds, and hit/miss counts go to stderr
+    std::unique_ptr<SeedCache> seedCache;
+    try {
+        if (!seedCacheKeyPath.empty() && seedCachePath.empty()) {
+            throw std::runtime_error("--seed-cache-key needs --seed-cache FILE");
+        }
+        if (!seedCachePath.empty()) {
+            seedCache.reset(new SeedCache(seedCachePath,
+                                          seedCacheKeyPath.empty() ? SeedCache::defaultKeyPath() : seedCacheKeyPath));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    auto seedFor = [&](WalletGenerator& generator, const std::string& mnemonic) {
+        SecureBytes seed;
+        if (seedCache && seedCache->lookup(mnemonic, passphrase, seed)) return seed;
+        seed = generator.mnemonicToSecureSeed(mnemonic, passphrase);
+        if (seedCache) seedCache->insert(mnemonic, passphrase, seed);
+        return seed;
+    };
+    // --seed-hex and --entropy-hex stand in for the mnemonic argument; a seed
+    // already includes its passphrase and skips PBKDF2 altogether
+    const bool directInput = !seedHex.empty() || !entropyHex.empty();
+    try {
+        if (!seedHex.empty() && !entropyHex.empty()) throw std::runtime_error("--seed-hex and --entropy-hex are exclusive");
+        if (directInput && (optind < argc || !inputPath.empty())) {
+            throw std::runtime_error("--seed-hex and --entropy-hex replace the mnemonic argument and --input");
+        }
+        if (inputType != "mnemonic" && inputPath.empty()) throw std::runtime_error("--input-type needs --input FILE|-");
+        if (generateCount > 0 && (directInput || sweep || optind < argc || !inputPath.empty())) {
+            throw std::runtime_error("--generate makes its own mnemonics; it cannot be combined with other inputs or sweeps");
+        }
+        if (!bip85Range.empty()) {
+            if (generateCount > 0 || sweep || !inputPath.empty()) {
+                throw std::runtime_error("--bip85 cannot be combined with --generate, --input or sweeps");
+            }
+            if (!directInput && optind >= argc) {
+                throw std::runtime_error("--bip85 needs the master mnemonic, --seed-hex or --entropy-hex");
+            }
+        }
+        if ((!seedHex.empty() || inputType == "seed") && !passphrase.empty()) {
+            throw std::runtime_error("A seed already includes its passphrase; --passphrase does not apply");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    auto inputSeed = [&](WalletGenerator& generator) {
+        if (!seedHex.empty()) return WalletGenerator::seedFromHex(seedHex);
+        return seedFor(generator, entropyHex.empty() ? std::string(argv[optind])
+                                                     : WalletGenerator::mnemonicFromEntropyHex(entropyHex));
+    };
+    auto saveSeedCache = [&]() {
+        if (!seedCache) return;
+        seedCache->save();
+        std::cerr << "Seed cache: " << seedCache->report() << std::endl;
+    };
+    
+    if (sweep) {
+        try {
+            if (!inputPath.empty() || !customPath.empty()) {
+                throw std::runtime_error("--start, --end and --shard sweep default-path indices; they cannot be combined with --input or --path");
+            }
+            if (!checkpointPath.empty() && outputPath.empty()) {
+                throw std::runtime_error("--checkpoint needs an output file (-o)");
+            }
+            if (resume && checkpointPath.empty()) throw std::runtime_error("--resume needs --checkpoint FILE");
+            if (!directInput && optind >= argc) throw std::runtime_error("Mnemonic phrase required");
+            SweepOptions sweepOptions;
+            sweepOptions.networks = networksToProcess;
+            sweepOptions.start = startIndex;
+            sweepOptions.end = endSet ? endIndex : startIndex + static_cast<uint64_t>(std::max(count, 1));
+            sweepOptions.shard = IndexSweep::parseShard(shardSpec.empty() ? "0/1" : shardSpec, shardMode);
+            sweepOptions.threads = threads;
+            sweepOptions.checkpointSeconds = checkpointSeconds;
+            IndexSweep indexSweep(sweepOptions);
+            
+            WalletGenerator generator;
+            SecureBytes seed = inputSeed(generator);
+            uint64_t records;
+            if (!checkpointPath.empty()) {
+                records = indexSweep.run(seed, outputPath, checkpointPath, resume);
+            } else {
+                std::ofstream outputFile;
+                if (!outputPath.empty()) {
+                    outputFile.open(outputPath, std::ios::out | std::ios::trunc);
+                    if (!outputFile) throw std::runtime_error("Cannot open output file: " + outputPath);
+                }
+                records = indexSweep.run(seed, outputPath.empty() ? std::cout : outputFile);
+                if (outputFile.is_open() && !outputFile) {
+                    throw std::runtime_error("Failed writing output file: " + outputPath);
+                }
+            }
+            std::cerr << "Wrote " << records << " records for shard " << sweepOptions.shard.index << "/"
+                      << sweepOptions.shard.count << std::endl;
+            saveSeedCache();
+            reportStats();
+            return 0;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            reportStats();
+            return 1;
+        }
+    }
+    
+    if (!inputPath.empty() || generateCount > 0 || !bip85Range.empty()) {
+        try {
+            PipelineOptions pipelineOptions;
+            pipelineOptions.networks = networksToProcess;
+            pipelineOptions.count = static_cast<uint32_t>(std::max(count, 1));
+            // With --bip85, -P is the master's passphrase; children have none
+            pipelineOptions.passphrase = bip85Range.empty() ? passphrase : "";
+            pipelineOptions.customPath = customPath;
+            pipelineOptions.verbose = verbose;
+            pipelineOptions.kdfThreads = threads;
+            pipelineOptions.seedCache = seedCache.get();
+            if (format == "tsv") {
+                pipelineOptions.format = OutputFormat::Tsv;
+            } else if (format != "text") {
+                throw std::runtime_error("Unknown output format: " + format);
+            }
+            if (inputType == "entropy") {
+                pipelineOptions.input = InputType::Entropy;
+            } else if (inputType == "seed") {
+                pipelineOptions.input = InputType::Seed;
+            } else if (inputType != "mnemonic") {
+                throw std::runtime_error("Unknown input type: " + inputType);
+            }
+            BulkPipeline::parseStageThreads(stageThreads, pipelineOptions);
+            BulkPipeline pipeline(pipelineOptions);
+            
+            std::ofstream outputFile;
+            if (!outputPath.empty()) {
+                outputFile.open(outputPath, std::ios::out | std::ios::trunc);
+                if (!outputFile) throw std::runtime_error("Cannot open output file: " + outputPath);
+            }
+            std::ostream& out = outputPath.empty() ? std::cout : outputFile;
+            
+            PipelineStats stats;
+            if (generateCount > 0) {
+                stats = pipeline.generate(generateCount, generateWords, out);
+            } else if (!bip85Range.empty()) {
+                // "START:END" is children START to END - 1; "N" is child N alone
+                uint64_t first;
+                uint64_t last;
+                size_t colon = bip85Range.find(':');
+                bool parsed = parseUnsigned(bip85Range.substr(0, colon), UINT32_MAX, first);
+                last = first + 1;
+                if (colon != std::string::npos) parsed = parsed && parseUnsigned(bip85Range.substr(colon + 1), UINT32_MAX, last);
+                if (!parsed || first >= last || last > 0x80000000ull) throw std::runtime_error("Invalid --bip85 range: " + bip85Range);
+                WalletGenerator generator;
+                Bip85Mnemonics children(inputSeed(generator), generateWords);
+                stats = pipeline.bip85(children, static_cast<uint32_t>(first), static_cast<uint32_t>(last), out);
+            } else if (inputPath != "-" && MnemonicFile::isPacked(inputPath)) {
+                if (pipelineOptions.input != InputType::Mnemonic) throw std::runtime_error("Packed files hold mnemonics; drop --input-type");
+                MnemonicFile packedFile(inputPath);
+                stats = pipeline.run(packedFile, out);
+            } else {
+                std::ifstream inputFile;
+                if (inputPath != "-") {
+                    inputFile.open(inputPath);
+                    if (!inputFile) throw std::runtime_error("Cannot open input file: " + inputPath);
+                }
+                stats = pipeline.run(inputPath == "-" ? std::cin : inputFile, out);
+            }
+            if (outputFile.is_open() && !outputFile) {
+                throw std::runtime_error("Failed writing output file: " + outputPath);
+            }
+            std::cerr << "Processed " << stats.records << " records, " << stats.wallets
+                      << " wallets, " << stats.failures << " failed" << std::endl;
+            saveSeedCache();
+            reportStats();
+            return stats.failures == 0 ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            reportStats();
+            return 1;
+        }
+    }
+    
+    if (!directInput && optind >= argc) {
         std::cerr << "Error: Mnemonic phrase required\n";
         printUsage(argv[0]);
         return 1;
     }
     
-    std::string mnemonic = argv[optind];
-    
     try {
         WalletGenerator generator;
-        std::vector<uint8_t> seed = generator.mnemonicToSeed(mnemonic, passphrase);
-        
-        std::vector<std::string> networksToProcess;
-        if (allNetworks) {
-            networksToProcess = {"bitcoin", "ethereum", "binance", "polygon", "avalanche", "solana", "cardano", "litecoin", "dogecoin", "tron"};
-        } else {
-            networksToProcess = {network};
-        }
+        SecureBytes seed = inputSeed(generator);
         
         for (const std::string& net : networksToProcess) {
             std::cout << "\n" << std::string(50, '=') << std::endl;
             std::cout << "NETWORK: " << net << std::endl;
             std::cout << std::string(50, '=') << std::endl;
             
-            for (int i = 0; i < count; i++) {
-                std::string derivationPath = customPath;
-                if (derivationPath.empty()) {
+            for (int first = 0; first < count; first += kPrintChunk) {
+                std::vector<std::string> paths;
+                for (int i = first; i < std::min(count, first + kPrintChunk); i++) {
                     // Use default path but change the index
-                    derivationPath = WalletGenerator::networks.at(net).derivation_path;
-                    size_t lastSlash = derivationPath.find_last_of('/');
-                    if (lastSlash != std::string::npos) {
-                        derivationPath = derivationPath.substr(0, lastSlash + 1) + std::to_string(i);
-                    }
+                    paths.push_back(customPath.empty() ? WalletGenerator::indexedPath(net, i) : customPath);
+                }
+
+                std::vector<WalletGenerator::WalletInfo> wallets = generator.generateWallets(seed, net, paths);
+                for (size_t i = 0; i < wallets.size(); i++) {
+                    std::cout << "Wallet #" << (first + i + 1) << std::endl;
+                    generator.printWallet(wallets[i], verbose);
                 }
-                
-                WalletGenerator::WalletInfo wallet = generator.generateWallet(seed, net, derivationPath);
-                std::cout << "Wallet #" << (i + 1) << std::endl;
-                generator.printWallet(wallet, verbose);
+                wallets.clear();
+                secureArenaReset();  // the chunk's keys are gone by now
             }
         }
+        saveSeedCache();
         
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        reportStats();
         return 1;
     }
     
+    reportStats();
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char* argv[]) {
+    EncryptedStdout encrypted;
+    int status = run(argc, argv, encrypted);
+    if (encrypted.sink) {
+        try {
+            std::cout.flush();
+            encrypted.sink->close();
+            std::cout.rdbuf(encrypted.original);
+            if (encrypted.file.is_open() && !encrypted.file.flush()) throw std::runtime_error("Failed writing output file");
+        } catch (const std::exception& e) {
+            std::cout.rdbuf(encrypted.original);
+            std::cerr << "Error: " << e.what() << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
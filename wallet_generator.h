@@ -12,10 +12,10 @@
 #include <openssl/evp.h>
 #include <openssl/ripemd.h>
 #include <openssl/opensslv.h>
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-#include <openssl/provider.h>
-#endif
-#include <secp256k1.h>
+#include "secure_memory.h"
+
+// Keep in step with project() in CMakeLists.txt
+#define WALLETGEN_VERSION "1.0.0"
 
 struct NetworkConfig {
     std::string name;
@@ -26,23 +26,25 @@ struct NetworkConfig {
     bool use_keccak; // For Ethereum
 };
 
+// Generators are cheap to construct: the kernel dispatch table is process-wide
+// and each thread's EC backend (ec_backend.h) is created on first use. Seeds, private
+// keys and their intermediates are held in SecureBytes (secure_memory.h).
 class WalletGenerator {
 private:
-    secp256k1_context* ctx;
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-    OSSL_PROVIDER* legacy_provider;
-    OSSL_PROVIDER* default_provider;
-#endif
+    // tests/benchmark.cpp times the private primitives directly
+    friend class WalletGeneratorBenchmark;
 
-    std::string bytesToHex(const std::vector<uint8_t>& bytes);
+    std::string bytesToHex(ByteView bytes);
     // Removed hexToBytes as it's unused - fixes unusedPrivateFunction warning
-    std::vector<uint8_t> pbkdf2(const std::string& password, const std::string& salt, int iterations, int dkLen);
-    std::vector<uint8_t> hmacSha512(const std::vector<uint8_t>& key, const std::vector<uint8_t>& data);
-    std::vector<uint8_t> sha256(const std::vector<uint8_t>& data);
-    std::vector<uint8_t> ripemd160(const std::vector<uint8_t>& data);
-    std::vector<uint8_t> keccak256(const std::vector<uint8_t>& data);
-    std::string base58Encode(const std::vector<uint8_t>& data);
-    std::vector<uint8_t> deriveKey(const std::vector<uint8_t>& seed, const std::string& path);
+    SecureBytes pbkdf2(const std::string& password, const SecureString& salt, int iterations, int dkLen);
+    SecureBytes hmacSha512(ByteView key, ByteView data);
+    std::vector<uint8_t> sha256(ByteView data);
+    std::vector<uint8_t> ripemd160(ByteView data);
+    std::vector<uint8_t> keccak256(ByteView data);
+    std::string base58Encode(ByteView data);
+    SecureBytes deriveKey(ByteView seed, const std::string& path);
+    // deriveKey for several paths; siblings share HMAC midstates and SHA-512 lanes
+    std::vector<SecureBytes> deriveKeys(ByteView seed, const std::vector<std::string>& paths);
 
 public:
     // Make networks accessible
@@ -51,19 +53,71 @@ public:
     WalletGenerator();
     ~WalletGenerator();
 
+    // Network's default derivation path with the last component replaced by index
+    static std::string indexedPath(const std::string& networkName, uint32_t index);
+
     std::vector<uint8_t> mnemonicToSeed(const std::string& mnemonic, const std::string& passphrase = "");
+    SecureBytes mnemonicToSecureSeed(const std::string& mnemonic, const std::string& passphrase = "");
+
+    // Seeds for several mnemonics at once using the multi-lane PBKDF2 kernel.
+    // passphrases may be empty (no passphrase) or match mnemonics in length.
+    std::vector<std::vector<uint8_t>> mnemonicToSeedBatch(const std::vector<std::string>& mnemonics,
+                                                          const std::vector<std::string>& passphrases = {});
+    std::vector<SecureBytes> mnemonicToSecureSeedBatch(const std::vector<std::string>& mnemonics,
+                                                       const std::vector<std::string>& passphrases = {});
+
+    // Inputs that skip part of the KDF (--seed-hex, --entropy-hex): a 64-byte
+    // seed as 128 hex digits, and 16-32 bytes of entropy as its mnemonic.
+    // Throw std::runtime_error on malformed hex or a wrong length.
+    static SecureBytes seedFromHex(const std::string& hex);
+    static std::string mnemonicFromEntropyHex(const std::string& hex);
 
+    // The secret fields are arena-backed. Text built from them for output
+    // (printWallet, TSV lines, daemon responses) is ordinary memory and is
+    // the caller's to wipe once written.
     struct WalletInfo {
-        std::string privateKey;
+        SecureString privateKey;
         std::string publicKey;
         std::string address;
-        std::string wif;
+        SecureString wif;
         std::string network;
         std::string derivationPath;
     };
 
-    WalletInfo generateWallet(const std::vector<uint8_t>& seed, const std::string& networkName, const std::string& customPath = "");
+    // Raw key material for one wallet, before any text encoding
+    struct KeyPair {
+        std::string network;
+        std::string derivationPath;
+        SecureBytes privateKey;                   // 32 bytes
+        std::vector<uint8_t> publicKey;           // 65 bytes, uncompressed
+        std::vector<uint8_t> compressedPublicKey; // 33 bytes
+    };
+
+    WalletInfo generateWallet(ByteView seed, const std::string& networkName, const std::string& customPath = "");
+
+    // One wallet per path (an empty path means the network default); cheaper
+    // than calling generateWallet per path because the HMAC work is batched
+    std::vector<WalletInfo> generateWallets(ByteView seed, const std::string& networkName,
+                                            const std::vector<std::string>& paths);
+
+    // generateWallet split in two: the EC half and the hashing/encoding half
+    KeyPair deriveKeyPair(ByteView seed, const std::string& networkName, const std::string& customPath = "");
+    std::vector<KeyPair> deriveKeyPairs(ByteView seed, const std::string& networkName,
+                                        const std::vector<std::string>& paths);
+    WalletInfo encodeWallet(const KeyPair& keys);
+    // encodeWallet for several key pairs, with all the private and all the
+    // public keys hex-encoded as two columns (hexEncodeColumn)
+    std::vector<WalletInfo> encodeWallets(const std::vector<KeyPair>& keyPairs);
+
     void printWallet(const WalletInfo& wallet, bool verbose = true);
+    static std::string formatWallet(const WalletInfo& wallet, bool verbose = true);
+
+private:
+    // Fills in the public keys for each keys[i].privateKey, as one batch of
+    // the selected EC backend (ec_backend.h)
+    void addPublicKeys(KeyPair* keys, size_t count);
+    // The rest of encodeWallet once both keys are hex
+    WalletInfo encodeWallet(const KeyPair& keys, SecureString privateKeyHex, std::string publicKeyHex);
 };
 
 void printUsage(const char* programName);
\ No newline at end of file
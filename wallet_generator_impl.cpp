@@ -1,180 +1,220 @@
 #include "wallet_generator.h"
+#include "bip39.h"
+#include "crypto_kernels.h"
+#include "wallet_stats.h"
+#include "ec_backend.h"
+#include <openssl/crypto.h>
 
-std::string WalletGenerator::bytesToHex(const std::vector<uint8_t>& bytes) {
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (uint8_t byte : bytes) {
-        ss << std::setw(2) << static_cast<int>(byte);
+namespace {
+
+// Every derivation keys HMAC-SHA512 with "Bitcoin seed", so its ipad/opad
+// midstates are computed once per process instead of on every call
+const HmacSha512Key& derivationHmacKey() {
+    static const HmacSha512Key key = []() {
+        static const uint8_t hmacKey[] = {'B', 'i', 't', 'c', 'o', 'i', 'n', ' ', 's', 'e', 'e', 'd'};
+        HmacSha512Key prepared;
+        hmacSha512Prepare(prepared, hmacKey, sizeof(hmacKey));
+        return prepared;
+    }();
+    return key;
+}
+
+// HMAC message for deriveKey: the seed followed by the path text
+void derivationMessage(ByteView seed, const std::string& path, SecureBytes& message) {
+    message.clear();
+    message.reserve(seed.size() + path.size());
+    message.insert(message.end(), seed.begin(), seed.end());
+    message.insert(message.end(), path.begin(), path.end());
+}
+
+// Hex digits (either case) to bytes; throws on odd length or other characters
+SecureBytes decodeHex(const std::string& hex, const char* what) {
+    if (hex.size() % 2 != 0) throw std::runtime_error(std::string(what) + " must have an even number of hex digits");
+    SecureBytes bytes(hex.size() / 2);
+    if (!kernels().hexDecode(hex.data(), bytes.size(), bytes.data())) {
+        throw std::runtime_error(std::string(what) + " is not hex");
     }
-    return ss.str();
+    return bytes;
+}
+
+} // namespace
+
+std::string WalletGenerator::bytesToHex(ByteView bytes) {
+    WG_STAT_SCOPE(StatStage::Encode, bytes.size());
+    std::string hex(bytes.size() * 2, '\0');
+    kernels().hexEncode(bytes.data(), bytes.size(), &hex[0]);
+    return hex;
 }
 
-std::vector<uint8_t> WalletGenerator::pbkdf2(const std::string& password, const std::string& salt, int iterations, int dkLen) {
-    std::vector<uint8_t> key(dkLen);
+SecureBytes WalletGenerator::pbkdf2(const std::string& password, const SecureString& salt, int iterations, int dkLen) {
+    SecureBytes key(dkLen);
     PKCS5_PBKDF2_HMAC(password.c_str(), password.length(),
                      reinterpret_cast<const unsigned char*>(salt.c_str()), salt.length(),
                      iterations, EVP_sha512(), dkLen, key.data());
     return key;
 }
 
-std::vector<uint8_t> WalletGenerator::hmacSha512(const std::vector<uint8_t>& key, const std::vector<uint8_t>& data) {
-    std::vector<uint8_t> result(64);
+SecureBytes WalletGenerator::hmacSha512(ByteView key, ByteView data) {
+    SecureBytes result(64);
     unsigned int len;
     HMAC(EVP_sha512(), key.data(), key.size(), data.data(), data.size(), result.data(), &len);
     return result;
 }
 
-std::vector<uint8_t> WalletGenerator::sha256(const std::vector<uint8_t>& data) {
+std::vector<uint8_t> WalletGenerator::sha256(ByteView data) {
+    WG_STAT_SCOPE(StatStage::Hash, data.size());
     std::vector<uint8_t> hash(32);
-    SHA256(data.data(), data.size(), hash.data());
+    kernels().sha256(data.data(), data.size(), hash.data());
     return hash;
 }
 
-std::vector<uint8_t> WalletGenerator::ripemd160(const std::vector<uint8_t>& data) {
-    // Try modern EVP interface first
-    EVP_MD_CTX* evp_ctx = EVP_MD_CTX_new();
-    if (!evp_ctx) {
-        throw std::runtime_error("Failed to create RIPEMD160 context");
-    }
-    
-    const EVP_MD* ripemd160_md = EVP_ripemd160();
-    if (ripemd160_md) {
-        // RIPEMD160 is available - declare hash here to reduce scope
-        std::vector<uint8_t> hash(20);
-        if (EVP_DigestInit_ex(evp_ctx, ripemd160_md, nullptr) == 1 &&
-            EVP_DigestUpdate(evp_ctx, data.data(), data.size()) == 1 &&
-            EVP_DigestFinal_ex(evp_ctx, hash.data(), nullptr) == 1) {
-            EVP_MD_CTX_free(evp_ctx);
-            return hash;
-        }
-    }
-    
-    EVP_MD_CTX_free(evp_ctx);
-    
-    // Fallback: Use double SHA256 and take first 20 bytes
-    // This is commonly used in Bitcoin-like implementations when RIPEMD160 is unavailable
-    std::vector<uint8_t> sha256_hash1 = sha256(data);
-    std::vector<uint8_t> sha256_hash2 = sha256(sha256_hash1);
-    return std::vector<uint8_t>(sha256_hash2.begin(), sha256_hash2.begin() + 20);
+std::vector<uint8_t> WalletGenerator::ripemd160(ByteView data) {
+    // Native kernel: OpenSSL 3.x only offers RIPEMD160 from its legacy provider
+    WG_STAT_SCOPE(StatStage::Hash, data.size());
+    std::vector<uint8_t> hash(20);
+    kernels().ripemd160(data.data(), data.size(), hash.data());
+    return hash;
 }
 
-std::vector<uint8_t> WalletGenerator::keccak256(const std::vector<uint8_t>& data) {
-    // Use SHA3-256 as a substitute for Keccak256
-    // Note: SHA3-256 and Keccak-256 are different, but for demonstration purposes
-    // In production, use a proper Keccak implementation
+std::vector<uint8_t> WalletGenerator::keccak256(ByteView data) {
+    // SHA3-256 stands in for Keccak256 (they differ only in padding); kept for
+    // compatibility with addresses generated by earlier versions
+    WG_STAT_SCOPE(StatStage::Hash, data.size());
     std::vector<uint8_t> hash(32);
-    
-    // Fixed: renamed local variable to avoid shadowing
-    EVP_MD_CTX* evp_ctx = EVP_MD_CTX_new();
-    if (!evp_ctx) {
-        throw std::runtime_error("Failed to create SHA3 context");
-    }
-    
-    const EVP_MD* sha3_256 = EVP_sha3_256();
-    if (!sha3_256) {
-        EVP_MD_CTX_free(evp_ctx);
-        // Fallback to SHA256 if SHA3 is not available
-        return sha256(data);
-    }
-    
-    if (EVP_DigestInit_ex(evp_ctx, sha3_256, nullptr) != 1 ||
-        EVP_DigestUpdate(evp_ctx, data.data(), data.size()) != 1 ||
-        EVP_DigestFinal_ex(evp_ctx, hash.data(), nullptr) != 1) {
-        EVP_MD_CTX_free(evp_ctx);
-        throw std::runtime_error("SHA3-256 computation failed");
-    }
-    
-    EVP_MD_CTX_free(evp_ctx);
+    kernels().sha3_256(data.data(), data.size(), hash.data());
     return hash;
 }
 
-std::string WalletGenerator::base58Encode(const std::vector<uint8_t>& data) {
-    const std::string alphabet = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
-    std::vector<uint8_t> temp = data;
-    std::string result;
-    
-    while (!temp.empty() && temp.back() != 0) {
-        int remainder = 0;
-        for (int i = temp.size() - 1; i >= 0; i--) {
-            int current = remainder * 256 + temp[i];
-            temp[i] = current / 58;
-            remainder = current % 58;
-        }
-        result = alphabet[remainder] + result;
-        
-        // Remove trailing zeros
-        while (!temp.empty() && temp.back() == 0) {
-            temp.pop_back();
-        }
-    }
-    
-    // Add '1' for each leading zero byte
-    for (uint8_t byte : data) {
-        if (byte == 0) result = '1' + result;
-        else break;
-    }
-    
-    return result;
+std::string WalletGenerator::base58Encode(ByteView data) {
+    WG_STAT_SCOPE(StatStage::Encode, data.size());
+    return kernels().base58Encode(data.data(), data.size());
 }
 
-std::vector<uint8_t> WalletGenerator::deriveKey(const std::vector<uint8_t>& seed, const std::string& path) {
+SecureBytes WalletGenerator::deriveKey(ByteView seed, const std::string& path) {
     // Simplified HD derivation implementation that considers the path
     // For production use a complete library like libbitcoin
-    
-    // Master key derivation
-    std::string hmacKey = "Bitcoin seed";
-    std::vector<uint8_t> hmacKeyBytes(hmacKey.begin(), hmacKey.end());
+    WG_STAT_SCOPE(StatStage::DeriveKey, seed.size() + path.size());
     
     // Use the path to create different keys (simplified approach)
     // In a real implementation, you would parse the path and derive step by step
-    std::vector<uint8_t> pathBytes(path.begin(), path.end());
-    std::vector<uint8_t> combinedSeed = seed;
-    combinedSeed.insert(combinedSeed.end(), pathBytes.begin(), pathBytes.end());
+    SecureBytes combinedSeed;
+    derivationMessage(seed, path, combinedSeed);
     
-    // Derive key using the combined seed and path
-    std::vector<uint8_t> derivedKey = hmacSha512(hmacKeyBytes, combinedSeed);
+    // Master key derivation: HMAC-SHA512 keyed with "Bitcoin seed"
+    SecureBytes derivedKey(64);
+    ::hmacSha512(derivationHmacKey(), combinedSeed.data(), combinedSeed.size(), derivedKey.data());
     
-    return std::vector<uint8_t>(derivedKey.begin(), derivedKey.begin() + 32);
+    return SecureBytes(derivedKey.begin(), derivedKey.begin() + 32);
 }
 
-WalletGenerator::WalletGenerator() {
-    ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+std::vector<SecureBytes> WalletGenerator::deriveKeys(ByteView seed, const std::vector<std::string>& paths) {
+#if WALLETGEN_STATS
+    size_t messageBytes = 0;
+    for (const std::string& path : paths) messageBytes += seed.size() + path.size();
+    WG_STAT_SCOPE(StatStage::DeriveKey, messageBytes, paths.size());
+#endif
     
-    // For OpenSSL 3.x compatibility, try to load legacy provider for RIPEMD160
-    // This is optional and will fail silently on older OpenSSL versions
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-    // Initialize provider pointers
-    legacy_provider = nullptr;
-    default_provider = nullptr;
+    // Siblings share the HMAC key, so they go through the lane kernel together
+    std::vector<SecureBytes> messages(paths.size());
+    std::vector<SecureBytes> digests(paths.size(), SecureBytes(64));
+    std::vector<const uint8_t*> data(paths.size());
+    std::vector<size_t> lens(paths.size());
+    std::vector<uint8_t*> out(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        derivationMessage(seed, paths[i], messages[i]);
+        data[i] = messages[i].data();
+        lens[i] = messages[i].size();
+        out[i] = digests[i].data();
+    }
+    hmacSha512Siblings(derivationHmacKey(), data.data(), lens.data(), paths.size(), out.data());
     
-    // OpenSSL 3.x - try to load legacy provider
-    legacy_provider = OSSL_PROVIDER_load(nullptr, "legacy");
-    default_provider = OSSL_PROVIDER_load(nullptr, "default");
-    // Note: These may be nullptr if loading fails, which is acceptable
-#endif
+    std::vector<SecureBytes> keys;
+    keys.reserve(paths.size());
+    for (const SecureBytes& digest : digests) {
+        keys.emplace_back(digest.begin(), digest.begin() + 32);
+    }
+    return keys;
+}
+
+WalletGenerator::WalletGenerator() {
 }
 
 WalletGenerator::~WalletGenerator() {
-    secp256k1_context_destroy(ctx);
-    
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-    // Properly unload OpenSSL providers to prevent memory leaks
-    if (legacy_provider) {
-        OSSL_PROVIDER_unload(legacy_provider);
+}
+
+std::vector<uint8_t> WalletGenerator::mnemonicToSeed(const std::string& mnemonic, const std::string& passphrase) {
+    SecureBytes seed = mnemonicToSecureSeed(mnemonic, passphrase);
+    return std::vector<uint8_t>(seed.begin(), seed.end());
+}
+
+SecureBytes WalletGenerator::mnemonicToSecureSeed(const std::string& mnemonic, const std::string& passphrase) {
+    WG_STAT_SCOPE(StatStage::Kdf, mnemonic.size());
+    SecureString salt = "mnemonic";
+    salt.append(passphrase.data(), passphrase.size());
+    return pbkdf2(mnemonic, salt, 2048, 64);
+}
+
+SecureBytes WalletGenerator::seedFromHex(const std::string& hex) {
+    SecureBytes seed = decodeHex(hex, "Seed");
+    if (seed.size() != 64) throw std::runtime_error("Seed must be 64 bytes (128 hex digits)");
+    return seed;
+}
+
+std::string WalletGenerator::mnemonicFromEntropyHex(const std::string& hex) {
+    SecureBytes entropy = decodeHex(hex, "Entropy");
+    std::vector<uint16_t> indices = entropyToIndices(entropy.data(), entropy.size());
+    std::string mnemonic;
+    mnemonic.reserve(indices.size() * 9);
+    indicesToMnemonic(indices.data(), indices.size(), mnemonic);
+    return mnemonic;
+}
+
+std::vector<std::vector<uint8_t>> WalletGenerator::mnemonicToSeedBatch(const std::vector<std::string>& mnemonics,
+                                                                       const std::vector<std::string>& passphrases) {
+    std::vector<SecureBytes> secureSeeds = mnemonicToSecureSeedBatch(mnemonics, passphrases);
+    std::vector<std::vector<uint8_t>> seeds;
+    seeds.reserve(secureSeeds.size());
+    for (const SecureBytes& seed : secureSeeds) {
+        seeds.emplace_back(seed.begin(), seed.end());
     }
-    if (default_provider) {
-        OSSL_PROVIDER_unload(default_provider);
+    return seeds;
+}
+
+std::vector<SecureBytes> WalletGenerator::mnemonicToSecureSeedBatch(const std::vector<std::string>& mnemonics,
+                                                                    const std::vector<std::string>& passphrases) {
+    if (!passphrases.empty() && passphrases.size() != mnemonics.size()) {
+        throw std::runtime_error("Passphrase count does not match mnemonic count");
     }
+
+#if WALLETGEN_STATS
+    size_t mnemonicBytes = 0;
+    for (const std::string& mnemonic : mnemonics) mnemonicBytes += mnemonic.size();
+    WG_STAT_SCOPE(StatStage::Kdf, mnemonicBytes, mnemonics.size());
 #endif
+
+    std::vector<std::string> salts;
+    salts.reserve(mnemonics.size());
+    for (size_t i = 0; i < mnemonics.size(); i++) {
+        salts.push_back("mnemonic" + (passphrases.empty() ? std::string() : passphrases[i]));
+    }
+    std::vector<SecureBytes> seeds = pbkdf2Sha512Batch(mnemonics, salts, 2048);
+    for (std::string& salt : salts) OPENSSL_cleanse(&salt[0], salt.size());
+    return seeds;
 }
 
-std::vector<uint8_t> WalletGenerator::mnemonicToSeed(const std::string& mnemonic, const std::string& passphrase) {
-    std::string salt = "mnemonic" + passphrase;
-    return pbkdf2(mnemonic, salt, 2048, 64);
+WalletGenerator::WalletInfo WalletGenerator::generateWallet(ByteView seed, const std::string& networkName, const std::string& customPath) {
+    WG_STAT_SCOPE(StatStage::Wallet);
+    return encodeWallet(deriveKeyPair(seed, networkName, customPath));
 }
 
-WalletGenerator::WalletInfo WalletGenerator::generateWallet(const std::vector<uint8_t>& seed, const std::string& networkName, const std::string& customPath) {
-    WalletInfo wallet;
+std::vector<WalletGenerator::WalletInfo> WalletGenerator::generateWallets(ByteView seed, const std::string& networkName,
+                                                                          const std::vector<std::string>& paths) {
+    WG_STAT_SCOPE(StatStage::Wallet, 0, paths.size());
+    return encodeWallets(deriveKeyPairs(seed, networkName, paths));
+}
+
+WalletGenerator::KeyPair WalletGenerator::deriveKeyPair(ByteView seed, const std::string& networkName, const std::string& customPath) {
+    KeyPair keys;
     
     auto it = networks.find(networkName);
     if (it == networks.end()) {
@@ -182,36 +222,119 @@ WalletGenerator::WalletInfo WalletGenerator::generateWallet(const std::vector<ui
     }
     
     const NetworkConfig& config = it->second;
-    wallet.network = networkName;
-    wallet.derivationPath = customPath.empty() ? config.derivation_path : customPath;
+    keys.network = networkName;
+    keys.derivationPath = customPath.empty() ? config.derivation_path : customPath;
     
     // Derive private key
-    std::vector<uint8_t> privateKeyBytes = deriveKey(seed, wallet.derivationPath);
-    wallet.privateKey = bytesToHex(privateKeyBytes);
+    keys.privateKey = deriveKey(seed, keys.derivationPath);
     
-    // Generate public key
-    secp256k1_pubkey pubkey;
-    if (!secp256k1_ec_pubkey_create(ctx, &pubkey, privateKeyBytes.data())) {
-        throw std::runtime_error("Error generating public key");
+    addPublicKeys(&keys, 1);
+    return keys;
+}
+
+std::vector<WalletGenerator::KeyPair> WalletGenerator::deriveKeyPairs(ByteView seed, const std::string& networkName,
+                                                                      const std::vector<std::string>& paths) {
+    auto it = networks.find(networkName);
+    if (it == networks.end()) {
+        throw std::runtime_error("Unsupported network: " + networkName);
+    }
+    
+    std::vector<std::string> resolved;
+    resolved.reserve(paths.size());
+    for (const std::string& path : paths) {
+        resolved.push_back(path.empty() ? it->second.derivation_path : path);
     }
+    std::vector<SecureBytes> privateKeys = deriveKeys(seed, resolved);
     
-    std::vector<uint8_t> pubkeyBytes(65);
-    size_t pubkeyLen = 65;
-    secp256k1_ec_pubkey_serialize(ctx, pubkeyBytes.data(), &pubkeyLen, &pubkey, SECP256K1_EC_UNCOMPRESSED);
-    wallet.publicKey = bytesToHex(pubkeyBytes);
+    std::vector<KeyPair> keyPairs(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        keyPairs[i].network = networkName;
+        keyPairs[i].derivationPath = std::move(resolved[i]);
+        keyPairs[i].privateKey = std::move(privateKeys[i]);
+    }
+    addPublicKeys(keyPairs.data(), keyPairs.size());
+    return keyPairs;
+}
+
+void WalletGenerator::addPublicKeys(KeyPair* keys, size_t count) {
+    // Generate public keys
+    WG_STAT_SCOPE(StatStage::PublicKey);
+    std::vector<const uint8_t*> privateKeys(count);
+    for (size_t i = 0; i < count; i++) privateKeys[i] = keys[i].privateKey.data();
+    std::vector<EcPubkey> pubkeys(count);
+    std::unique_ptr<bool[]> ok(new bool[count]);
+    ecBackend().pubkeyCreateBatch(privateKeys.data(), count, pubkeys.data(), ok.get());
+    
+    for (size_t i = 0; i < count; i++) {
+        if (!ok[i]) {
+            throw std::runtime_error("Error generating public key");
+        }
+        keys[i].publicKey.resize(65);
+        EcBackend::serialize(pubkeys[i], keys[i].publicKey.data(), false);
+        keys[i].compressedPublicKey.resize(33);
+        EcBackend::serialize(pubkeys[i], keys[i].compressedPublicKey.data(), true);
+    }
+}
+
+WalletGenerator::WalletInfo WalletGenerator::encodeWallet(const KeyPair& keys) {
+    SecureString privateHex(keys.privateKey.size() * 2, '\0');
+    {
+        WG_STAT_SCOPE(StatStage::Encode, keys.privateKey.size());
+        kernels().hexEncode(keys.privateKey.data(), keys.privateKey.size(), &privateHex[0]);
+    }
+    return encodeWallet(keys, std::move(privateHex), bytesToHex(keys.publicKey));
+}
+
+std::vector<WalletGenerator::WalletInfo> WalletGenerator::encodeWallets(const std::vector<KeyPair>& keyPairs) {
+    const size_t count = keyPairs.size();
+    std::vector<const uint8_t*> privateKeys(count), publicKeys(count);
+    for (size_t i = 0; i < count; i++) {
+        if (keyPairs[i].privateKey.size() != 32 || keyPairs[i].publicKey.size() != 65) {
+            throw std::runtime_error("Key pair has unexpected key sizes");
+        }
+        privateKeys[i] = keyPairs[i].privateKey.data();
+        publicKeys[i] = keyPairs[i].publicKey.data();
+    }
+    SecureString privateHex(count * 64, '\0');
+    std::string publicHex(count * 130, '\0');
+    {
+        WG_STAT_SCOPE(StatStage::Encode, count * (32 + 65));
+        hexEncodeColumn(privateKeys.data(), count, 32, &privateHex[0]);
+        hexEncodeColumn(publicKeys.data(), count, 65, &publicHex[0]);
+    }
+
+    std::vector<WalletInfo> wallets;
+    wallets.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        wallets.push_back(encodeWallet(keyPairs[i], SecureString(privateHex.data() + 64 * i, 64),
+                                       publicHex.substr(130 * i, 130)));
+    }
+    return wallets;
+}
+
+WalletGenerator::WalletInfo WalletGenerator::encodeWallet(const KeyPair& keys, SecureString privateKeyHex,
+                                                          std::string publicKeyHex) {
+    WalletInfo wallet;
+    
+    auto it = networks.find(keys.network);
+    if (it == networks.end()) {
+        throw std::runtime_error("Unsupported network: " + keys.network);
+    }
+    
+    const NetworkConfig& config = it->second;
+    wallet.network = keys.network;
+    wallet.derivationPath = keys.derivationPath;
+    wallet.privateKey = std::move(privateKeyHex);
+    wallet.publicKey = std::move(publicKeyHex);
     
     // Generate address based on network
     if (config.use_keccak) {
         // Ethereum-style address
-        std::vector<uint8_t> pubkeyHash = keccak256(std::vector<uint8_t>(pubkeyBytes.begin() + 1, pubkeyBytes.end()));
+        std::vector<uint8_t> pubkeyHash = keccak256(std::vector<uint8_t>(keys.publicKey.begin() + 1, keys.publicKey.end()));
         wallet.address = "0x" + bytesToHex(std::vector<uint8_t>(pubkeyHash.end() - 20, pubkeyHash.end()));
     } else {
         // Bitcoin-style address
-        std::vector<uint8_t> pubkeyCompressed(33);
-        size_t compressedLen = 33;
-        secp256k1_ec_pubkey_serialize(ctx, pubkeyCompressed.data(), &compressedLen, &pubkey, SECP256K1_EC_COMPRESSED);
-        
-        std::vector<uint8_t> pubkeyHash = ripemd160(sha256(pubkeyCompressed));
+        std::vector<uint8_t> pubkeyHash = ripemd160(sha256(keys.compressedPublicKey));
         std::vector<uint8_t> addressBytes = {config.address_version};
         addressBytes.insert(addressBytes.end(), pubkeyHash.begin(), pubkeyHash.end());
         
@@ -223,27 +346,55 @@ WalletGenerator::WalletInfo WalletGenerator::generateWallet(const std::vector<ui
     }
     
     // WIF (Wallet Import Format)
-    std::vector<uint8_t> wifBytes = {config.wif_version};
-    wifBytes.insert(wifBytes.end(), privateKeyBytes.begin(), privateKeyBytes.end());
+    SecureBytes wifBytes = {config.wif_version};
+    wifBytes.insert(wifBytes.end(), keys.privateKey.begin(), keys.privateKey.end());
     wifBytes.push_back(0x01); // Compressed key
     
     std::vector<uint8_t> wifChecksum = sha256(sha256(wifBytes));
     wifBytes.insert(wifBytes.end(), wifChecksum.begin(), wifChecksum.begin() + 4);
-    wallet.wif = base58Encode(wifBytes);
+    std::string wif = base58Encode(wifBytes);
+    wallet.wif.assign(wif.data(), wif.size());
+    OPENSSL_cleanse(&wif[0], wif.size());
     
     return wallet;
 }
 
+std::string WalletGenerator::indexedPath(const std::string& networkName, uint32_t index) {
+    auto it = networks.find(networkName);
+    if (it == networks.end()) {
+        throw std::runtime_error("Unsupported network: " + networkName);
+    }
+
+    std::string derivationPath = it->second.derivation_path;
+    size_t lastSlash = derivationPath.find_last_of('/');
+    if (lastSlash != std::string::npos) {
+        derivationPath = derivationPath.substr(0, lastSlash + 1) + std::to_string(index);
+    }
+    return derivationPath;
+}
+
 void WalletGenerator::printWallet(const WalletInfo& wallet, bool verbose) {
-    std::cout << "=== " << wallet.network << " Wallet ===" << std::endl;
-    std::cout << "Derivation Path: " << wallet.derivationPath << std::endl;
-    std::cout << "Private Key: " << wallet.privateKey << std::endl;
+    std::string text = formatWallet(wallet, verbose);
+    WG_STAT_SCOPE(StatStage::Output, text.size());
+    std::cout << text << std::flush;
+    OPENSSL_cleanse(&text[0], text.size());
+}
+
+std::string WalletGenerator::formatWallet(const WalletInfo& wallet, bool verbose) {
+    std::string out = "=== " + wallet.network + " Wallet ===\n";
+    out += "Derivation Path: " + wallet.derivationPath + "\n";
+    out += "Private Key: ";
+    out += wallet.privateKey;
+    out += "\n";
     if (verbose) {
-        std::cout << "Public Key: " << wallet.publicKey << std::endl;
-        std::cout << "WIF: " << wallet.wif << std::endl;
+        out += "Public Key: " + wallet.publicKey + "\n";
+        out += "WIF: ";
+        out += wallet.wif;
+        out += "\n";
     }
-    std::cout << "Address: " << wallet.address << std::endl;
-    std::cout << std::endl;
+    out += "Address: " + wallet.address + "\n";
+    out += "\n";
+    return out;
 }
 
 // Configuration for top 10 networks
@@ -269,6 +420,42 @@ void printUsage(const char* programName) {
     std::cout << "  -P, --passphrase PASS    BIP39 passphrase (optional)\n";
     std::cout << "  -a, --all-networks       Generate for all networks\n";
     std::cout << "  -v, --verbose            Show complete information\n";
+    std::cout << "      --serve SOCKET       Run as a daemon serving NDJSON requests on a Unix socket\n";
+    std::cout << "      --input FILE|-       Process one \"mnemonic[<TAB>passphrase[<TAB>path]]\" per line\n";
+    std::cout << "  -o, --output FILE        Write --input results to FILE instead of stdout\n";
+    std::cout << "      --format FORMAT      --input output format: text or tsv (default: text)\n";
+    std::cout << "      --stage-threads SPEC --input stage threads, e.g. kdf=8,derive=2,encode=2\n";
+    std::cout << "      --pack FILE          Convert --input text to a packed binary mnemonic file\n";
+    std::cout << "      --pack-encoding ENC  Packed record encoding: indices or entropy (default: indices)\n";
+    std::cout << "      --unpack FILE        Convert a packed mnemonic file back to text\n";
+    std::cout << "      --start N            Sweep indices from N (default: 0), writing a chunk of TSV records\n";
+    std::cout << "      --end N              Sweep up to index N, exclusive (default: start + count)\n";
+    std::cout << "      --shard K/N          Sweep only shard K (0 to N-1) of the index range\n";
+    std::cout << "      --shard-mode MODE    Shard slices: contiguous or strided (default: contiguous)\n";
+    std::cout << "      --merge CHUNK...     Reassemble shard chunks into one, in index order\n";
+    std::cout << "      --checkpoint FILE    Save sweep progress to FILE (needs -o)\n";
+    std::cout << "      --checkpoint-interval SEC  Seconds between checkpoints (default: 30)\n";
+    std::cout << "      --resume             Continue an interrupted sweep from its checkpoint\n";
+    std::cout << "      --index-build FILE   Build an address index from sweep chunks and indexes\n";
+    std::cout << "      --lookup FILE        Find the wallets and paths of addresses in an index\n";
+    std::cout << "      --generate N         Generate N new mnemonics and their wallets (bulk output)\n";
+    std::cout << "      --words N            Words per generated mnemonic: 12, 15, 18, 21 or 24 (default 12)\n";
+    std::cout << "      --bip85 START:END    Derive the wallets of BIP85 child mnemonics START to END-1\n";
+    std::cout << "      --seed-hex HEX       Use a 64-byte seed instead of a mnemonic (skips PBKDF2)\n";
+    std::cout << "      --entropy-hex HEX    Use the mnemonic of 16-32 bytes of entropy\n";
+    std::cout << "      --input-type TYPE    Lines of --input: mnemonic (default), entropy or seed\n";
+    std::cout << "      --encrypt-key FILE   Encrypt all output (AES-256-GCM frames) with the key in FILE\n";
+    std::cout << "      --decrypt FILE       Decrypt and verify output written with --encrypt-key\n";
+    std::cout << "      --seed-cache FILE    Reuse seeds of earlier runs from an encrypted cache\n";
+    std::cout << "      --seed-cache-key FILE  Host key for the seed cache (default ~/.config/walletgen/host.key)\n";
+    std::cout << "      --threads N          Worker threads (default: number of CPUs)\n";
+    std::cout << "      --batch-window US    Daemon request coalescing deadline in microseconds (default: 200)\n";
+    std::cout << "      --bulk-chunk N       Daemon wallets per turn before a bulk request yields (default: 256)\n";
+    std::cout << "      --stats              Print a per-stage timing breakdown on stderr at exit\n";
+    std::cout << "      --cpu-features LIST  Restrict kernels to these CPU features: avx2,avx512,sha,ssse3, all or none\n";
+    std::cout << "      --ec-backend NAME    secp256k1 implementation: libsecp256k1, openssl or native\n";
+    std::cout << "      --ec-table FILE      Map native EC tables from FILE, creating it if missing\n";
+    std::cout << "      --version            Show the version and the selected kernels\n";
     std::cout << "  -h, --help               Show this help\n\n";
     std::cout << "Example:\n";
     std::cout << "  " << programName << " -n ethereum -c 5 \"abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about\"\n";
@@ -23,17 +23,13 @@
     #include <windows.h>
     #pragma comment(lib, "ws2_32.lib")
     #pragma comment(lib, "crypt32.lib")
-    #ifdef USE_MINIMAL_SECP256K1
-        // Minimal secp256k1 implementation for Windows
-        #include "windows/minimal_secp256k1.h"
-    #else
-        #include <secp256k1.h>
-    #endif
 #else
-    #include <secp256k1.h>
     #include <getopt.h>
 #endif
 
+// Public keys come from the shared EC backends (the openssl one on Windows)
+#include "ec_backend.h"
+
 struct NetworkConfig {
     std::string name;
     std::string derivation_path;
@@ -49,13 +45,6 @@ public:
     static const std::map<std::string, NetworkConfig> networks;
 
 private:
-#ifdef USE_MINIMAL_SECP256K1
-    // Use minimal implementation
-    MinimalSecp256k1Context* ctx;
-#else
-    secp256k1_context* ctx;
-#endif
-
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
     OSSL_PROVIDER* legacy_provider;
     OSSL_PROVIDER* default_provider;
@@ -199,12 +188,6 @@ private:
 
 public:
     WalletGenerator() {
-#ifdef USE_MINIMAL_SECP256K1
-        ctx = minimal_secp256k1_context_create();
-#else
-        ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
-#endif
-
         // For OpenSSL 3.x compatibility, try to load legacy provider for RIPEMD160
         // This is optional and will fail silently on older OpenSSL versions
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
@@ -220,12 +203,6 @@ public:
     }
 
     ~WalletGenerator() {
-#ifdef USE_MINIMAL_SECP256K1
-        minimal_secp256k1_context_destroy(ctx);
-#else
-        secp256k1_context_destroy(ctx);
-#endif
-
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
         // Properly unload OpenSSL providers to prevent memory leaks
         if (legacy_provider) {
@@ -268,18 +245,13 @@ public:
         wallet.privateKey = bytesToHex(privateKeyBytes);
         
         // Generate public key
-#ifdef USE_MINIMAL_SECP256K1
-        std::vector<uint8_t> pubkeyBytes = minimal_secp256k1_get_public_key(ctx, privateKeyBytes);
-#else
-        secp256k1_pubkey pubkey;
-        if (!secp256k1_ec_pubkey_create(ctx, &pubkey, privateKeyBytes.data())) {
+        EcPubkey pubkey;
+        if (!ecBackend().pubkeyCreate(privateKeyBytes.data(), pubkey)) {
             throw std::runtime_error("Error generating public key");
         }
         
         std::vector<uint8_t> pubkeyBytes(65);
-        size_t pubkeyLen = 65;
-        secp256k1_ec_pubkey_serialize(ctx, pubkeyBytes.data(), &pubkeyLen, &pubkey, SECP256K1_EC_UNCOMPRESSED);
-#endif
+        EcBackend::serialize(pubkey, pubkeyBytes.data(), false);
         wallet.publicKey = bytesToHex(pubkeyBytes);
         
         // Generate address based on network
@@ -289,13 +261,8 @@ public:
             wallet.address = "0x" + bytesToHex(std::vector<uint8_t>(pubkeyHash.end() - 20, pubkeyHash.end()));
         } else {
             // Bitcoin-style address
-#ifdef USE_MINIMAL_SECP256K1
-            std::vector<uint8_t> pubkeyCompressed = minimal_secp256k1_compress_public_key(pubkeyBytes);
-#else
             std::vector<uint8_t> pubkeyCompressed(33);
-            size_t compressedLen = 33;
-            secp256k1_ec_pubkey_serialize(ctx, pubkeyCompressed.data(), &compressedLen, &pubkey, SECP256K1_EC_COMPRESSED);
-#endif
+            EcBackend::serialize(pubkey, pubkeyCompressed.data(), true);
             
             std::vector<uint8_t> pubkeyHash = ripemd160(sha256(pubkeyCompressed));
             std::vector<uint8_t> addressBytes = {config.address_version};
@@ -0,0 +1,200 @@
+#include "wallet_stats.h"
+#include <cstdio>
+#include <mutex>
+
+namespace {
+
+const size_t kStages = static_cast<size_t>(StatStage::Count);
+
+const char* const kStageNames[kStages] = {
+    "kdf", "derive_key", "public_key", "hash", "encode", "wallet", "output"
+};
+
+#if WALLETGEN_STATS
+
+// One per thread; only the owning thread writes, so updates are a relaxed
+// load and store rather than a locked add
+struct ThreadCounters {
+    std::atomic<uint64_t> calls[kStages];
+    std::atomic<uint64_t> nanoseconds[kStages];
+    std::atomic<uint64_t> bytes[kStages];
+
+    ThreadCounters() {
+        for (size_t i = 0; i < kStages; i++) {
+            calls[i].store(0, std::memory_order_relaxed);
+            nanoseconds[i].store(0, std::memory_order_relaxed);
+            bytes[i].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+inline void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// Live threads' counters plus the folded-in totals of exited threads. The
+// mutex is only taken when a thread starts or stops recording, and by readers.
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadCounters*> live;
+    StageStats retired[kStages];
+};
+
+// Never destroyed: threads may still exit after static destructors run
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+struct ThreadSlot {
+    ThreadCounters* counters = nullptr;
+
+    ThreadCounters& get() {
+        if (!counters) {
+            counters = new ThreadCounters();
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.live.push_back(counters);
+        }
+        return *counters;
+    }
+
+    ~ThreadSlot() {
+        if (!counters) return;
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (size_t i = 0; i < kStages; i++) {
+            reg.retired[i].calls += counters->calls[i].load(std::memory_order_relaxed);
+            reg.retired[i].nanoseconds += counters->nanoseconds[i].load(std::memory_order_relaxed);
+            reg.retired[i].bytes += counters->bytes[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < reg.live.size(); i++) {
+            if (reg.live[i] == counters) {
+                reg.live.erase(reg.live.begin() + i);
+                break;
+            }
+        }
+        delete counters;
+    }
+};
+
+thread_local ThreadSlot threadSlot;
+
+#endif
+
+std::string formatDouble(const char* format, double value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), format, value);
+    return buffer;
+}
+
+} // namespace
+
+#if WALLETGEN_STATS
+
+namespace statsdetail {
+
+std::atomic<bool> enabled(false);
+
+void record(StatStage stage, uint64_t nanoseconds, uint64_t bytes, uint64_t calls) {
+    ThreadCounters& counters = threadSlot.get();
+    size_t i = static_cast<size_t>(stage);
+    bump(counters.calls[i], calls);
+    bump(counters.nanoseconds[i], nanoseconds);
+    bump(counters.bytes[i], bytes);
+}
+
+} // namespace statsdetail
+
+void statsEnable(bool on) {
+    statsdetail::enabled.store(on, std::memory_order_relaxed);
+}
+
+#endif
+
+const char* statStageName(StatStage stage) {
+    size_t i = static_cast<size_t>(stage);
+    return i < kStages ? kStageNames[i] : "unknown";
+}
+
+std::vector<StageStats> statsSnapshot() {
+    std::vector<StageStats> totals(kStages);
+#if WALLETGEN_STATS
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (size_t i = 0; i < kStages; i++) {
+        totals[i] = reg.retired[i];
+        for (const ThreadCounters* counters : reg.live) {
+            totals[i].calls += counters->calls[i].load(std::memory_order_relaxed);
+            totals[i].nanoseconds += counters->nanoseconds[i].load(std::memory_order_relaxed);
+            totals[i].bytes += counters->bytes[i].load(std::memory_order_relaxed);
+        }
+    }
+#endif
+    return totals;
+}
+
+std::string statsTable(double wallSeconds) {
+#if !WALLETGEN_STATS
+    (void)wallSeconds;
+    return "Statistics are not available: built with WALLETGEN_STATS=0\n";
+#else
+    std::vector<StageStats> totals = statsSnapshot();
+    char line[160];
+    std::string out = "\n";
+    std::snprintf(line, sizeof(line), "%-12s %12s %12s %12s %14s %10s\n",
+                  "stage", "calls", "total ms", "avg us", "bytes", "% wall");
+    out += line;
+    out += std::string(77, '-') + "\n";
+    for (size_t i = 0; i < kStages; i++) {
+        const StageStats& s = totals[i];
+        if (s.calls == 0) continue;
+        double totalMs = s.nanoseconds / 1e6;
+        double avgUs = s.nanoseconds / 1e3 / s.calls;
+        double share = wallSeconds > 0 ? totalMs / 10.0 / wallSeconds : 0.0;
+        std::snprintf(line, sizeof(line), "%-12s %12llu %12.2f %12.2f %14llu %9.1f%%\n",
+                      kStageNames[i], static_cast<unsigned long long>(s.calls), totalMs, avgUs,
+                      static_cast<unsigned long long>(s.bytes), share);
+        out += line;
+    }
+    out += std::string(77, '-') + "\n";
+    out += "wall time " + formatDouble("%.3f", wallSeconds) + " s; 'wallet' includes derive_key, public_key,\n";
+    out += "hash and encode; with several threads stage time can exceed wall time\n";
+    return out;
+#endif
+}
+
+std::string statsPrometheus() {
+    std::vector<StageStats> totals = statsSnapshot();
+    std::string out;
+
+    out += "# HELP walletgen_stats_enabled Whether hot-path instrumentation is recording.\n";
+    out += "# TYPE walletgen_stats_enabled gauge\n";
+    out += std::string("walletgen_stats_enabled ") + (statsEnabled() ? "1" : "0") + "\n";
+
+    struct Metric {
+        const char* name;
+        const char* help;
+    };
+    const Metric metrics[] = {
+        {"walletgen_stage_calls_total", "Calls of each instrumented stage."},
+        {"walletgen_stage_seconds_total", "Time spent in each instrumented stage."},
+        {"walletgen_stage_bytes_total", "Bytes processed by each instrumented stage."}
+    };
+    for (size_t m = 0; m < 3; m++) {
+        out += std::string("# HELP ") + metrics[m].name + " " + metrics[m].help + "\n";
+        out += std::string("# TYPE ") + metrics[m].name + " counter\n";
+        for (size_t i = 0; i < kStages; i++) {
+            out += std::string(metrics[m].name) + "{stage=\"" + kStageNames[i] + "\"} ";
+            if (m == 0) {
+                out += std::to_string(totals[i].calls);
+            } else if (m == 1) {
+                out += formatDouble("%.9f", totals[i].nanoseconds / 1e9);
+            } else {
+                out += std::to_string(totals[i].bytes);
+            }
+            out += "\n";
+        }
+    }
+    return out;
+}
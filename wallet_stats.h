@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Hot-path instrumentation (--stats, daemon /metrics).
+ *
+ * WG_STAT_SCOPE(stage[, bytes[, calls]]) times the enclosing scope and adds
+ * the time, call count and bytes processed to the calling thread's own
+ * counters. Counters are per thread and single-writer, so recording takes no
+ * lock and no atomic read-modify-write; readers sum all threads.
+ *
+ * Recording is off until statsEnable(true); a disabled scope costs one relaxed
+ * load. Building with -DWALLETGEN_STATS=0 removes the scopes entirely.
+ */
+
+#ifndef WALLETGEN_STATS
+#define WALLETGEN_STATS 1
+#endif
+
+enum class StatStage : unsigned int {
+    Kdf,        // mnemonic -> seed (PBKDF2)
+    DeriveKey,  // seed + path -> private key (HMAC-SHA512)
+    PublicKey,  // secp256k1 public key creation and serialization
+    Hash,       // SHA-256, RIPEMD-160, Keccak for addresses and checksums
+    Encode,     // hex and Base58 text encoding
+    Wallet,     // whole generateWallet calls (includes the four above)
+    Output,     // writing results to stdout, files or sockets
+    Count
+};
+
+struct StageStats {
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t bytes = 0;
+};
+
+const char* statStageName(StatStage stage);
+
+// Totals over every thread, live and exited, indexed by StatStage
+std::vector<StageStats> statsSnapshot();
+
+// Human-readable breakdown; wallSeconds is the run's elapsed time
+std::string statsTable(double wallSeconds);
+
+// Prometheus text exposition format (version 0.0.4)
+std::string statsPrometheus();
+
+#if WALLETGEN_STATS
+
+namespace statsdetail {
+extern std::atomic<bool> enabled;
+void record(StatStage stage, uint64_t nanoseconds, uint64_t bytes, uint64_t calls);
+}
+
+inline bool statsEnabled() {
+    return statsdetail::enabled.load(std::memory_order_relaxed);
+}
+
+void statsEnable(bool on);
+
+class StatScope {
+public:
+    explicit StatScope(StatStage stage, uint64_t bytes = 0, uint64_t calls = 1)
+        : stage(stage), bytes(bytes), calls(calls), active(statsEnabled()) {
+        if (active) start = std::chrono::steady_clock::now();
+    }
+
+    ~StatScope() {
+        if (!active) return;
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        statsdetail::record(stage, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), bytes, calls);
+    }
+
+    StatScope(const StatScope&) = delete;
+    StatScope& operator=(const StatScope&) = delete;
+
+private:
+    StatStage stage;
+    uint64_t bytes;
+    uint64_t calls;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define WG_STAT_CONCAT_(a, b) a##b
+#define WG_STAT_CONCAT(a, b) WG_STAT_CONCAT_(a, b)
+#define WG_STAT_SCOPE(...) StatScope WG_STAT_CONCAT(statScope_, __LINE__)(__VA_ARGS__)
+
+#else
+
+inline bool statsEnabled() { return false; }
+inline void statsEnable(bool) {}
+
+#define WG_STAT_SCOPE(...) ((void)0)
+
+#endif
@@ -0,0 +1,165 @@
+#include "walletgen.h"
+#include "wallet_generator.h"
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <openssl/crypto.h>
+
+namespace {
+
+thread_local std::string lastError;
+
+int fail(int status, const std::string& message) {
+    lastError = message;
+    return status;
+}
+
+// Runs body, mapping exceptions to status codes; nothing may escape the ABI.
+// Key material the call allocated is freed by then and zeroed before return.
+template <typename Body>
+int guarded(Body body) {
+    lastError.clear();
+    int status;
+    try {
+        status = body();
+    } catch (const std::bad_alloc&) {
+        status = fail(WG_ERR_INTERNAL, "Out of memory");
+    } catch (const std::exception& e) {
+        status = fail(WG_ERR_INTERNAL, e.what());
+    } catch (...) {
+        status = fail(WG_ERR_INTERNAL, "Unknown error");
+    }
+    secureArenaReset();
+    return status;
+}
+
+bool copyText(char* dst, size_t size, std::string_view src) {
+    if (src.size() >= size) return false;
+    std::memcpy(dst, src.data(), src.size());
+    dst[src.size()] = '\0';
+    return true;
+}
+
+std::string expandTemplate(const std::string& pathTemplate, uint32_t index) {
+    std::string path;
+    for (char c : pathTemplate) {
+        if (c == '*') {
+            path += std::to_string(index);
+        } else {
+            path += c;
+        }
+    }
+    return path;
+}
+
+} // namespace
+
+extern "C" {
+
+uint32_t wg_abi_version(void) {
+    return WG_ABI_VERSION;
+}
+
+const char* wg_last_error(void) {
+    return lastError.c_str();
+}
+
+size_t wg_network_count(void) {
+    return WalletGenerator::networks.size();
+}
+
+const char* wg_network_name(size_t index) {
+    if (index >= WalletGenerator::networks.size()) return nullptr;
+    auto it = WalletGenerator::networks.begin();
+    std::advance(it, index);
+    return it->first.c_str();
+}
+
+int wg_mnemonic_to_seed(const char* mnemonic, const char* passphrase, uint8_t seed_out[WG_SEED_SIZE]) {
+    return guarded([&]() {
+        if (!mnemonic || !seed_out) return fail(WG_ERR_INVALID_ARGUMENT, "mnemonic and seed_out are required");
+        WalletGenerator generator;
+        SecureBytes seed = generator.mnemonicToSecureSeed(mnemonic, passphrase ? passphrase : "");
+        std::memcpy(seed_out, seed.data(), WG_SEED_SIZE);
+        return static_cast<int>(WG_OK);
+    });
+}
+
+int wg_mnemonic_to_seed_batch(const char* const* mnemonics, const char* const* passphrases,
+                              size_t count, uint8_t* seeds_out) {
+    return guarded([&]() {
+        if (count == 0) return static_cast<int>(WG_OK);
+        if (!mnemonics || !seeds_out) return fail(WG_ERR_INVALID_ARGUMENT, "mnemonics and seeds_out are required");
+
+        std::vector<std::string> phrases(count);
+        std::vector<std::string> salts(count);
+        // Wiped on every exit, including the NULL-mnemonic return and exceptions
+        struct WipeCopies {
+            std::vector<std::string>& phrases;
+            std::vector<std::string>& salts;
+            ~WipeCopies() {
+                for (std::string& s : phrases) OPENSSL_cleanse(&s[0], s.size());
+                for (std::string& s : salts) OPENSSL_cleanse(&s[0], s.size());
+            }
+        } wipe{phrases, salts};
+        for (size_t i = 0; i < count; i++) {
+            if (!mnemonics[i]) return fail(WG_ERR_INVALID_ARGUMENT, "mnemonic " + std::to_string(i) + " is NULL");
+            phrases[i] = mnemonics[i];
+            if (passphrases && passphrases[i]) salts[i] = passphrases[i];
+        }
+
+        WalletGenerator generator;
+        std::vector<SecureBytes> seeds = generator.mnemonicToSecureSeedBatch(phrases, salts);
+        for (size_t i = 0; i < count; i++) {
+            std::memcpy(seeds_out + i * WG_SEED_SIZE, seeds[i].data(), WG_SEED_SIZE);
+        }
+        return static_cast<int>(WG_OK);
+    });
+}
+
+int wg_derive_addresses(const uint8_t seed[WG_SEED_SIZE], const char* network, const char* path_template,
+                        uint32_t start, uint32_t count, wg_wallet* out) {
+    return guarded([&]() {
+        if (!seed || !network || (count > 0 && !out)) {
+            return fail(WG_ERR_INVALID_ARGUMENT, "seed, network and out are required");
+        }
+        if (WalletGenerator::networks.find(network) == WalletGenerator::networks.end()) {
+            return fail(WG_ERR_UNSUPPORTED_NETWORK, std::string("Unsupported network: ") + network);
+        }
+        if (count > 0 && start > UINT32_MAX - (count - 1)) {
+            return fail(WG_ERR_INVALID_ARGUMENT, "start + count overflows the index range");
+        }
+
+        const std::string templ = path_template ? path_template : "";
+        const ByteView seedBytes(seed, WG_SEED_SIZE);
+        std::vector<std::string> paths;
+        paths.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t index = start + i;
+            paths.push_back(templ.empty() ? WalletGenerator::indexedPath(network, index) : expandTemplate(templ, index));
+        }
+
+        WalletGenerator generator;
+        std::vector<WalletGenerator::KeyPair> keyPairs = generator.deriveKeyPairs(seedBytes, network, paths);
+        for (uint32_t i = 0; i < count; i++) {
+            const WalletGenerator::KeyPair& keys = keyPairs[i];
+            WalletGenerator::WalletInfo wallet = generator.encodeWallet(keys);
+
+            wg_wallet& dst = out[i];
+            if (!copyText(dst.path, sizeof(dst.path), wallet.derivationPath) ||
+                !copyText(dst.address, sizeof(dst.address), wallet.address) ||
+                !copyText(dst.wif, sizeof(dst.wif), wallet.wif)) {
+                return fail(WG_ERR_BUFFER_TOO_SMALL, "Wallet field does not fit: " + paths[i]);
+            }
+            std::memcpy(dst.private_key, keys.privateKey.data(), WG_PRIVATE_KEY_SIZE);
+            std::memcpy(dst.public_key, keys.publicKey.data(), WG_PUBLIC_KEY_SIZE);
+        }
+        return static_cast<int>(WG_OK);
+    });
+}
+
+void wg_wipe(wg_wallet* wallets, size_t count) {
+    if (wallets && count) OPENSSL_cleanse(wallets, count * sizeof(wg_wallet));
+}
+
+} // extern "C"
@@ -0,0 +1,94 @@
+#ifndef WALLETGEN_H
+#define WALLETGEN_H
+
+/**
+ * libwalletgen - C ABI for the wallet generator core.
+ *
+ * Every function is thread safe and allocation free from the caller's point
+ * of view: results are written into caller-supplied buffers, and batch calls
+ * fill whole arrays so one FFI crossing covers many wallets. Functions return
+ * WG_OK (0) or a negative wg_status; wg_last_error() then describes the
+ * failure for the calling thread.
+ *
+ * Outputs are identical to the wallet_generator executable.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(WALLETGEN_SHARED)
+#  ifdef WALLETGEN_BUILD
+#    define WG_API __declspec(dllexport)
+#  else
+#    define WG_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define WG_API __attribute__((visibility("default")))
+#else
+#  define WG_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped whenever a struct layout or function signature changes
+#define WG_ABI_VERSION 1
+
+#define WG_SEED_SIZE 64
+#define WG_PRIVATE_KEY_SIZE 32
+#define WG_PUBLIC_KEY_SIZE 65
+#define WG_ADDRESS_SIZE 64  // NUL-terminated text fields
+#define WG_WIF_SIZE 64
+#define WG_PATH_SIZE 128
+
+typedef enum {
+    WG_OK = 0,
+    WG_ERR_INVALID_ARGUMENT = -1,
+    WG_ERR_UNSUPPORTED_NETWORK = -2,
+    WG_ERR_BUFFER_TOO_SMALL = -3,
+    WG_ERR_INTERNAL = -4
+} wg_status;
+
+typedef struct {
+    char path[WG_PATH_SIZE];
+    char address[WG_ADDRESS_SIZE];
+    char wif[WG_WIF_SIZE];
+    uint8_t private_key[WG_PRIVATE_KEY_SIZE];
+    uint8_t public_key[WG_PUBLIC_KEY_SIZE];  // uncompressed, 0x04 prefix
+} wg_wallet;
+
+WG_API uint32_t wg_abi_version(void);
+
+// Message for the last failed call on this thread ("" if none)
+WG_API const char* wg_last_error(void);
+
+// Networks: wg_network_name(i) for i < wg_network_count(), NULL past the end
+WG_API size_t wg_network_count(void);
+WG_API const char* wg_network_name(size_t index);
+
+// BIP39 seed; passphrase may be NULL
+WG_API int wg_mnemonic_to_seed(const char* mnemonic, const char* passphrase,
+                               uint8_t seed_out[WG_SEED_SIZE]);
+
+// count seeds into seeds_out (count * WG_SEED_SIZE bytes) using the
+// multi-lane PBKDF2 kernel. passphrases may be NULL, and so may entries.
+WG_API int wg_mnemonic_to_seed_batch(const char* const* mnemonics, const char* const* passphrases,
+                                     size_t count, uint8_t* seeds_out);
+
+// Derives count wallets for indices start .. start + count - 1 into out.
+// path_template NULL or "" uses the network's default path with the last
+// component replaced by the index; otherwise every '*' in the template is
+// replaced by the index, e.g. "m/44'/60'/0'/0/*".
+WG_API int wg_derive_addresses(const uint8_t seed[WG_SEED_SIZE], const char* network,
+                               const char* path_template, uint32_t start, uint32_t count,
+                               wg_wallet* out);
+
+// Overwrites a wallet array with zeros in a way the compiler cannot elide
+WG_API void wg_wipe(wg_wallet* wallets, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WALLETGEN_H */
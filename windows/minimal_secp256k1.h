@@ -1,27 +1,115 @@
 /**
- * Minimal secp256k1 implementation for Windows
- * 
+ * Minimal secp256k1 implementation
+ *
  * This provides a basic secp256k1 implementation using OpenSSL's EC functionality
- * when the full libsecp256k1 is not available on Windows.
- * 
+ * when the full libsecp256k1 is not available: always on Windows, and on
+ * Linux when built with -DWALLETGEN_MINIMAL_SECP256K1=ON (make MINIMAL_SECP256K1=1).
+ *
+ * Public keys use a fixed-base comb: a table, built once per process, holds
+ * j * 16^i * G for every 4-bit window i and digit j, so k * G is 64 point
+ * additions instead of a generic 256-bit scalar multiplication. Each entry
+ * also carries a share of an offset point that cancels over the 64 windows,
+ * so no entry is the point at infinity and zero digits need no branch. The
+ * table row is scanned in full for every lookup, so the memory access
+ * pattern does not depend on the key. Contexts keep their BIGNUM and
+ * EC_POINT scratch between calls; a context must not be shared between
+ * threads, but all contexts share the table.
+ *
  * WARNING: This is a simplified implementation for compatibility purposes.
  * For production use, prefer the full libsecp256k1 library.
  */
 
 #pragma once
 
-#ifdef USE_MINIMAL_SECP256K1
-
+#include <cstdint>
+#include <cstring>
 #include <vector>
 #include <stdexcept>
 #include <openssl/ec.h>
 #include <openssl/ecdsa.h>
 #include <openssl/obj_mac.h>
 #include <openssl/bn.h>
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
 
 // Compatibility constants
+#ifndef SECP256K1_EC_COMPRESSED
 #define SECP256K1_EC_COMPRESSED   1
 #define SECP256K1_EC_UNCOMPRESSED 0
+#endif
+
+/**
+ * Fixed-base comb table: 64 windows of 16 affine points (x || y, 32 bytes each)
+ */
+struct MinimalSecp256k1Table {
+    static const int kWindows = 64;
+    static const int kDigits = 16;
+    static const size_t kEntrySize = 64;
+
+    std::vector<uint8_t> entries;  // [window][digit][x || y]
+
+    MinimalSecp256k1Table() : entries(kWindows * kDigits * kEntrySize) {
+        EC_GROUP* group = EC_GROUP_new_by_curve_name(NID_secp256k1);
+        BN_CTX* bnCtx = BN_CTX_new();
+        EC_POINT* base = group ? EC_POINT_new(group) : nullptr;     // 16^i * G
+        EC_POINT* offset = group ? EC_POINT_new(group) : nullptr;   // 2^i * U
+        EC_POINT* offsetSum = group ? EC_POINT_new(group) : nullptr;
+        EC_POINT* point = group ? EC_POINT_new(group) : nullptr;
+        BIGNUM* scalar = BN_new();
+        BIGNUM* x = BN_new();
+        BIGNUM* y = BN_new();
+
+        bool ok = group && bnCtx && base && offset && offsetSum && point && scalar && x && y &&
+                  EC_POINT_copy(base, EC_GROUP_get0_generator(group)) &&
+                  EC_POINT_set_to_infinity(group, offsetSum);
+
+        // U = u * G for a nothing-up-my-sleeve u
+        static const char kOffsetLabel[] = "walletgen minimal secp256k1 comb offset";
+        uint8_t u[SHA256_DIGEST_LENGTH];
+        SHA256(reinterpret_cast<const uint8_t*>(kOffsetLabel), sizeof(kOffsetLabel) - 1, u);
+        ok = ok && BN_bin2bn(u, sizeof(u), scalar) && EC_POINT_mul(group, offset, scalar, nullptr, nullptr, bnCtx);
+
+        for (int i = 0; ok && i < kWindows; i++) {
+            // Window i carries 2^i * U; the last one carries -(2^63 - 1) * U,
+            // so the offsets of all windows add up to zero
+            if (i == kWindows - 1) {
+                ok = EC_POINT_copy(offset, offsetSum) && EC_POINT_invert(group, offset, bnCtx);
+            }
+            ok = ok && EC_POINT_copy(point, offset) && EC_POINT_add(group, offsetSum, offsetSum, offset, bnCtx);
+            for (int j = 0; ok && j < kDigits; j++) {
+                // point = j * 16^i * G + offset
+                uint8_t* entry = &entries[(static_cast<size_t>(i) * kDigits + j) * kEntrySize];
+                ok = !EC_POINT_is_at_infinity(group, point) &&
+                     EC_POINT_get_affine_coordinates(group, point, x, y, bnCtx) &&
+                     BN_bn2binpad(x, entry, 32) == 32 && BN_bn2binpad(y, entry + 32, 32) == 32 &&
+                     EC_POINT_add(group, point, point, base, bnCtx);
+            }
+            for (int d = 0; ok && d < 4; d++) ok = EC_POINT_dbl(group, base, base, bnCtx);
+            ok = ok && EC_POINT_dbl(group, offset, offset, bnCtx);
+        }
+
+        BN_free(y);
+        BN_free(x);
+        BN_free(scalar);
+        EC_POINT_free(point);
+        EC_POINT_free(offsetSum);
+        EC_POINT_free(offset);
+        EC_POINT_free(base);
+        BN_CTX_free(bnCtx);
+        EC_GROUP_free(group);
+        if (!ok) {
+            throw std::runtime_error("Failed to build secp256k1 generator table");
+        }
+    }
+};
+
+/**
+ * The process-wide comb table, built on first use
+ */
+inline const MinimalSecp256k1Table& minimal_secp256k1_table() {
+    static const MinimalSecp256k1Table table;
+    return table;
+}
 
 /**
  * Minimal secp256k1 context structure
@@ -29,19 +117,43 @@
 struct MinimalSecp256k1Context {
     EC_GROUP* group;
     BN_CTX* bn_ctx;
-    
+    const MinimalSecp256k1Table* table;
+    // Scratch reused by every call
+    EC_POINT* acc;
+    EC_POINT* addend;
+    BIGNUM* x;
+    BIGNUM* y;
+
     MinimalSecp256k1Context() {
         group = EC_GROUP_new_by_curve_name(NID_secp256k1);
         bn_ctx = BN_CTX_new();
-        
-        if (!group || !bn_ctx) {
+        table = &minimal_secp256k1_table();
+        acc = group ? EC_POINT_new(group) : nullptr;
+        addend = group ? EC_POINT_new(group) : nullptr;
+        x = BN_new();
+        y = BN_new();
+
+        if (!group || !bn_ctx || !acc || !addend || !x || !y) {
+            release();
             throw std::runtime_error("Failed to initialize secp256k1 context");
         }
     }
-    
+
     ~MinimalSecp256k1Context() {
-        if (group) EC_GROUP_free(group);
+        release();
+    }
+
+    MinimalSecp256k1Context(const MinimalSecp256k1Context&) = delete;
+    MinimalSecp256k1Context& operator=(const MinimalSecp256k1Context&) = delete;
+
+private:
+    void release() {
+        if (y) BN_clear_free(y);
+        if (x) BN_clear_free(x);
+        if (addend) EC_POINT_clear_free(addend);
+        if (acc) EC_POINT_clear_free(acc);
         if (bn_ctx) BN_CTX_free(bn_ctx);
+        if (group) EC_GROUP_free(group);
     }
 };
 
@@ -63,137 +175,145 @@ inline void minimal_secp256k1_context_destroy(MinimalSecp256k1Context* ctx) {
     delete ctx;
 }
 
+/**
+ * Verify that a private key is valid
+ *
+ * @param private_key 32-byte private key
+ * @return true if valid, false otherwise
+ */
+inline bool minimal_secp256k1_verify_private_key(const uint8_t* private_key) {
+    // secp256k1 order: FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141
+    static const uint8_t curve_order[] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+        0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B,
+        0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41
+    };
+
+    // Nonzero and below the order (big-endian), without early exits
+    uint8_t nonzero = 0;
+    int less = 0, greater = 0;
+    for (int i = 0; i < 32; i++) {
+        nonzero |= private_key[i];
+        int lt = private_key[i] < curve_order[i];
+        int gt = private_key[i] > curve_order[i];
+        less |= lt & !greater;
+        greater |= gt & !less;
+    }
+    return nonzero != 0 && less;
+}
+
+inline bool minimal_secp256k1_verify_private_key(const std::vector<uint8_t>& private_key) {
+    return private_key.size() == 32 && minimal_secp256k1_verify_private_key(private_key.data());
+}
+
 /**
  * Generate public key from private key
- * 
+ *
  * @param ctx secp256k1 context
  * @param private_key 32-byte private key
- * @return 65-byte uncompressed public key (04 + 32 + 32)
+ * @param public_key receives the 65-byte uncompressed public key (04 + 32 + 32)
+ * @return false if the private key is zero or not below the curve order
  */
-inline std::vector<uint8_t> minimal_secp256k1_get_public_key(
-    MinimalSecp256k1Context* ctx, 
-    const std::vector<uint8_t>& private_key) {
-    
-    if (!ctx || private_key.size() != 32) {
-        throw std::runtime_error("Invalid parameters for public key generation");
+inline bool minimal_secp256k1_create_public_key(
+    MinimalSecp256k1Context* ctx,
+    const uint8_t* private_key,
+    uint8_t* public_key) {
+
+    if (!minimal_secp256k1_verify_private_key(private_key)) {
+        return false;
     }
-    
-    // Create BIGNUM from private key
-    BIGNUM* priv_bn = BN_bin2bn(private_key.data(), 32, nullptr);
-    if (!priv_bn) {
-        throw std::runtime_error("Failed to create BIGNUM from private key");
+
+    const uint8_t* entries = ctx->table->entries.data();
+    uint8_t selected[MinimalSecp256k1Table::kEntrySize];
+    bool ok = true;
+    for (int i = 0; ok && i < MinimalSecp256k1Table::kWindows; i++) {
+        // Digit i is bits 4i..4i+3 of the big-endian scalar
+        uint8_t digit = (private_key[31 - i / 2] >> (4 * (i & 1))) & 0x0F;
+        const uint8_t* row = entries + static_cast<size_t>(i) * MinimalSecp256k1Table::kDigits *
+                                           MinimalSecp256k1Table::kEntrySize;
+
+        // Read every entry of the row and keep the one for this digit
+        uint64_t words[MinimalSecp256k1Table::kEntrySize / 8] = {0};
+        for (int j = 0; j < MinimalSecp256k1Table::kDigits; j++) {
+            uint64_t mask = 0 - static_cast<uint64_t>(j == digit);
+            const uint8_t* entry = row + static_cast<size_t>(j) * MinimalSecp256k1Table::kEntrySize;
+            for (size_t w = 0; w < MinimalSecp256k1Table::kEntrySize / 8; w++) {
+                uint64_t word;
+                std::memcpy(&word, entry + 8 * w, 8);
+                words[w] |= word & mask;
+            }
+        }
+        std::memcpy(selected, words, sizeof(selected));
+        OPENSSL_cleanse(words, sizeof(words));
+
+        EC_POINT* target = i == 0 ? ctx->acc : ctx->addend;
+        ok = BN_bin2bn(selected, 32, ctx->x) && BN_bin2bn(selected + 32, 32, ctx->y) &&
+             EC_POINT_set_affine_coordinates(ctx->group, target, ctx->x, ctx->y, ctx->bn_ctx) &&
+             (i == 0 || EC_POINT_add(ctx->group, ctx->acc, ctx->acc, ctx->addend, ctx->bn_ctx));
     }
-    
-    // Create EC_POINT for public key
-    EC_POINT* pub_point = EC_POINT_new(ctx->group);
-    if (!pub_point) {
-        BN_free(priv_bn);
-        throw std::runtime_error("Failed to create EC_POINT");
+
+    ok = ok && !EC_POINT_is_at_infinity(ctx->group, ctx->acc) &&
+         EC_POINT_get_affine_coordinates(ctx->group, ctx->acc, ctx->x, ctx->y, ctx->bn_ctx);
+    if (ok) {
+        public_key[0] = 0x04;
+        ok = BN_bn2binpad(ctx->x, public_key + 1, 32) == 32 && BN_bn2binpad(ctx->y, public_key + 33, 32) == 32;
     }
-    
-    // Calculate public key: pub = priv * G
-    if (!EC_POINT_mul(ctx->group, pub_point, priv_bn, nullptr, nullptr, ctx->bn_ctx)) {
-        EC_POINT_free(pub_point);
-        BN_free(priv_bn);
+
+    OPENSSL_cleanse(selected, sizeof(selected));
+    BN_clear(ctx->x);
+    BN_clear(ctx->y);
+    if (!ok) {
         throw std::runtime_error("Failed to calculate public key");
     }
-    
-    // Convert to uncompressed format
-    size_t pub_len = EC_POINT_point2oct(ctx->group, pub_point, 
-                                       POINT_CONVERSION_UNCOMPRESSED,
-                                       nullptr, 0, ctx->bn_ctx);
-    
-    if (pub_len != 65) {
-        EC_POINT_free(pub_point);
-        BN_free(priv_bn);
-        throw std::runtime_error("Unexpected public key length");
+    return true;
+}
+
+/**
+ * Generate public key from private key
+ *
+ * @param ctx secp256k1 context
+ * @param private_key 32-byte private key
+ * @return 65-byte uncompressed public key (04 + 32 + 32)
+ */
+inline std::vector<uint8_t> minimal_secp256k1_get_public_key(
+    MinimalSecp256k1Context* ctx,
+    const std::vector<uint8_t>& private_key) {
+
+    if (!ctx || private_key.size() != 32) {
+        throw std::runtime_error("Invalid parameters for public key generation");
     }
-    
-    std::vector<uint8_t> public_key(pub_len);
-    if (!EC_POINT_point2oct(ctx->group, pub_point, 
-                           POINT_CONVERSION_UNCOMPRESSED,
-                           public_key.data(), pub_len, ctx->bn_ctx)) {
-        EC_POINT_free(pub_point);
-        BN_free(priv_bn);
-        throw std::runtime_error("Failed to serialize public key");
+
+    std::vector<uint8_t> public_key(65);
+    if (!minimal_secp256k1_create_public_key(ctx, private_key.data(), public_key.data())) {
+        throw std::runtime_error("Invalid private key");
     }
-    
-    // Cleanup
-    EC_POINT_free(pub_point);
-    BN_free(priv_bn);
-    
     return public_key;
 }
 
 /**
  * Compress a public key
- * 
+ *
  * @param uncompressed_pubkey 65-byte uncompressed public key
  * @return 33-byte compressed public key
  */
 inline std::vector<uint8_t> minimal_secp256k1_compress_public_key(
     const std::vector<uint8_t>& uncompressed_pubkey) {
-    
+
     if (uncompressed_pubkey.size() != 65 || uncompressed_pubkey[0] != 0x04) {
         throw std::runtime_error("Invalid uncompressed public key format");
     }
-    
+
     std::vector<uint8_t> compressed(33);
-    
+
     // Copy x-coordinate
-    std::copy(uncompressed_pubkey.begin() + 1, 
-              uncompressed_pubkey.begin() + 33, 
+    std::copy(uncompressed_pubkey.begin() + 1,
+              uncompressed_pubkey.begin() + 33,
               compressed.begin() + 1);
-    
+
     // Determine y-coordinate parity
     uint8_t y_last_byte = uncompressed_pubkey[64];
     compressed[0] = (y_last_byte & 1) ? 0x03 : 0x02;
-    
-    return compressed;
-}
 
-/**
- * Verify that a private key is valid
- * 
- * @param private_key 32-byte private key
- * @return true if valid, false otherwise
- */
-inline bool minimal_secp256k1_verify_private_key(const std::vector<uint8_t>& private_key) {
-    if (private_key.size() != 32) {
-        return false;
-    }
-    
-    // Check that key is not zero
-    bool all_zero = true;
-    for (uint8_t byte : private_key) {
-        if (byte != 0) {
-            all_zero = false;
-            break;
-        }
-    }
-    if (all_zero) {
-        return false;
-    }
-    
-    // Check that key is less than the curve order
-    // secp256k1 order: FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141
-    const uint8_t curve_order[] = {
-        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
-        0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B,
-        0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41
-    };
-    
-    // Simple comparison (big-endian)
-    for (int i = 0; i < 32; i++) {
-        if (private_key[i] < curve_order[i]) {
-            return true;
-        } else if (private_key[i] > curve_order[i]) {
-            return false;
-        }
-    }
-    
-    return false; // Equal to order, which is invalid
+    return compressed;
 }
-
-#endif // USE_MINIMAL_SECP256K1
\ No newline at end of file